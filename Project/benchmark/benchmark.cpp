@@ -0,0 +1,361 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "decision_problem.h"
+#include "fdistance.h"
+#include "ged.h"
+#include "polygonal_curve.h"
+#include "workspace.h"
+
+using namespace std;
+
+// Allocation counter. Every replaceable operator new of the process
+// allocates through countedAllocate() and every operator delete releases
+// through release(), so all forms (array, sized, aligned, nothrow) match.
+static atomic<unsigned long long> allocationCount(0);
+
+static void* countedAllocate(size_t size, size_t alignment) noexcept {
+  allocationCount.fetch_add(1, memory_order_relaxed);
+  if (size == 0) size = 1;
+  if (alignment <= alignof(max_align_t)) return malloc(size);
+  // aligned_alloc needs a multiple of the alignment
+  return aligned_alloc(alignment,
+                       (size + alignment - 1) / alignment * alignment);
+}
+
+static void* countedNew(size_t size, size_t alignment) {
+  if (void* ptr = countedAllocate(size, alignment)) return ptr;
+  throw bad_alloc();
+}
+
+static void release(void* ptr) noexcept { free(ptr); }
+
+void* operator new(size_t size) { return countedNew(size, 0); }
+void* operator new[](size_t size) { return countedNew(size, 0); }
+void* operator new(size_t size, align_val_t alignment) {
+  return countedNew(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment) {
+  return countedNew(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, const nothrow_t&) noexcept {
+  return countedAllocate(size, 0);
+}
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+  return countedAllocate(size, 0);
+}
+void* operator new(size_t size, align_val_t alignment,
+                   const nothrow_t&) noexcept {
+  return countedAllocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, align_val_t alignment,
+                     const nothrow_t&) noexcept {
+  return countedAllocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, align_val_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, align_val_t) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t, align_val_t) noexcept {
+  release(ptr);
+}
+void operator delete[](void* ptr, size_t, align_val_t) noexcept {
+  release(ptr);
+}
+void operator delete(void* ptr, const nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const nothrow_t&) noexcept { release(ptr); }
+void operator delete(void* ptr, align_val_t, const nothrow_t&) noexcept {
+  release(ptr);
+}
+void operator delete[](void* ptr, align_val_t, const nothrow_t&) noexcept {
+  release(ptr);
+}
+
+// Benchmark settings
+struct BenchmarkConfig {
+  size_t maxFDSize = 128;      // Largest curve size for FD and decision
+  size_t maxGEDSize = 2048;    // Largest curve size for GED and SED
+  int repetitions = 3;         // Pairs per (engine, family, size)
+  unsigned maxThreads = 0;     // Largest thread count (0: hardware)
+  unsigned seed = 20240601;    // Seed of all generators
+  double epsilon = 1.0;        // Fixed epsilon of the decision problem
+};
+
+// Random walk with unit normal steps
+vector<Point_2> generateRandomWalk(size_t numPoints, mt19937& gen) {
+  normal_distribution<> step(0.0, 1.0);
+  vector<Point_2> points;
+  double x = 0.0, y = 0.0;
+  for (size_t i = 0; i < numPoints; ++i) {
+    points.emplace_back(x, y);
+    x += step(gen);
+    y += step(gen);
+  }
+  return points;
+}
+
+// GPS-like smooth curve: constant speed, slowly turning heading and noise
+vector<Point_2> generateGPSLike(size_t numPoints, mt19937& gen) {
+  normal_distribution<> turn(0.0, 0.05);
+  normal_distribution<> noise(0.0, 0.02);
+  vector<Point_2> points;
+  double x = 0.0, y = 0.0, heading = 0.0;
+  for (size_t i = 0; i < numPoints; ++i) {
+    points.emplace_back(x + noise(gen), y + noise(gen));
+    heading += turn(gen);
+    x += cos(heading);
+    y += sin(heading);
+  }
+  return points;
+}
+
+// Adversarial zigzag like Test Case 4 of main.cpp
+vector<Point_2> generateZigzag(size_t numPoints, double offset,
+                               double amplitude) {
+  vector<Point_2> points;
+  for (size_t i = 0; i < numPoints; ++i) {
+    double y = (i % 2 == 0) ? offset : offset + amplitude;
+    points.emplace_back(static_cast<double>(i), y);
+  }
+  return points;
+}
+
+// Generates the pair of curves of a family
+pair<PolygonalCurve, PolygonalCurve> generatePair(const string& family,
+                                                  size_t numPoints,
+                                                  mt19937& gen) {
+  if (family == "random_walk") {
+    return {PolygonalCurve(generateRandomWalk(numPoints, gen)),
+            PolygonalCurve(generateRandomWalk(numPoints, gen))};
+  }
+  if (family == "gps_like") {
+    return {PolygonalCurve(generateGPSLike(numPoints, gen)),
+            PolygonalCurve(generateGPSLike(numPoints, gen))};
+  }
+  return {PolygonalCurve(generateZigzag(numPoints, 0.0, 2.0)),
+          PolygonalCurve(generateZigzag(numPoints, 1.0, -2.0))};
+}
+
+// Peak resident set size of the process in MiB. ru_maxrss never decreases,
+// so runSizeSweep() measures every case in its own child process.
+double peakRSSMiB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KiB on Linux
+}
+
+// Runs one engine on a pair
+typedef function<double(const PolygonalCurve&, const PolygonalCurve&)> Engine;
+
+// Measures one (engine, family, size) case and prints its row
+void runCase(const string& name, const Engine& engine, const string& family,
+             size_t n, const BenchmarkConfig& config) {
+  mt19937 gen(config.seed + static_cast<unsigned>(n));
+  vector<pair<PolygonalCurve, PolygonalCurve>> pairs;
+  for (int r = 0; r < config.repetitions; ++r) {
+    pairs.push_back(generatePair(family, n, gen));
+  }
+
+  // Warm-up pass: grows the Workspace buffers of the *_workspace engines to
+  // their final capacity, so the measured pass shows the steady state
+  for (const auto& curves : pairs) engine(curves.first, curves.second);
+
+  unsigned long long allocationsBefore = allocationCount.load();
+  auto start = chrono::steady_clock::now();
+  double checksum = 0.0;
+  for (const auto& curves : pairs) {
+    checksum += engine(curves.first, curves.second);
+  }
+  double seconds =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  unsigned long long allocations = allocationCount.load() - allocationsBefore;
+
+  cout << name << "," << family << "," << n << "," << fixed
+       << setprecision(3) << seconds * 1e3 / pairs.size() << ","
+       << allocations / pairs.size() << "," << peakRSSMiB() << ","
+       << setprecision(6) << checksum / pairs.size() << '\n';
+  cout.unsetf(ios::floatfield);
+}
+
+// Measures time per pair and allocations per pair of one engine. Every case
+// runs in a child process, so peak_rss_mib is the peak of that case alone
+// and not of the largest case so far.
+void runSizeSweep(const string& name, const Engine& engine, size_t maxSize,
+                  const BenchmarkConfig& config) {
+  const vector<string> families = {"random_walk", "gps_like", "zigzag"};
+  for (const auto& family : families) {
+    for (size_t n = 4; n <= maxSize; n *= 2) {
+      cout.flush();  // The child must not repeat buffered rows
+      pid_t child = fork();
+      if (child < 0) {
+        cerr << "fork failed: " << strerror(errno) << endl;
+        exit(1);
+      }
+      if (child == 0) {
+        runCase(name, engine, family, n, config);
+        cout.flush();
+        _exit(0);
+      }
+      int status = 0;
+      if (waitpid(child, &status, 0) < 0 || !WIFEXITED(status) ||
+          WEXITSTATUS(status) != 0) {
+        cerr << "Case " << name << "," << family << "," << n << " failed"
+             << endl;
+        exit(1);
+      }
+    }
+  }
+}
+
+// Measures pairs per second of one engine for increasing thread counts
+void runThreadScaling(const string& name, const Engine& engine, size_t size,
+                      const BenchmarkConfig& config) {
+  unsigned maxThreads = config.maxThreads;
+  if (maxThreads == 0) maxThreads = max(1u, thread::hardware_concurrency());
+
+  // Every thread count processes the same pairs
+  mt19937 gen(config.seed);
+  size_t numPairs = 4 * maxThreads;
+  vector<pair<PolygonalCurve, PolygonalCurve>> pairs;
+  for (size_t i = 0; i < numPairs; ++i) {
+    pairs.push_back(generatePair("random_walk", size, gen));
+  }
+
+  double baseline = 0.0;
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    atomic<size_t> next(0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+      workers.emplace_back([&]() {
+        for (size_t i = next++; i < pairs.size(); i = next++) {
+          engine(pairs[i].first, pairs[i].second);
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+    double seconds =
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double throughput = pairs.size() / seconds;
+    if (threads == 1) baseline = throughput;
+
+    cout << name << "," << size << "," << threads << "," << fixed
+         << setprecision(1) << throughput << "," << setprecision(2)
+         << throughput / baseline << '\n';
+    cout.unsetf(ios::floatfield);
+  }
+}
+
+// Parses the command line arguments
+BenchmarkConfig parseArguments(int argc, char** argv) {
+  BenchmarkConfig config;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--max-fd-size") == 0) {
+      config.maxFDSize = strtoul(argv[i + 1], nullptr, 10);
+    } else if (strcmp(argv[i], "--max-ged-size") == 0) {
+      config.maxGEDSize = strtoul(argv[i + 1], nullptr, 10);
+    } else if (strcmp(argv[i], "--repetitions") == 0) {
+      config.repetitions = atoi(argv[i + 1]);
+    } else if (strcmp(argv[i], "--threads") == 0) {
+      config.maxThreads = strtoul(argv[i + 1], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      config.seed = strtoul(argv[i + 1], nullptr, 10);
+    } else if (strcmp(argv[i], "--epsilon") == 0) {
+      config.epsilon = atof(argv[i + 1]);
+    } else {
+      cerr << "Unknown option " << argv[i] << endl;
+      exit(1);
+    }
+  }
+  return config;
+}
+
+int main(int argc, char** argv) {
+  BenchmarkConfig config = parseArguments(argc, argv);
+
+  // Engines under measurement
+  Engine frechet = [](const PolygonalCurve& P, const PolygonalCurve& Q) {
+    return FDistance(P, Q).getFDistance();
+  };
+  Engine decision = [&config](const PolygonalCurve& P,
+                              const PolygonalCurve& Q) {
+    return DecisionProblem(P, Q, config.epsilon).doesMonotoneCurveExist()
+               ? 1.0
+               : 0.0;
+  };
+  // The same engines with a Workspace that is reused across pairs. After the
+  // warm-up pass they run without heap allocations.
+  Workspace workspace(config.seed);
+  Engine frechetWorkspace = [&workspace](const PolygonalCurve& P,
+                                         const PolygonalCurve& Q) {
+    return FDistance(P, Q, &workspace).getFDistance();
+  };
+  Engine decisionWorkspace = [&config, &workspace](const PolygonalCurve& P,
+                                                   const PolygonalCurve& Q) {
+    return DecisionProblem(P, Q, config.epsilon, &workspace)
+                   .doesMonotoneCurveExist()
+               ? 1.0
+               : 0.0;
+  };
+  Engine gedWorkspace = [&workspace](const PolygonalCurve& P,
+                                     const PolygonalCurve& Q) {
+    return GED::computeSquareRootApproxGED(P, Q, nullptr, &workspace);
+  };
+
+  // GED and SED draw their grid shifts from config.seed, so every run
+  // measures the same work and reports the same mean_result
+  Engine ged = [&config](const PolygonalCurve& P, const PolygonalCurve& Q) {
+    Workspace workspace(config.seed);
+    return GED::computeSquareRootApproxGED(P, Q, nullptr, &workspace);
+  };
+  Engine sed = [&config](const PolygonalCurve& P, const PolygonalCurve& Q) {
+    mt19937 generator(config.seed);
+    CurveStringPair strings =
+        GED::transformCurvesToStrings(P, Q, 1, &generator);
+    size_t n = min(P.numPoints(), Q.numPoints());
+    return static_cast<double>(
+        GED::SED(strings.first, strings.second, 12 * sqrt(n) + 2).size());
+  };
+
+  // Step 1: Size sweep
+  cout << "engine,family,size,ms_per_pair,allocs_per_pair,peak_rss_mib,"
+          "mean_result"
+       << '\n';
+  runSizeSweep("FDistance", frechet, config.maxFDSize, config);
+  runSizeSweep("DecisionProblem", decision, config.maxFDSize, config);
+  runSizeSweep("FDistance_workspace", frechetWorkspace, config.maxFDSize,
+               config);
+  runSizeSweep("DecisionProblem_workspace", decisionWorkspace,
+               config.maxFDSize, config);
+  runSizeSweep("GED", ged, config.maxGEDSize, config);
+  runSizeSweep("GED_workspace", gedWorkspace, config.maxGEDSize, config);
+  runSizeSweep("SED", sed, config.maxGEDSize, config);
+
+  // Step 2: Thread scaling
+  cout << "\nengine,size,threads,pairs_per_second,speedup" << '\n';
+  runThreadScaling("FDistance", frechet, config.maxFDSize / 2, config);
+  runThreadScaling("DecisionProblem", decision, config.maxFDSize, config);
+  runThreadScaling("GED", ged, config.maxGEDSize / 2, config);
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ANYTIME_H
+#define ANYTIME_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+// Why an anytime computation returned
+enum class AnytimeStatus {
+  Complete,         // The computation finished
+  Cancelled,        // CancellationToken::cancel() was called
+  DeadlineExceeded  // The deadline passed
+};
+
+// Cooperative stop request for long computations. Copies share the state,
+// so a caller keeps one copy to cancel while the computation polls another.
+// The engines poll between steps (decisions, grid-level trials, rows of Type
+// C values), so a stop takes effect within one step.
+class CancellationToken {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Constructor for a token without deadline
+  CancellationToken();
+
+  // Constructor for a token that stops at the deadline
+  explicit CancellationToken(Clock::time_point deadline);
+
+  // Constructor for a token that stops after a duration from now
+  template <typename Rep, typename Period>
+  static CancellationToken after(std::chrono::duration<Rep, Period> timeout) {
+    return CancellationToken(
+        Clock::now() +
+        std::chrono::duration_cast<Clock::duration>(timeout));
+  }
+
+  // Requests the stop (thread-safe)
+  void cancel() const;
+
+  // True if cancelled or past the deadline
+  bool stopRequested() const;
+
+  // Reason of the stop (Complete if no stop was requested)
+  AnytimeStatus stopReason() const;
+
+ private:
+  struct State {
+    std::atomic<bool> cancelled{false};
+    std::int64_t deadline;  // Clock ticks (INT64_MAX: none)
+  };
+  std::shared_ptr<State> state;
+};
+
+// Result of an anytime computation. A complete computation has
+// lower == upper == value for exact distances; an interrupted one returns the
+// bracket reached so far and the best feasible value in it (value == upper).
+struct AnytimeResult {
+  double value;          // Distance (or best feasible value so far)
+  double lower;          // Lower bound of the distance
+  double upper;          // Upper bound of the distance
+  AnytimeStatus status;  // Complete, or why the computation stopped
+};
+
+#endif  // ANYTIME_H
@@ -0,0 +1,81 @@
+#ifndef ASYNC_DISTANCE_H
+#define ASYNC_DISTANCE_H
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "anytime.h"
+#include "free_space.h"
+#include "polygonal_curve.h"
+#include "thread_pool.h"
+
+class Workspace;
+
+// Runs distance queries on a shared pool of workers. Each query returns a
+// future at once and polls its CancellationToken between steps, so a
+// cancelled or expired query resolves with the bracket reached so far (see
+// AnytimeResult) instead of blocking its caller. Queries are independent
+// and many can be in flight; the workers reuse a set of workspaces. The
+// curves are copied into the query (borrowed curves stay borrowed, so their
+// columns must outlive the query).
+//
+// The polls are between steps, not inside them. The longest unpolled step
+// of an FD query is the sort of the critical values, O(m log m) for the
+// m = O(p^2 q + p q^2) values of Type C; a stop that arrives during the sort
+// takes effect when it ends.
+class AsyncDistanceExecutor {
+ public:
+  // Constructor to start the workers (0: hardware concurrency)
+  explicit AsyncDistanceExecutor(std::size_t numThreads = 0);
+
+  // Destructor (finishes the queued queries; cancel them to return early)
+  ~AsyncDistanceExecutor();
+
+  AsyncDistanceExecutor(const AsyncDistanceExecutor&) = delete;
+  AsyncDistanceExecutor& operator=(const AsyncDistanceExecutor&) = delete;
+
+  // Queues a Frechet distance query (FDistance)
+  std::future<AnytimeResult> submitFD(
+      const PolygonalCurve& P, const PolygonalCurve& Q,
+      CancellationToken cancel = CancellationToken(),
+      FreeSpaceMode mode = FreeSpaceMode::Dense);
+
+  // Queues a GED query (GED::computeAnytimeApproxGED)
+  std::future<AnytimeResult> submitGED(
+      const PolygonalCurve& P, const PolygonalCurve& Q,
+      CancellationToken cancel = CancellationToken());
+
+  // Getter
+  std::size_t numThreads() const;
+
+ private:
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Workspace>> idleWorkspaces;
+  ThreadPool pool;  // Last, so the workers stop before the workspaces go
+
+  // Idle workspace held by one query and returned when the lease ends, also
+  // if the query throws
+  class WorkspaceLease {
+   public:
+    explicit WorkspaceLease(AsyncDistanceExecutor& executor);
+    ~WorkspaceLease();
+
+    WorkspaceLease(const WorkspaceLease&) = delete;
+    WorkspaceLease& operator=(const WorkspaceLease&) = delete;
+
+    Workspace* get() const;
+
+   private:
+    AsyncDistanceExecutor& executor;
+    std::unique_ptr<Workspace> workspace;
+  };
+
+  // Takes an idle workspace (or a new one) and returns it after a query
+  std::unique_ptr<Workspace> acquireWorkspace();
+  void releaseWorkspace(std::unique_ptr<Workspace> workspace);
+};
+
+#endif  // ASYNC_DISTANCE_H
@@ -0,0 +1,81 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "free_space.h"
+
+class DistanceCache;
+class MappedCurveFile;
+class Workspace;
+struct DistanceCacheStats;
+
+// Distance computed for every pair
+enum class BatchMetric {
+  FrechetDistance,      // FDistance
+  WeakFrechetDistance,  // WeakFDistance
+  HausdorffDistance,    // HausdorffDistance
+  DTW,                  // DTW::computeDTW
+  GED,                  // GED::computeSquareRootApproxGED
+  Threshold             // DecisionProblem at a fixed epsilon (1 or 0)
+};
+
+// Output encoding
+enum class BatchFormat {
+  CSV,    // "id_P,id_Q,value" lines
+  Binary  // BatchRecord structs
+};
+
+// Binary output record
+struct BatchRecord {
+  std::uint64_t idP;
+  std::uint64_t idQ;
+  double value;
+};
+
+// Options of a batch run
+struct BatchOptions {
+  std::string storePath;   // Curve file (see curve_file.h)
+  std::string pairsPath;   // Pair list ("id_P id_Q" lines, or binary
+                           // uint64 pairs if the name ends with ".bin")
+  std::string outputPath;  // Output file
+  BatchMetric metric = BatchMetric::FrechetDistance;
+  BatchFormat format = BatchFormat::CSV;
+  double epsilon = 0.0;            // Epsilon of BatchMetric::Threshold
+  FreeSpaceMode freeSpaceMode = FreeSpaceMode::Dense;  // FD and Threshold
+  int window = -1;                 // Band of BatchMetric::DTW (-1: none)
+  std::size_t numThreads = 0;      // Worker threads (0: hardware)
+  std::size_t chunkSize = 4096;    // Pairs per work item
+  std::size_t queueCapacity = 64;  // Chunks buffered between the stages
+  std::string cachePath;  // Distance cache of FD and GED (empty: none)
+};
+
+// Streams a pair list through load -> compute -> write. A reader thread
+// parses the pairs into chunks, a thread pool computes the chunks, and a
+// writer thread restores the input order and writes through a large buffer.
+// The stages are connected by bounded queues, so memory stays constant for
+// any number of pairs. Returns the number of pairs processed. With a
+// cachePath the FD and GED values go through a DistanceCache, whose
+// counters are returned in cacheStats.
+std::size_t runBatch(const BatchOptions& options,
+                     DistanceCacheStats* cacheStats = nullptr);
+
+// Computes options.metric for curves idP and idQ of a curve file with the
+// buffers of a workspace (one workspace per thread). FD and GED values are
+// looked up in and added to the cache, if one is given.
+double computeBatchMetric(const MappedCurveFile& store,
+                          const BatchOptions& options, std::uint64_t idP,
+                          std::uint64_t idQ, Workspace& workspace,
+                          DistanceCache* cache = nullptr);
+
+// Parse the names of the command line (throw std::invalid_argument)
+BatchMetric parseBatchMetric(const std::string& value);
+FreeSpaceMode parseFreeSpaceMode(const std::string& value);
+
+// Parses "batch" command line arguments into options (throws
+// std::invalid_argument on errors)
+BatchOptions parseBatchArguments(int argc, char** argv);
+
+#endif  // BATCH_DRIVER_H
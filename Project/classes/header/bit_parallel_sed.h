@@ -0,0 +1,77 @@
+#ifndef BIT_PARALLEL_SED_H
+#define BIT_PARALLEL_SED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ged.h"
+
+// Bit-parallel (Allison-Dix/Hyyro) SED backend. The SED used by GED only
+// allows insertions and deletions, so it equals n + m - 2 * LCS(S, T) and the
+// LCS is computed 64 DP cells per machine word. The query S is mapped to
+// per-symbol match bitmasks once, and any number of candidates T can then be
+// streamed against it.
+class BitParallelSED {
+ public:
+  // Largest query (in 64-bit words) handled by this backend
+  static const std::size_t kMaxWords = 4;
+
+  // Returns true if a query of the given length fits in kMaxWords words
+  static bool fitsQuery(std::size_t length);
+
+  // Constructor to create an empty query (see reset)
+  BitParallelSED();
+
+  // Constructor to build the match bitmasks of the query S
+  explicit BitParallelSED(const CurveString& S);
+
+  // Rebuilds the match bitmasks for a new query, reusing the buffers
+  void reset(const CurveString& S);
+
+  // Getter
+  std::size_t queryLength() const;
+
+  // Computes the SED between the query and T
+  int distance(const CurveString& T) const;
+
+  // Checks if the SED between the query and T is at most k (early abandoning)
+  bool isWithin(const CurveString& T, int k) const;
+
+  // Computes the matching of SED(S, T) if it is within the threshold, and an
+  // empty matching otherwise (same contract as GED::SED)
+  Matching match(const CurveString& T, double threshold,
+                 GEDStats* stats = nullptr) const;
+
+  // Same as match(), but writes the matching into a caller-owned buffer and
+  // uses columns as scratch. Returns false if the SED exceeds the threshold.
+  bool matchInto(const CurveString& T, double threshold, Matching& matching,
+                 std::vector<std::uint64_t>& columns,
+                 GEDStats* stats = nullptr) const;
+
+  // Computes match() for every candidate
+  std::vector<Matching> matchAll(const std::vector<CurveString>& candidates,
+                                 double threshold) const;
+
+ private:
+  CurveString S;           // Query string
+  std::size_t words;       // Number of 64-bit words of a DP column
+  std::uint64_t lastMask;  // Valid bits of the last word
+
+  // Open-addressing table from symbols to match bitmasks. Bit i of the mask
+  // of symbol a is set iff S[i] == a.
+  std::vector<CurveAlphabet> slotSymbols;
+  std::vector<char> slotUsed;
+  std::vector<std::uint64_t> slotMasks;  // words masks per slot
+
+  // Returns the mask of a symbol, or null if it does not occur in S
+  const std::uint64_t* findMask(const CurveAlphabet& a) const;
+
+  // Runs the column recurrence over T. Returns false as soon as the SED is
+  // proven to exceed k. If columns is not null, every column is stored.
+  bool run(const CurveString& T, int k, int& lcs,
+           std::vector<std::uint64_t>* columns,
+           GEDStats* stats = nullptr) const;
+};
+
+#endif  // BIT_PARALLEL_SED_H
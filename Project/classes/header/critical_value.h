@@ -5,40 +5,79 @@
 
 #include <vector>
 
+#include "anytime.h"
 #include "polygonal_curve.h"
+#include "stats.h"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
 typedef Kernel::Point_2 Point_2;
 
+class Workspace;
+
+// Candidate values of the Frechet distance. The curves are referenced and
+// must outlive the object. If a workspace is given, the values are stored in
+// its buffers.
 class CriticalValue {
  public:
-  // Constructor to initialize the polygonal curves P and Q
-  CriticalValue(const PolygonalCurve& P, const PolygonalCurve& Q);
+  // Constructor to initialize the polygonal curves P and Q. Type C values
+  // (O(p^2 q + q^2 p)) are skipped if includeTypeC is false. If cancel is
+  // given, Type C stops once a stop is requested and the values stay empty
+  // (see wasInterrupted()).
+  CriticalValue(const PolygonalCurve& P, const PolygonalCurve& Q,
+                Workspace* workspace = nullptr, bool includeTypeC = true,
+                const CancellationToken* cancel = nullptr);
+
+  // The curves are referenced, so temporaries would dangle
+  CriticalValue(PolygonalCurve&&, const PolygonalCurve&, Workspace* = nullptr,
+                bool = true, const CancellationToken* = nullptr) = delete;
+  CriticalValue(const PolygonalCurve&, PolygonalCurve&&, Workspace* = nullptr,
+                bool = true, const CancellationToken* = nullptr) = delete;
+  CriticalValue(PolygonalCurve&&, PolygonalCurve&&, Workspace* = nullptr,
+                bool = true, const CancellationToken* = nullptr) = delete;
 
   // Destructor
   ~CriticalValue();
 
+  CriticalValue(const CriticalValue&) = delete;
+  CriticalValue& operator=(const CriticalValue&) = delete;
+
   // Functions to compute the distances for each type
   void computeTypeA();
   void computeTypeB();
   void computeTypeC();
   void computeAndSortAllTypes();
 
-  // Getters for the computed values
+  // Getters for the computed values. Type B values are ordered as the
+  // boundaries B[j*p+i] by (i, j), followed by the boundaries L[j*q+i] by
+  // (i, j).
   const std::vector<double>& getTypeAValues() const;
   const std::vector<double>& getTypeBValues() const;
   const std::vector<double>& getTypeCValues() const;
   const std::vector<double>& getCriticalValues() const;
+  const CriticalValueStats& getStats() const;
+  // True if a stop request left the values incomplete
+  bool wasInterrupted() const;
 
  private:
-  PolygonalCurve P;  // Polygonal curve P
-  PolygonalCurve Q;  // Polygonal curve Q
+  // Storage of the values without a workspace
+  std::vector<double> ownTypeAValues;
+  std::vector<double> ownTypeBValues;
+  std::vector<double> ownTypeCValues;
+  std::vector<double> ownCriticalValues;
+
+  const PolygonalCurve& P;          // Polygonal curve P
+  const PolygonalCurve& Q;          // Polygonal curve Q
+  bool includeTypeC;                // False if only Types A and B are computed
+  const CancellationToken* cancel;  // Stop request (may be null)
+  bool interrupted;                 // True if cancel stopped Type C
 
   // Vectors to store each type of distance
-  std::vector<double> typeAValues;
-  std::vector<double> typeBValues;
-  std::vector<double> typeCValues;
-  std::vector<double> critical_values;
+  std::vector<double>& typeAValues;
+  std::vector<double>& typeBValues;
+  std::vector<double>& typeCValues;
+  std::vector<double>& critical_values;
+
+  CriticalValueStats stats;  // Counters (filled only with ENABLE_STATS)
 
   // Helper functions for repeated calculations
   double distance(const Point_2& p1, const Point_2& p2) const;
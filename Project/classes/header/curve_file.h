@@ -0,0 +1,133 @@
+#ifndef CURVE_FILE_H
+#define CURVE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "curve_summary.h"
+#include "curve_view.h"
+#include "polygonal_curve.h"
+
+// Binary columnar curve file. All integers are little-endian and every
+// section starts at a multiple of kCurveFileAlignment bytes:
+//
+//   CurveFileHeader
+//   double   x[numPoints]          x coordinates of all curves
+//   double   y[numPoints]          y coordinates of all curves
+//   uint64_t offsets[numCurves+1]  curve i is points [offsets[i], offsets[i+1])
+//   CurveSummary summaries[numCurves]  if flags has kCurveFileHasSummaries
+struct CurveFileHeader {
+  char magic[8];                  // "PSCURVE1"
+  std::uint32_t version;          // Format version (kCurveFileVersion)
+  std::uint32_t flags;            // kCurveFileHas* bits
+  std::uint64_t numCurves;        // Number of curves
+  std::uint64_t numPoints;        // Total number of points
+  std::uint64_t xOffset;          // Byte offset of x[]
+  std::uint64_t yOffset;          // Byte offset of y[]
+  std::uint64_t offsetsOffset;    // Byte offset of offsets[]
+  std::uint64_t summariesOffset;  // Byte offset of summaries[] (or 0)
+  std::uint64_t reserved[8];      // Reserved, 0
+};
+
+const std::uint32_t kCurveFileVersion = 1;
+const std::size_t kCurveFileAlignment = 64;
+const std::uint32_t kCurveFileHasSummaries = 1;
+
+// Streams curves into a curve file. The x column is written in place while the
+// y column, the offsets and the summaries are spooled to temporary files next
+// to the output and appended by close().
+class CurveFileWriter {
+ public:
+  // Constructor to open the output file
+  explicit CurveFileWriter(const std::string& path);
+
+  // Destructor (closes the file if close() was not called)
+  ~CurveFileWriter();
+
+  CurveFileWriter(const CurveFileWriter&) = delete;
+  CurveFileWriter& operator=(const CurveFileWriter&) = delete;
+
+  // Methods to append a curve
+  void addCurve(const std::vector<Point_2>& points);
+  void addCurve(const PolygonalCurve& curve);
+  void addCurve(const CurveView& curve);
+  void addCurve(const CurveView& curve, const CurveSummary& summary);
+
+  // Finishes the file (appends y[], offsets[] and summaries[] and writes the
+  // header)
+  void close();
+
+ private:
+  std::string path;
+  std::ofstream out;           // Output file (header and x[])
+  std::ofstream yOut;          // Temporary file for y[]
+  std::ofstream offsetsOut;    // Temporary file for offsets[]
+  std::ofstream summariesOut;  // Temporary file for summaries[]
+  CurveSummary summary;        // Summary of the current curve
+  std::uint64_t numCurves;
+  std::uint64_t numPoints;
+  bool closed;
+
+  void addPoint(double x, double y);
+  void endCurve();
+};
+
+// Read-only memory-mapped curve file. getCurve() returns views into the
+// mapping, so opening a file costs no parsing or copying and the data is paged
+// in on demand.
+class MappedCurveFile {
+ public:
+  // Constructor to map the file (throws std::runtime_error if invalid)
+  explicit MappedCurveFile(const std::string& path);
+
+  // Destructor (unmaps the file)
+  ~MappedCurveFile();
+
+  MappedCurveFile(const MappedCurveFile&) = delete;
+  MappedCurveFile& operator=(const MappedCurveFile&) = delete;
+
+  // Getter
+  std::size_t numCurves() const;
+  std::size_t numPoints() const;
+  std::size_t curveSize(std::size_t id) const;
+  CurveView getCurve(std::size_t id) const;
+  bool hasSummaries() const;
+  const double* xColumn() const;
+  const double* yColumn() const;
+  const std::uint64_t* offsets() const;
+
+  // Summary of a curve (read from the file, or computed if the file has no
+  // summaries)
+  CurveSummary getSummary(std::size_t id) const;
+
+  // Handle of a curve that borrows the mapping (with the stored summary)
+  PolygonalCurve borrowCurve(std::size_t id) const;
+
+  // Copies a curve into a PolygonalCurve for the engines
+  PolygonalCurve toPolygonalCurve(std::size_t id) const;
+
+ private:
+  void* data;        // Mapping
+  std::size_t size;  // Size of the mapping in bytes
+  const CurveFileHeader* header;
+  const double* x;
+  const double* y;
+  const std::uint64_t* curveOffsets;
+  const CurveSummary* summaries;  // nullptr if the file has none
+};
+
+// Converts a CSV file with lines "curve_id,x,y" into a curve file. Points of
+// one curve must be consecutive; a new curve starts when curve_id changes.
+// Returns the number of curves written.
+std::size_t convertCSVToCurveFile(const std::string& csvPath,
+                                  const std::string& outputPath);
+
+// Converts a file with one WKT LINESTRING per line into a curve file.
+// Returns the number of curves written.
+std::size_t convertWKTToCurveFile(const std::string& wktPath,
+                                  const std::string& outputPath);
+
+#endif  // CURVE_FILE_H
@@ -0,0 +1,83 @@
+#ifndef CURVE_STORE_H
+#define CURVE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "curve_summary.h"
+#include "curve_view.h"
+#include "polygonal_curve.h"
+#include "simplification_pyramid.h"
+
+// In-memory collection of curves packed into one structure of arrays: the
+// x and y coordinates of all curves in two columns and an offsets array
+// (curve i is points [offsets[i], offsets[i + 1])), the layout of a curve
+// file (see curve_file.h). A million curves take three allocations instead
+// of a million, and scans over the collection read the columns linearly.
+//
+// getCurve() returns a PolygonalCurve that borrows the columns, so FDistance,
+// GED and the other engines run on stored curves without copying them. Adding
+// curves may move the columns and invalidates the handles; call reserve()
+// first when handles are taken while the store grows.
+//
+// The CurveSummary of every curve is computed when the curve is added and is
+// saved with the curves. Simplification pyramids are built on request by
+// buildPyramids() and kept up to date for curves added afterwards.
+class CurveStore {
+ public:
+  // Constructor to create an empty store
+  CurveStore();
+
+  // Reserves space for curves and points
+  void reserve(std::size_t numCurves, std::size_t numPoints);
+
+  // Methods to append a curve (return its id)
+  std::size_t addCurve(const std::vector<Point_2>& points);
+  std::size_t addCurve(const PolygonalCurve& curve);
+  std::size_t addCurve(const CurveView& curve);
+
+  // Getter
+  std::size_t numCurves() const;
+  std::size_t numPoints() const;
+  std::size_t curveSize(std::size_t id) const;
+  CurveView getView(std::size_t id) const;
+  const CurveSummary& getSummary(std::size_t id) const;
+  const double* xColumn() const;
+  const double* yColumn() const;
+  const std::uint64_t* offsets() const;
+
+  // Handle of a curve that borrows the columns of the store
+  PolygonalCurve getCurve(std::size_t id) const;
+
+  // Builds the simplification pyramids of all curves
+  void buildPyramids();
+
+  // Checks if the pyramids are built
+  bool hasPyramids() const;
+
+  // Getter for the pyramid of a curve (throws std::logic_error if the
+  // pyramids are not built)
+  const SimplificationPyramid& getPyramid(std::size_t id) const;
+
+  // Removes all curves and pyramids (keeps the capacity)
+  void clear();
+
+  // Writes the store as a curve file
+  void save(const std::string& path) const;
+
+  // Reads a curve file into a store (computes the summaries if the file has
+  // none)
+  static CurveStore load(const std::string& path);
+
+ private:
+  std::vector<double> x;                        // x of all curves
+  std::vector<double> y;                        // y of all curves
+  std::vector<std::uint64_t> curveOffsets;      // numCurves + 1 offsets
+  std::vector<CurveSummary> summaries;          // Summary per curve
+  std::vector<SimplificationPyramid> pyramids;  // Pyramid per curve
+  bool pyramidsBuilt;                           // Whether pyramids is filled
+};
+
+#endif  // CURVE_STORE_H
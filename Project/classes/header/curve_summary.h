@@ -0,0 +1,51 @@
+#ifndef CURVE_SUMMARY_H
+#define CURVE_SUMMARY_H
+
+#include <cstdint>
+#include <limits>
+
+#include "curve_view.h"
+
+// Summary of a curve for O(1) filters: number of points, bounding box, end
+// points and length. It is computed in one pass over the points and updated
+// in O(1) for every appended point. The layout is fixed (one uint64 and nine
+// doubles) because curve files store the summaries as an array.
+struct CurveSummary {
+  std::uint64_t numPoints = 0;
+  double minX = std::numeric_limits<double>::infinity();
+  double minY = std::numeric_limits<double>::infinity();
+  double maxX = -std::numeric_limits<double>::infinity();
+  double maxY = -std::numeric_limits<double>::infinity();
+  double startX = 0.0;
+  double startY = 0.0;
+  double endX = 0.0;
+  double endY = 0.0;
+  double length = 0.0;  // Sum of the edge lengths
+
+  CurveSummary() {}
+
+  // Constructor to summarize the points of a curve view
+  explicit CurveSummary(const CurveView& curve);
+
+  // Method to account for a point appended to the curve
+  void addPoint(double x, double y);
+};
+
+static_assert(sizeof(CurveSummary) == 80, "CurveSummary is stored in files");
+
+// Lower bound of the Hausdorff distance (and of the weak and the ordinary
+// Frechet distance) from the bounding boxes: every side of one box lies within
+// the distance of the same side of the other box
+double hausdorffLowerBound(const CurveSummary& a, const CurveSummary& b);
+
+// Lower bound of the weak and the ordinary Frechet distance: the larger of
+// the end point distances (the Type A critical values) and
+// hausdorffLowerBound()
+double frechetLowerBound(const CurveSummary& a, const CurveSummary& b);
+
+// Upper bound of the Frechet distance (and of the weak Frechet and the
+// Hausdorff distance): the largest distance between a point of one bounding
+// box and a point of the other, which bounds every matched pair
+double frechetUpperBound(const CurveSummary& a, const CurveSummary& b);
+
+#endif  // CURVE_SUMMARY_H
@@ -0,0 +1,32 @@
+#ifndef CURVE_VIEW_H
+#define CURVE_VIEW_H
+
+#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+
+#include <cstddef>
+
+typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
+typedef Kernel::Point_2 Point_2;
+
+// Non-owning view of a curve stored as separate x[] and y[] columns (for
+// example inside a memory-mapped curve file). The columns must outlive the
+// view.
+struct CurveView {
+  const double* x = nullptr;  // x coordinates
+  const double* y = nullptr;  // y coordinates
+  std::size_t n = 0;          // Number of points
+
+  CurveView() {}
+  CurveView(const double* x, const double* y, std::size_t n)
+      : x(x), y(y), n(n) {}
+
+  // Number of points of the curve
+  std::size_t numPoints() const { return n; }
+
+  // Point at a specific index (no bounds check)
+  Point_2 getPoint(std::size_t index) const {
+    return Point_2(x[index], y[index]);
+  }
+};
+
+#endif  // CURVE_VIEW_H
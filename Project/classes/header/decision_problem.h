@@ -2,37 +2,80 @@
 #define DECISION_PROBLEM_H
 
 #include "free_space.h"
+#include "stats.h"
 
+// Decides if the Frechet distance of two curves is at most epsilon. The
+// curves are referenced and must outlive the object. If a workspace is given,
+// the free space and the reachable intervals are stored in its buffers. In
+// sparse mode (see FreeSpace) the propagation visits only the cells that are
+// reachable from the left or from below and skips the empty runs between
+// them.
 class DecisionProblem {
  public:
   // Constructor to initialize with two polygonal curves and epsilon
   DecisionProblem(const PolygonalCurve& P, const PolygonalCurve& Q,
-                  double epsilon);
+                  double epsilon, Workspace* workspace = nullptr,
+                  FreeSpaceMode mode = FreeSpaceMode::Dense);
+
+  // The curves are referenced, so temporaries would dangle
+  DecisionProblem(PolygonalCurve&&, const PolygonalCurve&, double,
+                  Workspace* = nullptr,
+                  FreeSpaceMode = FreeSpaceMode::Dense) = delete;
+  DecisionProblem(const PolygonalCurve&, PolygonalCurve&&, double,
+                  Workspace* = nullptr,
+                  FreeSpaceMode = FreeSpaceMode::Dense) = delete;
+  DecisionProblem(PolygonalCurve&&, PolygonalCurve&&, double,
+                  Workspace* = nullptr,
+                  FreeSpaceMode = FreeSpaceMode::Dense) = delete;
+
+  DecisionProblem(const DecisionProblem&) = delete;
+  DecisionProblem& operator=(const DecisionProblem&) = delete;
 
   // Getter
   bool doesMonotoneCurveExist() const;
   const PolygonalCurve& getCurveP() const;
   const PolygonalCurve& getCurveQ() const;
   double getEpsilon() const;
+  const DecisionStats& getStats() const;
   // Setter
   void setEpsilon(double newEpsilon);
 
   // Function to check if a monotone curve exists
   void checkMonotoneCurve();
 
+  // Propagates reachability through cell (i, j) from its reachable left and
+  // bottom intervals to its right and top intervals, given the free right
+  // and top intervals
+  static void propagateCell(int i, int j, const PointPair& left,
+                            const PointPair& bottom,
+                            const PointPair& freeRight,
+                            const PointPair& freeTop, PointPair& right,
+                            PointPair& top);
+
  private:
-  PolygonalCurve P;     // Polygonal curve P
-  PolygonalCurve Q;     // Polygonal curve Q
-  double epsilon;       // Epsilon value
-  FreeSpace freeSpace;  // FreeSpace object
-  PointPairVector L_R;  // Reachable L
-  PointPairVector B_R;  // Reachable B
+  PointPairVector ownL_R;  // Storage of L_R without a workspace
+  PointPairVector ownB_R;  // Storage of B_R without a workspace
+  FreeIntervalVector ownBottom, ownTop;  // Sparse rows without a workspace
+
+  const PolygonalCurve& P;  // Polygonal curve P
+  const PolygonalCurve& Q;  // Polygonal curve Q
+  double epsilon;           // Epsilon value
+  FreeSpace freeSpace;      // FreeSpace object
+  PointPairVector& L_R;     // Reachable L
+  PointPairVector& B_R;     // Reachable B
+  FreeIntervalVector& reachableBottom;  // Sparse: reachable B below a row
+  FreeIntervalVector& reachableTop;     // Sparse: reachable B above a row
 
   bool monotoneCurveExists;  // True if a monotone curve exists, false otherwise
 
+  DecisionStats stats;  // Counters (filled only with ENABLE_STATS)
+
   // Helper functions for checking the conditions
   bool checkStartAndEndConditions();
   bool checkIfMonotoneCurveExists();
+  bool checkSparseStartAndEndConditions() const;
+  bool checkIfSparseMonotoneCurveExists();
+  bool checkDegenerateCurve() const;
 };
 
 #endif  // DECISION_PROBLEM_H
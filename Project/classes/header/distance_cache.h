@@ -0,0 +1,163 @@
+#ifndef DISTANCE_CACHE_H
+#define DISTANCE_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "free_space.h"
+#include "polygonal_curve.h"
+
+class Workspace;
+
+// 128-bit hash of the coordinate bytes of a curve (equal curves, equal
+// digests; a collision of two different curves has probability ~2^-128)
+struct CurveDigest {
+  std::uint64_t low;
+  std::uint64_t high;
+};
+
+// Hashes the x and y columns of a curve in one pass
+CurveDigest curveDigest(const PolygonalCurve& curve);
+
+// Engines whose results are cached (the values are part of the keys of the
+// disk tier, so never renumber them)
+enum class CachedEngine : std::uint32_t {
+  FrechetDistance = 1,  // FDistance
+  ApproximateGED = 2    // GED::computeSquareRootApproxGED
+};
+
+// Key of a cached distance: the digests of both curves (in order), the
+// engine and a caller-defined word of parameters, hashed to 128 bits
+struct DistanceKey {
+  std::uint64_t low;
+  std::uint64_t high;
+
+  bool operator==(const DistanceKey& other) const {
+    return low == other.low && high == other.high;
+  }
+};
+
+DistanceKey distanceKey(const CurveDigest& P, const CurveDigest& Q,
+                        CachedEngine engine, std::uint64_t parameters = 0);
+
+// Options of a cache
+struct DistanceCacheOptions {
+  std::string path;                     // Disk tier (empty: memory only)
+  std::size_t capacity = 1 << 20;       // Entries of the memory tier
+  std::size_t numShards = 16;           // Independently locked LRU shards
+  bool syncWrites = false;              // fdatasync after every append
+};
+
+// Counters of a cache (a snapshot)
+struct DistanceCacheStats {
+  std::uint64_t memoryHits = 0;   // Lookups answered by the memory tier
+  std::uint64_t diskHits = 0;     // Lookups answered by the disk tier
+  std::uint64_t misses = 0;       // Lookups answered by neither
+  std::uint64_t insertions = 0;   // Values inserted
+  std::uint64_t evictions = 0;    // Entries evicted from the memory tier
+  std::uint64_t diskEntries = 0;  // Entries of the disk tier
+};
+
+// Content-addressed cache of distance results. The memory tier is an LRU
+// split into shards with one lock each, so threads rarely contend. The disk
+// tier is an append-only file of checksummed records that survives
+// restarts: it is scanned on opening (a torn last record is dropped), the
+// memory keeps a hash-map entry with the record offset per key instead of
+// the record, and a lookup reads the record back with pread and promotes it
+// to the memory tier. Several processes can share the file: appends hold an
+// exclusive flock and first index the records the others appended, and a
+// lookup that misses the index checks the tail of the file before giving
+// up. Two threads that miss the same key at once both compute it; the first
+// value is kept. GED is randomized, so the cache returns the first
+// approximation computed.
+class DistanceCache {
+ public:
+  // Constructor to open (or create) the disk tier (throws
+  // std::runtime_error if the file cannot be opened or is not a cache)
+  explicit DistanceCache(
+      const DistanceCacheOptions& options = DistanceCacheOptions());
+
+  // Destructor (closes the disk tier if close() was not called; a failed
+  // sync is lost there, so call close() to see it)
+  ~DistanceCache();
+
+  DistanceCache(const DistanceCache&) = delete;
+  DistanceCache& operator=(const DistanceCache&) = delete;
+
+  // Looks a key up in both tiers; returns false on a miss
+  bool lookup(const DistanceKey& key, double& value);
+
+  // Inserts a value into both tiers (thread-safe)
+  void insert(const DistanceKey& key, double value);
+
+  // Cached FDistance (the free-space mode does not change the value)
+  double frechetDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                         Workspace* workspace = nullptr,
+                         FreeSpaceMode mode = FreeSpaceMode::Dense);
+
+  // Cached GED::computeSquareRootApproxGED
+  double approximateGED(const PolygonalCurve& P, const PolygonalCurve& Q,
+                        Workspace* workspace = nullptr);
+
+  // Writes the appended records to the device
+  void flush();
+
+  // Syncs and closes the disk tier (throws std::runtime_error if the sync
+  // fails). Later lookups and inserts use the memory tier only.
+  void close();
+
+  // Getter
+  DistanceCacheStats getStats() const;
+
+ private:
+  struct KeyHash {
+    std::size_t operator()(const DistanceKey& key) const {
+      return static_cast<std::size_t>(key.low);
+    }
+  };
+
+  struct Shard {
+    std::mutex lock;
+    std::list<std::pair<DistanceKey, double>> order;  // Most recent first
+    std::unordered_map<DistanceKey,
+                       std::list<std::pair<DistanceKey, double>>::iterator,
+                       KeyHash>
+        index;
+  };
+
+  DistanceCacheOptions options;
+  std::size_t shardCapacity;
+  std::vector<std::unique_ptr<Shard>> shards;
+
+  // Disk tier: offsets of the records by the low word of their keys
+  mutable std::mutex diskLock;
+  int fd;
+  std::uint64_t fileSize;  // End of the indexed records
+  std::unordered_map<std::uint64_t, std::uint64_t> diskIndex;
+
+  std::atomic<std::uint64_t> memoryHits, diskHits, misses, insertions,
+      evictions;
+
+  // Tiers
+  bool lookupMemory(const DistanceKey& key, double& value);
+  void insertMemory(const DistanceKey& key, double value);
+  bool lookupDisk(const DistanceKey& key, double& value);
+  void appendDisk(const DistanceKey& key, double value);
+
+  // Scans the disk tier on opening
+  void openDisk();
+
+  // Indexes the records after fileSize (diskLock held; truncate only with
+  // the file lock held, when a bad record can only be a torn one)
+  void scanTail(bool truncate);
+};
+
+#endif  // DISTANCE_CACHE_H
@@ -0,0 +1,116 @@
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "batch_driver.h"
+
+class MappedCurveFile;
+
+// Entries kept by a matrix run
+enum class MatrixOutput {
+  Dense,     // Every entry, in a memory-mapped matrix file
+  TopK,      // The k smallest entries of every row (sparse, BatchRecord)
+  Threshold  // The entries <= epsilon (sparse, BatchRecord)
+};
+
+// Dense matrix file: this header, then numRows * numColumns doubles in
+// row-major order starting at dataOffset (a multiple of
+// kMatrixFileAlignment). Entries of tiles that were not computed are 0. The
+// output of a shard holds only the band of rows its tiles cover, rows
+// [firstRow, firstRow + numRows) of the matrix.
+struct MatrixFileHeader {
+  char magic[8];              // "PSMATRX1"
+  std::uint64_t numRows;      // Number of rows
+  std::uint64_t numColumns;   // Number of columns
+  std::uint64_t dataOffset;   // Byte offset of the entries
+  std::uint64_t firstRow;     // Matrix row of the first row (0 if complete)
+  std::uint64_t reserved[3];  // Reserved, 0
+};
+
+const std::uint64_t kMatrixFileAlignment = 4096;
+
+// Options of a matrix run
+struct MatrixOptions {
+  std::string storePath;    // Curve file (see curve_file.h)
+  std::string outputPath;   // Matrix file or BatchRecord file
+  std::string journalPath;  // Progress journal (empty: outputPath.journal)
+  BatchMetric metric = BatchMetric::FrechetDistance;
+  FreeSpaceMode freeSpaceMode = FreeSpaceMode::Dense;  // FD and Threshold
+  int window = -1;                      // Band of BatchMetric::DTW
+  MatrixOutput output = MatrixOutput::Dense;
+  std::size_t topK = 10;                // k of MatrixOutput::TopK
+  double epsilon = 0.0;                 // Epsilon of Threshold metric/output
+  bool symmetric = false;               // Compute i <= j only and mirror
+  std::size_t tileSize = 0;             // Rows and columns per tile (0: auto)
+  std::size_t cacheBytes = 1 << 20;     // Curve bytes of a tile (auto size)
+  std::size_t memoryBudget = 1 << 30;   // Bytes of tile buffers (auto size)
+  std::size_t numThreads = 0;           // Worker threads (0: hardware)
+  bool resume = true;                   // Continue a matching journal
+  std::size_t shardIndex = 0;           // Shard computed by this run
+  std::size_t numShards = 1;            // Shards of the run
+  std::uint32_t seed = 1;               // GED grid shifts (with the tile id)
+};
+
+// Counts of a matrix run
+struct MatrixProgress {
+  std::size_t tileSize = 0;        // Rows and columns per tile
+  std::size_t numTiles = 0;        // Tiles of the run
+  std::size_t resumedTiles = 0;    // Tiles completed by earlier runs
+  std::size_t computedTiles = 0;   // Tiles computed by this run
+  std::uint64_t sparseEntries = 0; // Records in the sparse output
+};
+
+// Tile size for a curve file: the curves of one tile row and one tile column
+// fit in cacheBytes, and the sparse buffers of all threads in memoryBudget
+std::size_t chooseTileSize(const MappedCurveFile& store,
+                           const MatrixOptions& options);
+
+// Computes the all-pairs matrix of a curve file tile by tile. Tiles run in
+// parallel; each finished tile is flushed to the output and then recorded
+// in the journal, so a run that was interrupted at any point resumes from
+// the completed tiles. TopK keeps the rows of a band of tiles in memory
+// until the band is complete; the sparse outputs skip the diagonal.
+// symmetric halves the work for symmetric metrics (not with TopK). The
+// grid shifts of GED are drawn from seed and the tile id, so a tile gets the
+// same entries in every run, shard and resume.
+//
+// The sparse records are written in the order in which the tiles (bands for
+// TopK) complete, which depends on the threads. Within a tile they are
+// ordered by idP and then idQ (with the mirrored records of symmetric runs
+// next to theirs); within a band of TopK by row and then by value. Sort the
+// file if a global order is needed.
+//
+// With numShards > 1 the tiles (bands for TopK) are split into numShards
+// contiguous runs of about equal cost, estimated from the curve sizes (p q
+// cells per pair, plus p^2 q + p q^2 critical values for FD). The split
+// depends only on the curve file and the options, so independent processes
+// agree on it; each one computes its shard into shardOutputPath. A dense
+// shard maps only the rows of its tiles and leaves the mirrored entries of
+// symmetric runs to the merge.
+MatrixProgress runMatrix(const MatrixOptions& options);
+
+// Output of one shard of a sharded run (outputPath.shard<s>, with the
+// journal next to it)
+std::string shardOutputPath(const std::string& outputPath, std::size_t shard);
+
+// Merges the outputs of all shards into outputPath. Throws
+// std::runtime_error if a shard is missing or incomplete. The sparse outputs
+// are concatenated in shard order, each in the order of runMatrix().
+MatrixProgress mergeMatrixShards(const MatrixOptions& options);
+
+// Runs all shards as child processes of this machine (the executable with
+// the arguments and --shard s), waits for them and merges their outputs.
+// Children get hardware / numShards threads unless --threads is given.
+MatrixProgress runLocalShards(const MatrixOptions& options,
+                              const std::string& executable,
+                              const std::vector<std::string>& arguments);
+
+// Parses "matrix" command line arguments into options (throws
+// std::invalid_argument on errors)
+MatrixOptions parseMatrixArguments(int argc, char** argv);
+
+#endif  // DISTANCE_MATRIX_H
@@ -0,0 +1,58 @@
+#ifndef DTW_H
+#define DTW_H
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "polygonal_curve.h"
+#include "stats.h"
+
+class Workspace;
+
+// Dynamic Time Warping (DTW) distance of two curves: the minimum, over all
+// monotone alignments of the vertices that start with the first and end with
+// the last vertices, of the sum of the Euclidean distances of the aligned
+// pairs.
+//
+// A window w >= 0 restricts the alignment to pairs (i, j) with
+// |i - j| <= max(w, |p - q|) (Sakoe-Chiba band, widened to the length
+// difference so that the last pair stays reachable); w < 0 means no band.
+namespace DTW {
+
+// A candidate of nearestNeighbors with its distance
+struct Neighbor {
+  double distance;
+  std::size_t index;
+};
+
+// Computes the DTW distance. The computation is abandoned as soon as every
+// alignment is proven to cost more than bestSoFar, and infinity is returned
+// then. If a workspace is given, the DP rows are kept in its buffers.
+double computeDTW(
+    const PolygonalCurve& P, const PolygonalCurve& Q, int window = -1,
+    double bestSoFar = std::numeric_limits<double>::infinity(),
+    DTWStats* stats = nullptr, Workspace* workspace = nullptr);
+
+// LB_Kim: the first and the last pairs are part of every alignment
+double lowerBoundKim(const PolygonalCurve& P, const PolygonalCurve& Q);
+
+// LB_Keogh adapted to 2D: every vertex of P is aligned to some vertex of Q
+// within the band, so it costs at least its distance to the bounding box of
+// those vertices
+double lowerBoundKeogh(const PolygonalCurve& P, const PolygonalCurve& Q,
+                       int window = -1, Workspace* workspace = nullptr);
+
+// Finds the k candidates nearest to the query under DTW, sorted by distance
+// (ties keep the earlier candidate). Each candidate passes the cascade
+// LB_Kim, LB_Keogh of the candidate against the envelope of the query,
+// LB_Keogh of the query against the envelope of the candidate, and the DP
+// abandoned against the k-th best distance so far.
+std::vector<Neighbor> nearestNeighbors(
+    const PolygonalCurve& query, const std::vector<PolygonalCurve>& candidates,
+    std::size_t k, int window = -1, DTWStats* stats = nullptr,
+    Workspace* workspace = nullptr);
+
+}  // namespace DTW
+
+#endif  // DTW_H
@@ -0,0 +1,98 @@
+#ifndef ENGINE_PLANNER_H
+#define ENGINE_PLANNER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "polygonal_curve.h"
+
+class Workspace;
+
+// Strategies of the planner
+enum class DistanceStrategy {
+  ExactFD,         // FDistance: binary search over all critical values
+  BisectionFD,     // Bisection of epsilon with DecisionProblem
+  StreamingFD,     // Bisection of epsilon with IncrementalDecision (O(q))
+  ExactGED,        // GED::computeExactGED (O(pq) time, O(q) memory)
+  ApproximateGED   // GED::computeSquareRootApproxGED
+};
+
+// Name of a strategy (for logs and output)
+const char* strategyName(DistanceStrategy strategy);
+
+// Per-operation costs of the model in seconds. The defaults were measured on
+// one x86-64 core with -O2; measure them again for other machines.
+struct CostModel {
+  double criticalValueSeconds = 1.5e-8;  // Per critical value (incl. sort)
+  double decisionCellSeconds = 6e-8;     // Per cell of a DecisionProblem
+  double streamingCellSeconds = 5.5e-8;  // Per cell of an IncrementalDecision
+  double gedCellSeconds = 6e-9;          // Per cell of computeExactGED
+  double sedCellSeconds = 3e-9;          // Per band cell of the GED's SED
+};
+
+// Limits of a plan
+struct PlannerOptions {
+  std::size_t memoryBudget = std::size_t(1) << 30;  // Peak bytes per pair
+  double tolerance = 0.0;  // Relative error allowed for FD (0: exact)
+  bool allowApproximateGED = true;  // Accept the O(sqrt(n)) approximation
+  CostModel costs;
+};
+
+// Estimated cost of a strategy for one pair
+struct StrategyEstimate {
+  DistanceStrategy strategy;
+  double seconds;     // Estimated time
+  std::size_t bytes;  // Estimated peak memory
+  bool exact;         // True if the strategy returns the exact distance
+};
+
+// Result of a planned computation
+struct PlannedResult {
+  double value;               // Distance (the upper end for a bisection)
+  double lower;               // Lower bound of the distance
+  double upper;               // Upper bound of the distance
+  StrategyEstimate estimate;  // Strategy that ran and its estimate
+  bool fallback;              // True if no strategy met budget and accuracy
+};
+
+// Picks the FD or GED strategy of a pair from a cost model. The estimates
+// use the curve sizes and the cached CurveSummary of both curves (the number
+// of bisection steps follows from the summary bounds). The fastest strategy
+// within the memory budget and the accuracy target is chosen; if there is
+// none, the fastest strategy within the budget runs at full precision, and
+// if even that fails, the one with the smallest memory.
+class EnginePlanner {
+ public:
+  // Constructor to set the limits
+  explicit EnginePlanner(const PlannerOptions& options = PlannerOptions());
+
+  // Estimates of all FD or GED strategies for a pair
+  std::vector<StrategyEstimate> estimateFD(const PolygonalCurve& P,
+                                           const PolygonalCurve& Q) const;
+  std::vector<StrategyEstimate> estimateGED(const PolygonalCurve& P,
+                                            const PolygonalCurve& Q) const;
+
+  // Chosen strategy for a pair (fallback is set as in PlannedResult)
+  StrategyEstimate planFD(const PolygonalCurve& P, const PolygonalCurve& Q,
+                          bool* fallback = nullptr) const;
+  StrategyEstimate planGED(const PolygonalCurve& P, const PolygonalCurve& Q,
+                           bool* fallback = nullptr) const;
+
+  // Plans and runs the computation
+  PlannedResult computeFD(const PolygonalCurve& P, const PolygonalCurve& Q,
+                          Workspace* workspace = nullptr) const;
+  PlannedResult computeGED(const PolygonalCurve& P, const PolygonalCurve& Q,
+                           Workspace* workspace = nullptr) const;
+
+  // Getter
+  const PlannerOptions& getOptions() const;
+
+ private:
+  PlannerOptions options;
+
+  // Chooses among estimates as described above
+  StrategyEstimate choose(const std::vector<StrategyEstimate>& estimates,
+                          bool* fallback) const;
+};
+
+#endif  // ENGINE_PLANNER_H
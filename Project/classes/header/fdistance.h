@@ -1,23 +1,59 @@
 #ifndef FDISTANCE_H
 #define FDISTANCE_H
 
+#include <memory>
+
 #include "critical_value.h"
 #include "decision_problem.h"
+#include "warm_decision.h"
 
+// Frechet distance by binary search over the critical values. If a workspace
+// is given, all buffers of the computation come from it. mode selects the
+// free-space storage of the decisions (see FreeSpace): the dense mode runs
+// the probes through a WarmDecision, which narrows the cells it visits as
+// the search proceeds, and the sparse mode through a DecisionProblem over the
+// segment grids. If cancel is given,
+// the search stops at the next step once a stop is requested and keeps the
+// bracket [lower, upper] reached so far (the summary bounds if the critical
+// values were not complete); getFDistance() then returns the upper end.
 class FDistance {
  public:
   // Constructor to initialize with two polygonal curves
-  FDistance(const PolygonalCurve& P, const PolygonalCurve& Q);
+  FDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+            Workspace* workspace = nullptr,
+            FreeSpaceMode mode = FreeSpaceMode::Dense,
+            const CancellationToken* cancel = nullptr);
+
+  // The curves are referenced, so temporaries would dangle
+  FDistance(PolygonalCurve&&, const PolygonalCurve&, Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense,
+            const CancellationToken* = nullptr) = delete;
+  FDistance(const PolygonalCurve&, PolygonalCurve&&, Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense,
+            const CancellationToken* = nullptr) = delete;
+  FDistance(PolygonalCurve&&, PolygonalCurve&&, Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense,
+            const CancellationToken* = nullptr) = delete;
 
   // Getter
   double getFDistance() const;
+  FDistanceStats getStats() const;
+  // Value, bracket and status of the search
+  AnytimeResult getAnytimeResult() const;
 
  private:
-  PolygonalCurve P;           // Polygonal curve P
-  PolygonalCurve Q;           // Polygonal curve Q
-  CriticalValue criticalVal;  // Critical values object
-  DecisionProblem decision;   // Decision problem object
-  double fDistance;           // Computed F-distance
+  Workspace* workspace;             // Scratch buffers (may be null)
+  const PolygonalCurve& P;          // Polygonal curve P
+  const PolygonalCurve& Q;          // Polygonal curve Q
+  const CancellationToken* cancel;  // Stop request (may be null)
+  CriticalValue criticalVal;        // Critical values object
+  WarmDecision decision;            // Decisions of the dense mode
+  std::unique_ptr<DecisionProblem> sparseDecision;  // Sparse mode only
+  double fDistance;                 // Computed F-distance
+  double lowerBound;                // Lower end of the bracket
+  double upperBound;                // Upper end of the bracket
+  AnytimeStatus status;             // Complete, or why the search stopped
+  FDistanceStats stats;             // Counters (filled only with ENABLE_STATS)
 
   // Helper function to perform binary search on critical values
   void computeFDistance();
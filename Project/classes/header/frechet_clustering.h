@@ -0,0 +1,72 @@
+#ifndef FRECHET_CLUSTERING_H
+#define FRECHET_CLUSTERING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class CurveStore;
+
+// Options of the clusterings
+struct ClusteringOptions {
+  std::size_t k = 10;                  // Number of centers or medoids
+  std::size_t firstCenter = 0;         // First center of Gonzalez
+  std::size_t numThreads = 0;          // Worker threads (0: hardware)
+  std::size_t maxIterations = 20;      // Rounds of k-medoids
+  std::size_t medoidCandidates = 16;   // Members tried as a new medoid
+  std::size_t medoidReferences = 128;  // Members a candidate is summed over
+  std::uint32_t seed = 1;              // Sampling of the references
+};
+
+// Work of a clustering. Every (curve, center) comparison of the algorithm
+// ends in one of three ways: a bound from the summaries or the triangle
+// inequality decides it, a DecisionProblem at a threshold decides it, or
+// FDistance computes it.
+struct ClusteringStats {
+  std::uint64_t exactEvaluations = 0;  // FDistance computations
+  std::uint64_t decisions = 0;         // DecisionProblem calls
+  std::uint64_t boundSkips = 0;        // Comparisons decided by bounds
+  std::uint64_t eagerEvaluations = 0;  // FDistance calls of the eager form
+
+  // FDistance computations saved over the eager form
+  std::uint64_t avoidedEvaluations() const {
+    return eagerEvaluations > exactEvaluations
+               ? eagerEvaluations - exactEvaluations
+               : 0;
+  }
+};
+
+// Result of a clustering
+struct ClusteringResult {
+  std::vector<std::size_t> centers;     // Curve ids of the centers/medoids
+  std::vector<std::size_t> assignment;  // Center index of every curve
+  std::vector<double> upperBounds;      // F(curve, its center) <= this
+  double radius = 0.0;       // Largest F(curve, nearest center) (k-center)
+  std::size_t iterations = 0;  // Rounds run (k-medoids)
+  ClusteringStats stats;
+};
+
+// Gonzalez's farthest-first k-center (a 2-approximation of the smallest
+// radius). When a center is added, a curve only needs to know if the new
+// center is closer than its bound, so the summary bound, the triangle
+// inequality over the center distances and a DecisionProblem at the bound
+// answer the comparison, and no FDistance runs. The farthest curve is found
+// by tightening the largest bounds lazily until the largest one is exact.
+// Each curve is assigned to a center within its upper bound; the comparisons
+// run in parallel. Throws std::invalid_argument if k is 0 or the store is
+// empty.
+ClusteringResult gonzalezKCenter(const CurveStore& store,
+                                 const ClusteringOptions& options);
+
+// Alternating k-medoids, started from gonzalezKCenter. The assignment step
+// keeps an upper bound to the assigned medoid and a lower bound to all
+// others per curve (Hamerly's bounds), so most curves are confirmed without
+// any evaluation; the others scan the medoids with bounds and decisions and
+// compute FDistance only for medoids that may be closer. The update step
+// tries the members nearest to each medoid on a sample of the cluster and
+// abandons a candidate once its partial sum exceeds the best one. Both
+// steps run in parallel. Stops when no medoid changes.
+ClusteringResult kMedoids(const CurveStore& store,
+                          const ClusteringOptions& options);
+
+#endif  // FRECHET_CLUSTERING_H
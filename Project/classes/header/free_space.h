@@ -5,40 +5,114 @@
 #include <vector>
 
 #include "polygonal_curve.h"
+#include "segment_grid.h"
 
 typedef std::pair<Point_2, Point_2> PointPair;
 typedef std::vector<PointPair> PointPairVector;
+
+// Non-empty free interval of a sparse row. index is the Q vertex (L) or the
+// Q edge (B) of the interval.
+struct FreeInterval {
+  int index;
+  PointPair interval;
+};
+typedef std::vector<FreeInterval> FreeIntervalVector;
+
+// Storage of the free space
+enum class FreeSpaceMode {
+  Dense,  // L and B hold every interval, (-1, -1) if empty
+  Sparse  // Per-row sorted lists of the non-empty intervals only
+};
+
+class Workspace;
+
+// Free space of two curves. The curves are referenced, not copied, and must
+// outlive the object. If a workspace is given, all intervals are stored in
+// its buffers.
+//
+// In sparse mode the segments of both curves are indexed by uniform grids
+// once, and only the (edge, vertex) pairs whose bounding boxes are within
+// epsilon are evaluated. For similar curves and small epsilon this is close
+// to linear in the number of non-empty intervals instead of O(pq). getL()
+// and getB() are empty in this mode; use rowL() and rowB().
 class FreeSpace {
  public:
   // Constructor to initialize with two polygonal curves and an epsilon value
-  FreeSpace(const PolygonalCurve& P, const PolygonalCurve& Q, double epsilon);
+  FreeSpace(const PolygonalCurve& P, const PolygonalCurve& Q, double epsilon,
+            Workspace* workspace = nullptr,
+            FreeSpaceMode mode = FreeSpaceMode::Dense);
+
+  // The curves are referenced, so temporaries would dangle
+  FreeSpace(PolygonalCurve&&, const PolygonalCurve&, double,
+            Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense) = delete;
+  FreeSpace(const PolygonalCurve&, PolygonalCurve&&, double,
+            Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense) = delete;
+  FreeSpace(PolygonalCurve&&, PolygonalCurve&&, double, Workspace* = nullptr,
+            FreeSpaceMode = FreeSpaceMode::Dense) = delete;
 
   // Destructor
   ~FreeSpace();
 
+  FreeSpace(const FreeSpace&) = delete;
+  FreeSpace& operator=(const FreeSpace&) = delete;
+
   // Getter
   const PolygonalCurve& getCurveP() const;
   const PolygonalCurve& getCurveQ() const;
   double getEpsilon() const;
   const PointPairVector& getL() const;
   const PointPairVector& getB() const;
+  FreeSpaceMode getMode() const;
+  // Number of (edge, vertex) pairs evaluated by the last computation
+  std::size_t getNumEvaluated() const;
+  // Sparse mode: the non-empty intervals of L on P edge i (sorted by Q
+  // vertex) and of B at P vertex i (sorted by Q edge), as [first, last)
+  std::pair<const FreeInterval*, const FreeInterval*> rowL(int i) const;
+  std::pair<const FreeInterval*, const FreeInterval*> rowB(int i) const;
   // Setter
   void setEpsilon(double newEpsilon);
 
   void computeFreeSpace();
 
+  // Computes the portions of the edge from start to end at distance at most
+  // epsilon from the point. Returns their number (0, 1 or 2) and writes them
+  // into portions.
+  static int checkPointsOnEdge(const Point_2& start, const Point_2& end,
+                               const Point_2& point, double epsilon,
+                               double portions[2]);
+
  private:
-  PolygonalCurve P;  // Polygonal curve P
-  PolygonalCurve Q;  // Polygonal curve Q
-  double epsilon;    // Epsilon value
+  PointPairVector ownL;  // Storage of L without a workspace
+  PointPairVector ownB;  // Storage of B without a workspace
+  SegmentGrid ownGridP, ownGridQ;
+  FreeIntervalVector ownSparseL, ownSparseB, ownScratch;
+  std::vector<int> ownRowsL, ownRowsB, ownCandidates;
+
+  const PolygonalCurve& P;   // Polygonal curve P
+  const PolygonalCurve& Q;   // Polygonal curve Q
+  double epsilon;            // Epsilon value
+  FreeSpaceMode mode;        // Dense or sparse storage
+  std::size_t numEvaluated;  // Pairs evaluated by the last computation
+
+  PointPairVector& L;  // Results for P
+  PointPairVector& B;  // Results for Q
 
-  PointPairVector L;  // Results for P
-  PointPairVector B;  // Results for Q
+  // Sparse mode
+  SegmentGrid& gridP;            // Segments of P
+  SegmentGrid& gridQ;            // Segments of Q
+  FreeIntervalVector& sparseL;   // Non-empty L, row by row
+  FreeIntervalVector& sparseB;   // Non-empty B, row by row
+  std::vector<int>& rowsL;       // First entry of each row of sparseL
+  std::vector<int>& rowsB;       // First entry of each row of sparseB
+  FreeIntervalVector& scratch;   // L entries before bucketing by row
+  std::vector<int>& candidates;  // Result of a grid query
 
   void processCurveForL();
   void processCurveForB();
-  std::pair<int, std::vector<float>> checkPointsOnEdge(
-      const Point_2& start, const Point_2& end, const Point_2& point) const;
+  void processSparseL();
+  void processSparseB();
 };
 
 #endif  // FREE_SPACE_H
@@ -2,10 +2,13 @@
 #define GED_H
 
 #include <cmath>
+#include <random>
 #include <utility>
 #include <vector>
 
+#include "anytime.h"
 #include "polygonal_curve.h"
+#include "stats.h"
 
 typedef std::pair<int, int>
     CurveAlphabet;  // Alphabet for curve transformations
@@ -17,22 +20,66 @@ typedef std::vector<std::pair<int, int>>
     Matching;  // A matching of points that has a
                // pair((index, index)) as an element
 
+class Workspace;
+
 namespace GED {
 
-// Computes O(n^(1/2))-approximation of GED
+// Cheap bounds of GED used to schedule the grid levels
+struct GEDBounds {
+  double lower;  // Lower bound from the length difference and bounding boxes
+  double upper;  // Cost of the lockstep matching (or the empty matching)
+};
+
+// Computes O(n^(1/2))-approximation of GED. If stats is not null, the
+// counters of this call are added to it (only with ENABLE_STATS). If a
+// workspace is given, the strings, matchings and SED tables are kept in its
+// buffers and the grid shifts are drawn from its generator.
 double computeSquareRootApproxGED(const PolygonalCurve& P,
-                                  const PolygonalCurve& Q);
+                                  const PolygonalCurve& Q,
+                                  GEDStats* stats = nullptr,
+                                  Workspace* workspace = nullptr);
+
+// Anytime form of computeSquareRootApproxGED. The grid levels poll cancel
+// before every trial. The bracket spans computeGEDBounds().lower and the
+// cheapest feasible matching found, so it contains the exact GED. A complete
+// run returns the approximation as value; an interrupted one returns the
+// upper end.
+AnytimeResult computeAnytimeApproxGED(const PolygonalCurve& P,
+                                      const PolygonalCurve& Q,
+                                      const CancellationToken& cancel,
+                                      GEDStats* stats = nullptr,
+                                      Workspace* workspace = nullptr);
+
+// Computes the exact GED with the O(pq) edit distance DP. Only two rows of
+// the table are kept (in the workspace if one is given), so the memory is
+// O(q) and no matching is returned.
+double computeExactGED(const PolygonalCurve& P, const PolygonalCurve& Q,
+                       Workspace* workspace = nullptr);
+
+// Computes lower and upper bounds of GED from the lockstep distance sum (step
+// 1 of computeSquareRootApproxGED), the length difference and bounding boxes
+GEDBounds computeGEDBounds(const PolygonalCurve& P, const PolygonalCurve& Q,
+                           double lockstepDistance);
 
 // Computes the GED cost for given matching for two polygonal curves P, Q
 double computeCost(const PolygonalCurve& P, const PolygonalCurve& Q,
                    const Matching& matching);
 
-// Transfroms the curves into string by randomly shifted grid
+// Transfroms the curves into string by randomly shifted grid. The shift is
+// drawn from generator if given, else from a randomly seeded one.
 CurveStringPair transformCurvesToStrings(const PolygonalCurve& P,
-                                         const PolygonalCurve& Q, int g);
+                                         const PolygonalCurve& Q, int g,
+                                         std::mt19937* generator = nullptr);
+
+// Computes the String Edit Distance (SED) for GED. Uses the bit-parallel
+// backend when the shorter string fits in a few machine words, and the
+// diagonal DP otherwise.
+Matching SED(const CurveString& S, const CurveString& T, double threshold,
+             GEDStats* stats = nullptr);
 
-// Computes the String Edit Distance (SED) for GED
-Matching SED(const CurveString& S, const CurveString& T, double threshold);
+// Computes the SED for GED with the Landau-Vishkin diagonal DP
+Matching diagonalSED(const CurveString& S, const CurveString& T,
+                     double threshold, GEDStats* stats = nullptr);
 
 // Backtrace the DP table and return matching
 Matching backtrace(const std::vector<std::vector<int>>& D);
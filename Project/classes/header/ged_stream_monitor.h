@@ -0,0 +1,137 @@
+#ifndef GED_STREAM_MONITOR_H
+#define GED_STREAM_MONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "ged.h"
+
+// Options of a GEDStreamMonitor
+struct GEDMonitorOptions {
+  std::size_t window = 64;            // Points per window (W)
+  double threshold = 1.0;             // Alert threshold of the approximate GED
+  std::size_t trialsPerLevel = 0;     // Grid shifts per level (0: as
+                                      // computeSquareRootApproxGED)
+  std::size_t maxActiveShifts = 256;  // Shifts kept up to date per reference
+  std::uint32_t seed = 1;             // Generator of the grid shifts
+};
+
+// Approximate GED of a window against a reference, bracketed. lower and
+// upper are equal once the matching was computed.
+struct GEDEstimate {
+  double lower = 0.0;
+  double upper = 0.0;
+};
+
+// Raised when the approximate GED of a reference crosses the threshold
+struct GEDAlert {
+  std::size_t reference;   // Index of the reference
+  std::uint64_t position;  // Index of the newest point of the window
+  bool above;              // True if the GED rose above the threshold
+  GEDEstimate estimate;    // Bracket of the window
+};
+
+// Counters of a monitor
+struct GEDMonitorStats {
+  std::uint64_t points = 0;       // Points added
+  std::uint64_t windows = 0;      // (window, reference) evaluations
+  std::uint64_t boundSkips = 0;   // Decided by the length and box bound
+  std::uint64_t bracketed = 0;    // Decided by the SED bracket
+  std::uint64_t matchings = 0;    // Decided by the matching cost
+  std::uint64_t activations = 0;  // Grid shifts built from a window
+  std::uint64_t combedCells = 0;  // Cells of the incremental SED
+};
+
+// Compares the last W points of a stream against reference curves under the
+// O(n^(1/2))-approximation of GED and raises an alert whenever the
+// approximation of a reference crosses the threshold.
+//
+// The grid shifts of every (level, trial) of computeSquareRootApproxGED are
+// drawn once per reference. A shift is activated when a window first needs
+// it; from then on each incoming point is quantized once for it and the SED
+// of the window and the reference string is kept up to date: the SED has
+// no substitutions, so it is W + m - 2 LCS, and the LCS of the reference
+// and every window follows from the seaweeds of the string-substring LCS,
+// which advance by one column of m cells per point (Tiskin's combing). The
+// per-point cost is O(m) per active shift, independent of W; shifts that
+// stop being used are dropped in LRU order.
+//
+// The levels are searched as in computeSquareRootApproxGED, without the
+// lockstep bound, which does not slide. The matching of the successful
+// shift matches points in the same cell, so its cost lies in
+// [SED, SED + LCS * cell diagonal]; the O(W) matching and its cost are
+// computed only if this bracket contains the threshold.
+class GEDStreamMonitor {
+ public:
+  // Constructor to watch the references (throws std::invalid_argument if W
+  // is 0 or a reference has no points)
+  GEDStreamMonitor(const std::vector<PolygonalCurve>& references,
+                   const GEDMonitorOptions& options);
+
+  GEDStreamMonitor(const GEDStreamMonitor&) = delete;
+  GEDStreamMonitor& operator=(const GEDStreamMonitor&) = delete;
+
+  // Adds the next point of the stream and appends the alerts it raises
+  void addPoint(double x, double y, std::vector<GEDAlert>& alerts);
+
+  // Getter
+  std::uint64_t numPoints() const;
+  std::size_t numReferences() const;
+  bool isAbove(std::size_t reference) const;  // State of the last window
+  GEDEstimate getEstimate(std::size_t reference) const;  // Last window
+  const GEDMonitorStats& getStats() const;
+
+ private:
+  // Incremental SED of the windows and a reference under one grid shift
+  struct Shift {
+    double originX, originY;   // Origin of the grid
+    double delta;              // Cell size
+    CurveString reference;     // Reference string
+    CurveString codes;         // Window codes, twice (contiguous window)
+    std::vector<std::int64_t> strands;  // Seaweed leaving each row
+    std::vector<int> counts;   // Window seaweeds by start column (mod W)
+    std::int64_t inWindow;     // Seaweeds from top to bottom in the window
+    std::uint64_t lastUsed;    // Point count when last tested
+    bool isActive;             // Kept up to date
+  };
+
+  // State of one reference
+  struct Reference {
+    PolygonalCurve curve;
+    std::size_t n;                 // min(W, m)
+    int maxLevel;                  // Largest grid level
+    std::size_t trials;            // Trials per level
+    std::vector<std::unique_ptr<Shift>> shifts;  // By level * trials + trial
+    std::vector<Shift*> active;    // Shifts kept up to date
+    bool above;                    // State of the last window
+    GEDEstimate estimate;          // Bracket of the last window
+  };
+
+  GEDMonitorOptions options;
+  std::vector<Reference> references;
+  std::uint64_t count;            // Points added
+  std::vector<double> xs, ys;     // Window points, twice (contiguous window)
+  std::deque<std::uint64_t> minX, maxX, minY, maxY;  // Sliding box extremes
+  GEDMonitorStats stats;
+
+  // Start of the current window in the doubled buffers
+  std::size_t windowStart() const;
+
+  // Quantizes a point on the grid of a shift
+  static CurveAlphabet quantize(const Shift& shift, double x, double y);
+
+  // Adds the point at position to a shift (one column of seaweeds)
+  void advance(Shift& shift, std::uint64_t position);
+
+  // Returns the shift of (level, trial) of a reference, built from the
+  // window if it is not active
+  Shift& activate(std::size_t reference, int level, std::size_t trial);
+
+  // Evaluates the current window against a reference
+  GEDEstimate evaluate(std::size_t index);
+};
+
+#endif  // GED_STREAM_MONITOR_H
@@ -0,0 +1,56 @@
+#ifndef HAUSDORFF_DISTANCE_H
+#define HAUSDORFF_DISTANCE_H
+
+#include "polygonal_curve.h"
+#include "stats.h"
+
+class Workspace;
+
+// Hausdorff distance of two curves as point sets: the largest distance from a
+// point of one curve to the other curve. It ignores the order of the points
+// and is a lower bound of the weak Frechet distance and of the Frechet
+// distance.
+//
+// The segments of each curve are indexed by a SegmentGrid. The distances of
+// the vertices are found with grid queries whose radius follows from the
+// previous vertex, and a scan stops as soon as it falls below the best value
+// so far (early break). Inside an edge the distance to the other curve is
+// 1-Lipschitz, so most edges are discarded by a bound from their end points;
+// on the others the maximum lies where the distances to two features (vertex
+// or segment line) of the other curve cross, and these crossings are solved
+// exactly. The distance is computed by the constructor, so the curves are not
+// kept.
+class HausdorffDistance {
+ public:
+  // Constructor to compute the distance of two polygonal curves
+  HausdorffDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                    Workspace* workspace = nullptr);
+
+  HausdorffDistance(const HausdorffDistance&) = delete;
+  HausdorffDistance& operator=(const HausdorffDistance&) = delete;
+
+  // Getter
+  double getHausdorffDistance() const;
+  const HausdorffStats& getStats() const;
+
+  // Directed Hausdorff distance: the largest distance from a point of from to
+  // the curve to
+  static double directedDistance(const PolygonalCurve& from,
+                                 const PolygonalCurve& to,
+                                 Workspace* workspace = nullptr,
+                                 HausdorffStats* stats = nullptr);
+
+  // Checks if the Hausdorff distance is at most epsilon, stopping at the
+  // first point farther than epsilon from the other curve. A negative answer
+  // also rejects DecisionProblem and WeakDecisionProblem, so this is a cheap
+  // filter in front of them and of FDistance thresholds.
+  static bool isWithin(const PolygonalCurve& P, const PolygonalCurve& Q,
+                       double epsilon, Workspace* workspace = nullptr,
+                       HausdorffStats* stats = nullptr);
+
+ private:
+  double distance;       // Computed Hausdorff distance
+  HausdorffStats stats;  // Counters (filled only with ENABLE_STATS)
+};
+
+#endif  // HAUSDORFF_DISTANCE_H
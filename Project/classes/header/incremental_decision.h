@@ -0,0 +1,64 @@
+#ifndef INCREMENTAL_DECISION_H
+#define INCREMENTAL_DECISION_H
+
+#include "decision_problem.h"
+
+// Decision problem for a curve P that grows online (for example a live
+// trajectory) against a fixed curve Q (for example a planned route). Only the
+// reachable intervals on the top boundary of the free space diagram are kept,
+// and each appended point extends them by one row of cells in O(q). Q is
+// referenced and must outlive the object.
+class IncrementalDecision {
+ public:
+  // Constructor to start with an empty P
+  IncrementalDecision(const PolygonalCurve& Q, double epsilon);
+
+  // Constructor to start with the points of P (appended one by one)
+  IncrementalDecision(const PolygonalCurve& P, const PolygonalCurve& Q,
+                      double epsilon);
+
+  // Q is referenced, so a temporary would dangle
+  IncrementalDecision(PolygonalCurve&&, double) = delete;
+  IncrementalDecision(const PolygonalCurve&, PolygonalCurve&&,
+                      double) = delete;
+
+  // Appends a point to P and returns doesMonotoneCurveExist()
+  bool addPoint(const Point_2& point);
+
+  // Restarts with an empty P and a new epsilon. The buffers keep their
+  // capacity, so a bisection over epsilon reuses one object.
+  void reset(double newEpsilon);
+
+  // Getter
+  // True if the Frechet distance of P and Q is at most epsilon
+  bool doesMonotoneCurveExist() const;
+  // True if P is within Frechet distance epsilon of some prefix of Q
+  bool doesPrefixMatch() const;
+  const PolygonalCurve& getCurveP() const;
+  const PolygonalCurve& getCurveQ() const;
+  double getEpsilon() const;
+  // Reachable intervals of Q's edges at the last point of P (q - 1 entries)
+  const PointPairVector& getFrontier() const;
+  const DecisionStats& getStats() const;
+
+ private:
+  PolygonalCurve P;         // Polygonal curve P (grows)
+  const PolygonalCurve& Q;  // Polygonal curve Q (fixed)
+  double epsilon;           // Epsilon value
+
+  PointPairVector frontier;      // Reachable B at y = p - 1
+  PointPairVector nextFrontier;  // Reachable B of the row being added
+  PointPairVector freeL;         // Free L of the row being added
+  bool leftReachable;  // True if (0, p - 1) is reachable
+
+  bool monotoneCurveExists;  // True if (q - 1, p - 1) is reachable
+  bool prefixMatches;        // True if the top boundary is reachable
+
+  DecisionStats stats;  // Counters (filled only with ENABLE_STATS)
+
+  // Helper functions for the first point and for the following points
+  void startCurve(const Point_2& point);
+  void extendCurve(const Point_2& point);
+};
+
+#endif  // INCREMENTAL_DECISION_H
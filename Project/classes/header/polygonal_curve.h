@@ -6,28 +6,71 @@
 
 #include <vector>
 
+#include "curve_summary.h"
+#include "curve_view.h"
+
 // CGAL Kernel (default Epick kernel for exact predicates)
 typedef CGAL::Exact_predicates_inexact_constructions_kernel Kernel;
 typedef Kernel::Point_2 Point_2;  // 2D point type from CGAL
 
+// Polygonal curve stored as x[] and y[] columns. A curve either owns its
+// columns or borrows them from a CurveStore or a MappedCurveFile (see
+// borrow()); a borrowed curve is a lightweight handle that all engines accept
+// like any other curve. Copies of a borrowed curve borrow the same columns,
+// and the first modification copies the points into owned columns. Every
+// curve carries its CurveSummary, which addPoint() updates in O(1).
 class PolygonalCurve {
  public:
+  // Constructor to create an empty curve
+  PolygonalCurve();
+
   // Constructor to initialize the curve with a list of points
   PolygonalCurve(const std::vector<Point_2>& points);
 
-  // Copy constructor
+  // Constructor to copy the points of a curve view
+  explicit PolygonalCurve(const CurveView& view);
+
+  // Copy and move (a borrowed curve stays borrowed)
   PolygonalCurve(const PolygonalCurve& P_);
+  PolygonalCurve(PolygonalCurve&& P_) noexcept;
+  PolygonalCurve& operator=(const PolygonalCurve& P_);
+  PolygonalCurve& operator=(PolygonalCurve&& P_) noexcept;
+
+  // Returns a curve that borrows the columns of a view without copying. The
+  // columns must outlive the curve and all of its copies. The summary is
+  // computed in one pass unless a precomputed one is given.
+  static PolygonalCurve borrow(const CurveView& view);
+  static PolygonalCurve borrow(const CurveView& view,
+                               const CurveSummary& summary);
+
+  // Replaces the points with those of a curve view (keeps the capacity)
+  void assign(const CurveView& view);
 
   // Method to add a point to the curve
   void addPoint(const Point_2& point);
 
-  // Method to get the number of points in the curve
-  std::size_t numPoints() const;
+  // Method to get the number of points in the curve (inline, as the
+  // accessors below, since the engines call them in their inner loops)
+  std::size_t numPoints() const { return m_size; }
 
   // Method to access a point at a specific index
-  const Point_2& getPoint(std::size_t index) const;
+  Point_2 getPoint(std::size_t index) const {
+    if (index >= m_size) throwOutOfRange();
+    return Point_2(m_xs[index], m_ys[index]);
+  }
+
+  // Coordinate columns and a view of them
+  const double* xData() const { return m_xs; }
+  const double* yData() const { return m_ys; }
+  CurveView view() const { return CurveView(m_xs, m_ys, m_size); }
 
-  // Method to compute the total length of the curve
+  // Bounding box, end points and length
+  const CurveSummary& summary() const { return m_summary; }
+
+  // Checks if the columns are borrowed
+  bool isBorrowed() const;
+
+  // Method to get the total length of the curve (from the summary)
   double curveLength() const;
 
   // Print the points of the curve (for debugging or output)
@@ -43,7 +86,25 @@ class PolygonalCurve {
   void floorCoordinates();
 
  private:
-  std::vector<Point_2> m_points;  // Vector to store the sequence of points
+  std::vector<double> m_x;  // Owned x coordinates
+  std::vector<double> m_y;  // Owned y coordinates
+  const double* m_xs;       // x column in use (m_x or borrowed)
+  const double* m_ys;       // y column in use (m_y or borrowed)
+  std::size_t m_size;       // Number of points
+  bool m_borrowed;          // Whether m_xs and m_ys are borrowed
+  CurveSummary m_summary;   // Summary of the points
+
+  // Points m_xs and m_ys at the owned columns
+  void syncColumns();
+
+  // Recomputes the summary after the coordinates changed
+  void resummarize();
+
+  // Copies borrowed columns into owned ones before a modification
+  void ensureOwned();
+
+  // Throws the out-of-range error of getPoint()
+  [[noreturn]] static void throwOutOfRange();
 };
 
 #endif  // POLYGONAL_CURVE_H
@@ -0,0 +1,57 @@
+#ifndef SEGMENT_GRID_H
+#define SEGMENT_GRID_H
+
+#include <cstddef>
+#include <vector>
+
+#include "polygonal_curve.h"
+
+// Uniform grid over the segments of a curve. Every segment is registered in
+// the cells covered by its bounding box, and a query returns the segments
+// whose bounding box meets the query box. The cell size follows the mean
+// segment extent, so a query near the curve touches O(1) cells for typical
+// curves. The buffers keep their capacity across build() calls.
+class SegmentGrid {
+ public:
+  // Constructor to create an empty grid (see build)
+  SegmentGrid();
+
+  // Constructor to index the segments of a curve
+  explicit SegmentGrid(const PolygonalCurve& curve);
+
+  // Indexes the segments of a curve, reusing the buffers
+  void build(const PolygonalCurve& curve);
+
+  // Getter
+  std::size_t numSegments() const;
+
+  // Writes the segments whose bounding box is within radius of the point
+  // (candidates, sorted and without duplicates) into segments
+  void query(const Point_2& point, double radius,
+             std::vector<int>& segments) const;
+
+  // Writes the segments whose bounding box meets the box into segments
+  void queryBox(double minX, double minY, double maxX, double maxY,
+                std::vector<int>& segments) const;
+
+  // Bytes currently reserved by the buffers
+  std::size_t capacityBytes() const;
+
+  // Releases the memory of the buffers
+  void release();
+
+ private:
+  double originX, originY;  // Lower left corner of the grid
+  double cellSize;          // Side length of a cell
+  int columns, rows;        // Number of cells per axis
+
+  std::vector<double> boxes;      // minX, minY, maxX, maxY per segment
+  std::vector<int> cellStart;     // First entry of each cell (CSR)
+  std::vector<int> cellSegments;  // Segments of the cells
+
+  // Clamped cell range of an interval on one axis
+  void cellRange(double low, double high, double origin, int cells,
+                 int& first, int& last) const;
+};
+
+#endif  // SEGMENT_GRID_H
@@ -0,0 +1,74 @@
+#ifndef SIMILARITY_JOIN_H
+#define SIMILARITY_JOIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "free_space.h"
+
+class MappedCurveFile;
+
+// Pair of a join: curve idA of the first and idB of the second file
+struct JoinMatch {
+  std::uint64_t idA;
+  std::uint64_t idB;
+};
+
+// Options of a join
+struct JoinOptions {
+  std::string pathA;       // First curve file (see curve_file.h)
+  std::string pathB;       // Second curve file (empty: self-join of pathA)
+  std::string outputPath;  // Pair list ("idA idB" lines, or binary uint64
+                           // pairs if the name ends with ".bin")
+  double epsilon = 0.0;    // Largest Frechet distance of a match
+  FreeSpaceMode freeSpaceMode = FreeSpaceMode::Dense;  // DecisionProblem
+  std::size_t numThreads = 0;     // Worker threads (0: hardware)
+  std::size_t partitionSize = 0;  // Curves of A per partition (0: auto)
+};
+
+// Counts of a join. Every candidate from the grid ends in exactly one of
+// endpointRejected, boxRejected, boxAccepted and decisions.
+struct JoinStats {
+  std::uint64_t partitions = 0;        // Partitions of A
+  std::uint64_t gridCandidates = 0;    // Pairs in neighbouring grid cells
+  std::uint64_t endpointRejected = 0;  // Start or end points farther apart
+  std::uint64_t boxRejected = 0;       // Summary lower bound > epsilon
+  std::uint64_t boxAccepted = 0;       // Summary upper bound <= epsilon
+  std::uint64_t decisions = 0;         // DecisionProblem calls
+  std::uint64_t matches = 0;           // Pairs with F <= epsilon
+};
+
+// Receives the matches of one partition (called by one thread at a time)
+typedef std::function<void(const JoinMatch* matches, std::size_t count)>
+    JoinCallback;
+
+// Finds all pairs (P in A, Q in B) with F(P, Q) <= epsilon. F is at least
+// the distance of the start points and of the end points, so a pair can
+// only match if both lie in neighbouring cells of a grid with cell size
+// epsilon over (start, end). B is indexed by these cells once; the curves
+// of A, sorted by their cells, are split into partitions that the workers
+// probe independently. Each candidate is filtered by its exact end point
+// distances and the summary bounds, and only the survivors go to
+// DecisionProblem, so the work grows with the number of candidates rather
+// than with |A| |B|. The matches of a partition are passed to callback as
+// soon as it is complete, in no particular order across partitions. If A
+// and B are the same object, each unordered pair is reported once with
+// idA < idB. Curves without points never match. Throws
+// std::invalid_argument if epsilon is negative and std::runtime_error if a
+// worker fails.
+JoinStats similarityJoin(const MappedCurveFile& A, const MappedCurveFile& B,
+                         const JoinOptions& options,
+                         const JoinCallback& callback);
+
+// Joins the curve files of the options and writes the matches to
+// options.outputPath. The pair list of a self-join is the input of
+// "batch --pairs" on the same curve file.
+JoinStats runJoin(const JoinOptions& options);
+
+// Parses "join" command line arguments into options (throws
+// std::invalid_argument on errors)
+JoinOptions parseJoinArguments(int argc, char** argv);
+
+#endif  // SIMILARITY_JOIN_H
@@ -0,0 +1,53 @@
+#ifndef SIMPLIFICATION_PYRAMID_H
+#define SIMPLIFICATION_PYRAMID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "curve_view.h"
+#include "polygonal_curve.h"
+
+// Pyramid of simplifications of a curve with bounds of their Frechet error.
+// Level l keeps at most 2^(l + 1) vertices, always including the first and
+// the last one. The vertices are added in Douglas-Peucker order (farthest
+// from the current simplification first), so every level contains the
+// previous one. Only levels smaller than the curve are stored.
+//
+// The construction scans O(n log n) vertices. On degenerate curves, where
+// Douglas-Peucker splits off one vertex at a time and would scan O(n^2), the
+// refinement stops at that budget and the finer levels are left out; the
+// stored levels and their errors are unaffected.
+//
+// The error of a level is an upper bound of the Frechet distance between the
+// level and the curve. For levels P' and Q' with errors eP and eQ the
+// triangle inequality gives
+//   FD(P', Q') - eP - eQ <= FD(P, Q) <= FD(P', Q') + eP + eQ,
+// so a coarse level bounds the distance of two long curves cheaply.
+class SimplificationPyramid {
+ public:
+  // Constructor to create an empty pyramid
+  SimplificationPyramid();
+
+  // Constructor to build the pyramid of a curve
+  explicit SimplificationPyramid(const CurveView& curve);
+
+  // Getter
+  std::size_t numLevels() const;
+  std::size_t levelSize(std::size_t level) const;
+  const std::uint32_t* levelIndices(std::size_t level) const;
+  double levelError(std::size_t level) const;
+
+  // Coarsest level whose error is at most maxError (numLevels() if none)
+  std::size_t findLevel(double maxError) const;
+
+  // Copies the vertices of a level of the curve into a PolygonalCurve
+  PolygonalCurve levelCurve(std::size_t level, const CurveView& curve) const;
+
+ private:
+  std::vector<std::uint32_t> indices;     // Sorted vertex indices per level
+  std::vector<std::size_t> levelOffsets;  // numLevels + 1 starts in indices
+  std::vector<double> errors;             // Error bound per level
+};
+
+#endif  // SIMPLIFICATION_PYRAMID_H
@@ -0,0 +1,470 @@
+#ifndef SMALL_FRECHET_H
+#define SMALL_FRECHET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "curve_view.h"
+
+// Largest curves of the small-curve engine used by the batch driver
+const int kSmallCurveMaxPoints = 16;
+
+// Pairs that a SmallFrechet group processes at once: one vector register of
+// doubles (splitting wider vectors costs more than the lanes gain)
+#if defined(__AVX__)
+const int kSmallFrechetLanes = 4;
+#else
+const int kSmallFrechetLanes = 2;
+#endif
+
+// One double per lane, and the masks of their comparisons (GCC and Clang
+// vector extensions: the operators act on every lane, a comparison yields -1
+// or 0 per lane and ?: selects per lane). The compiler maps them to SSE2,
+// AVX or NEON registers.
+typedef double SmallFrechetPack
+    __attribute__((vector_size(kSmallFrechetLanes * sizeof(double))));
+typedef std::int64_t SmallFrechetMask
+    __attribute__((vector_size(kSmallFrechetLanes * sizeof(double))));
+
+// Frechet distance and decision of curves with at most N points, for batches
+// of tiny pairs. FDistance and DecisionProblem spend most of the time of
+// such a pair on setting up their objects and buffers; this engine keeps all
+// of its state in fixed-size arrays and runs kSmallFrechetLanes independent
+// pairs in lock step, one SIMD lane per pair. The free-space sweep has no
+// branches: empty intervals are [inf, -inf], and the cases of
+// FreeSpace::checkPointsOnEdge and DecisionProblem::propagateCell become
+// selects. The curves of a group are padded to the longest one of the group
+// by repeating their last point, which does not change their Frechet
+// distance, so pairs of similar sizes should be passed next to each other.
+//
+// The decision follows DecisionProblem (dense) with the same tolerances. The
+// distance follows FDistance: a lock-step binary search over the Type A and
+// B critical values of each lane brackets the distance, and a second search
+// runs over the Type C values inside the bracket, which are the only ones
+// sorted. A curve with a single point is handled as in FDistance.
+//
+// The object holds all buffers (about 130 KiB for N = 16) and needs the
+// alignment of its vectors, so create one per thread with new and reuse it.
+// Not thread-safe. The square roots of the sweep are only vectorized with
+// -fno-math-errno.
+template <int N>
+class SmallFrechet {
+  static_assert(N >= 2, "The engine needs at least two points per curve.");
+
+ public:
+  static const int kMaxPoints = N;
+
+  // Constructor
+  SmallFrechet() {
+    zeros = Pack{};
+    ones = zeros + 1.0;
+    infinities = zeros + std::numeric_limits<double>::infinity();
+  }
+
+  // Checks if the engine takes a curve
+  static bool fits(const CurveView& curve) {
+    return curve.n >= 1 && curve.n <= static_cast<std::size_t>(N);
+  }
+
+  // Decides F(P[k], Q[k]) <= epsilon[k] for count pairs (throws
+  // std::invalid_argument if a curve does not fit)
+  void decide(const CurveView* P, const CurveView* Q, const double* epsilon,
+              bool* result, std::size_t count) {
+    for (std::size_t first = 0; first < count; first += Lanes) {
+      int size = static_cast<int>(std::min<std::size_t>(Lanes, count - first));
+      load(P + first, Q + first, size);
+      Pack eps = zeros;
+      for (int l = 0; l < size; ++l) eps[l] = epsilon[first + l];
+      Mask within;
+      decideGroup(eps, within);
+      for (int l = 0; l < size; ++l) result[first + l] = within[l] != 0;
+    }
+  }
+
+  // Frechet distance of count pairs, as FDistance (-1 if no critical value
+  // was feasible); throws std::invalid_argument if a curve does not fit
+  void distance(const CurveView* P, const CurveView* Q, double* result,
+                std::size_t count) {
+    for (std::size_t first = 0; first < count; first += Lanes) {
+      int size = static_cast<int>(std::min<std::size_t>(Lanes, count - first));
+      load(P + first, Q + first, size);
+      distanceGroup(result + first, size);
+    }
+  }
+
+ private:
+  typedef SmallFrechetPack Pack;
+  typedef SmallFrechetMask Mask;
+  static const int Lanes = kSmallFrechetLanes;
+
+  // Critical values of a lane: 2 of Type A, 2 N (N - 1) of Type B and
+  // N (N - 1)^2 of Type C at most
+  static const int kMaxValues = 2 + 2 * N * (N - 1) + N * (N - 1) * (N - 1);
+
+  // Position of a point relative to an edge in every lane, which does not
+  // depend on epsilon
+  struct Projection {
+    Pack t;       // Parameter of the closest point of the line
+    Pack dist2;   // Squared distance to the line
+    Pack invLen;  // 1 / length of the edge (0: degenerate edge)
+  };
+
+  Pack px[N], py[N];              // Padded points of P
+  Pack qx[N], qy[N];              // Padded points of Q
+  Projection alongP[N][N];        // [i][j]: point j of Q over edge i of P
+  Projection alongQ[N][N];        // [i][j]: point i of P over edge j of Q
+  Pack bottomLo[N], bottomHi[N];  // Reachable intervals of a row boundary
+  int sizeP[Lanes], sizeQ[Lanes];    // Points of the original curves
+  int p, q;                          // Padded points of the group
+  double values[Lanes][kMaxValues];  // Critical values of a search
+  int numValues[Lanes];              // Critical values per lane
+  Pack zeros, ones, infinities;      // Constants in every lane
+
+  // Square root in every lane
+  static void sqrtLanes(Pack& value) {
+    for (int l = 0; l < Lanes; ++l) value[l] = std::sqrt(value[l]);
+  }
+
+  // Copies a group of pairs into the lanes and projects every point on the
+  // edges of the other curve. The unused lanes hold two identical points.
+  void load(const CurveView* P, const CurveView* Q, int size) {
+    p = q = 2;
+    for (int l = 0; l < size; ++l) {
+      if (!fits(P[l]) || !fits(Q[l])) {
+        throw std::invalid_argument(
+            "A curve is empty or too long for the small-curve engine.");
+      }
+      sizeP[l] = static_cast<int>(P[l].n);
+      sizeQ[l] = static_cast<int>(Q[l].n);
+      p = std::max(p, sizeP[l]);
+      q = std::max(q, sizeQ[l]);
+    }
+    for (int l = 0; l < Lanes; ++l) {
+      bool used = l < size;
+      if (!used) sizeP[l] = sizeQ[l] = 1;
+      for (int i = 0; i < p; ++i) {
+        int k = std::min(i, sizeP[l] - 1);
+        px[i][l] = used ? P[l].x[k] : 0.0;
+        py[i][l] = used ? P[l].y[k] : 0.0;
+      }
+      for (int j = 0; j < q; ++j) {
+        int k = std::min(j, sizeQ[l] - 1);
+        qx[j][l] = used ? Q[l].x[k] : 0.0;
+        qy[j][l] = used ? Q[l].y[k] : 0.0;
+      }
+    }
+    for (int i = 0; i < p - 1; ++i) {
+      for (int j = 0; j < q; ++j) {
+        project(px[i], py[i], px[i + 1], py[i + 1], qx[j], qy[j],
+                alongP[i][j]);
+      }
+    }
+    for (int i = 0; i < p; ++i) {
+      for (int j = 0; j < q - 1; ++j) {
+        project(qx[j], qy[j], qx[j + 1], qy[j + 1], px[i], py[i],
+                alongQ[i][j]);
+      }
+    }
+  }
+
+  // Projects the point (cx, cy) on the edge (ax, ay)-(bx, by), as
+  // FreeSpace::checkPointsOnEdge
+  void project(const Pack& ax, const Pack& ay, const Pack& bx,
+               const Pack& by, const Pack& cx, const Pack& cy,
+               Projection& projection) {
+    Pack dx = bx - ax, dy = by - ay;
+    Pack len2 = dx * dx + dy * dy;
+    Mask degenerate = len2 == 0.0;
+    Pack safeLen2 = degenerate ? ones : len2;
+    Pack ex = cx - ax, ey = cy - ay;
+    Pack t = degenerate ? zeros : (ex * dx + ey * dy) / safeLen2;
+    Pack rx = cx - (ax + t * dx), ry = cy - (ay + t * dy);
+    Pack len = safeLen2;
+    sqrtLanes(len);
+    projection.t = t;
+    projection.dist2 = rx * rx + ry * ry;
+    projection.invLen = degenerate ? zeros : ones / len;
+  }
+
+  // Free interval [lo, hi] of a projection in every lane ([inf, -inf] if
+  // empty), as FreeSpace::checkPointsOnEdge
+  void freeInterval(const Projection& projection, const Pack& eps2,
+                    const Pack& tolerance, Pack& lo, Pack& hi) {
+    // Task 1: The points at distance epsilon on the line (the closest point
+    // if tangent), snapped to the edge ends
+    Pack slack = eps2 - projection.dist2;
+    Pack d = slack < 0.0 ? zeros : slack;
+    sqrtLanes(d);
+    d *= projection.invLen;
+    Mask tangent = (slack < 0.0 ? -slack : slack) < tolerance;
+    lo = tangent ? projection.t : projection.t - d;
+    hi = tangent ? projection.t : projection.t + d;
+    Pack first = (lo - 1.0 < 1e-9) & (1.0 - lo < 1e-9) ? ones : lo;
+    Pack last = (hi - 1.0 < 1e-9) & (1.0 - hi < 1e-9) ? ones : hi;
+    lo = (lo < 1e-9) & (-lo < 1e-9) ? zeros : first;
+    hi = (hi < 1e-9) & (-hi < 1e-9) ? zeros : last;
+
+    // Task 2: Empty if the point is too far or the interval misses the
+    // edge. A degenerate edge is free everywhere or nowhere; padding creates
+    // them at the end point, so they get the tolerance of a tangent.
+    Mask degenerate = projection.invLen == 0.0;
+    Mask misses = ((slack < 0.0) & ~tangent) | (lo > 1.0) | (hi < 0.0);
+    Mask empty = degenerate ? slack < -tolerance : misses;
+    lo = degenerate ? zeros : lo;
+    hi = degenerate ? ones : hi;
+    lo = empty ? infinities : (lo < 0.0 ? zeros : lo);
+    hi = empty ? -infinities : (hi > 1.0 ? ones : hi);
+  }
+
+  // Decides the pairs of the lanes at eps, as DecisionProblem
+  void decideGroup(const Pack& eps, Mask& within) {
+    Pack eps2 = eps * eps;
+    Pack tolerance = (eps2 > 1.0 ? eps2 : ones) * 1e-12;
+
+    // Step 1: (0, 0) and (q-1, p-1) must be free
+    Pack sx = px[0] - qx[0], sy = py[0] - qy[0];
+    Pack ex = px[p - 1] - qx[q - 1], ey = py[p - 1] - qy[q - 1];
+    Mask startFree = (sx * sx + sy * sy <= eps2 + tolerance) &
+                     (ex * ex + ey * ey <= eps2 + tolerance);
+
+    // Step 2: The bottom row is reachable while its free intervals are
+    // connected from (0, 0) to the right
+    Pack lo, hi;
+    Mask connected = startFree;
+    for (int j = 0; j < q - 1; ++j) {
+      freeInterval(alongQ[0][j], eps2, tolerance, lo, hi);
+      Mask reached = connected & (lo == 0.0);
+      bottomLo[j] = reached ? lo : infinities;
+      bottomHi[j] = reached ? hi : -infinities;
+      connected = reached & (hi == 1.0);
+    }
+
+    // Step 3: Sweep the rows. A row keeps the reachable interval of its left
+    // boundary while moving right and replaces the bottom intervals with the
+    // top ones.
+    Pack leftLo = infinities, leftHi = -infinities;
+    Pack rightLo, rightHi, topLo, topHi;
+    connected = startFree;
+    for (int i = 0; i < p - 1; ++i) {
+      freeInterval(alongP[i][0], eps2, tolerance, lo, hi);
+      Mask reached = connected & (lo == 0.0);
+      leftLo = reached ? lo : infinities;
+      leftHi = reached ? hi : -infinities;
+      connected = reached & (hi == 1.0);
+
+      for (int j = 0; j < q - 1; ++j) {
+        freeInterval(alongP[i][j + 1], eps2, tolerance, rightLo, rightHi);
+        freeInterval(alongQ[i + 1][j], eps2, tolerance, topLo, topHi);
+
+        // DecisionProblem::propagateCell without branches
+        Mask fromLeft = leftLo <= leftHi;
+        Mask fromBottom = bottomLo[j] <= bottomHi[j];
+        Pack right = leftLo > rightLo ? leftLo : rightLo;
+        right = fromBottom ? rightLo : right;
+        Mask rightOk = right <= rightHi + 1e-9;
+        Pack top = bottomLo[j] > topLo ? bottomLo[j] : topLo;
+        top = fromLeft ? topLo : top;
+        Mask topOk = top <= topHi + 1e-9;
+        leftLo = rightOk ? (right < rightHi ? right : rightHi) : infinities;
+        leftHi = rightOk ? rightHi : -infinities;
+        bottomLo[j] = topOk ? (top < topHi ? top : topHi) : infinities;
+        bottomHi[j] = topOk ? topHi : -infinities;
+      }
+    }
+
+    // Step 4: (q-1, p-1) must be reachable on the boundary of the last cell
+    within = startFree & ((leftHi == 1.0) | (bottomHi[q - 2] == 1.0));
+  }
+
+  // Distance of a point to the closest point of an edge, as CriticalValue
+  static double edgeDistance(double x, double y, double ax, double ay,
+                             double bx, double by) {
+    double dx = bx - ax, dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 == 0.0 ? 0.0 : ((x - ax) * dx + (y - ay) * dy) / len2;
+    t = std::max(0.0, std::min(1.0, t));
+    double rx = x - (ax + t * dx), ry = y - (ay + t * dy);
+    return std::sqrt(rx * rx + ry * ry);
+  }
+
+  // Type C value of the points i and j of a curve and an edge of the other,
+  // as CriticalValue (false if the bisector misses the edge)
+  static bool bisectorValue(double ix, double iy, double jx, double jy,
+                            double ax, double ay, double bx, double by,
+                            double& value) {
+    double dx = jx - ix, dy = jy - iy;
+    double len2 = dx * dx + dy * dy;
+    if (len2 == 0.0) return false;
+    double a = ((ax - ix) * dx + (ay - iy) * dy) / len2;
+    double b = ((bx - ix) * dx + (by - iy) * dy) / len2;
+    if ((a < 0.5 && b < 0.5) || (a > 0.5 && b > 0.5)) return false;
+
+    // The ends of the edge within rounding error of the bisector
+    double x, y;
+    bool onA = std::fabs(a - 0.5) < 1e-6, onB = std::fabs(b - 0.5) < 1e-6;
+    if (onA && !onB) {
+      x = ax, y = ay;
+    } else if (onB && !onA) {
+      x = bx, y = by;
+    } else if (onA && onB) {
+      double sa = (ax - ix) * (ax - ix) + (ay - iy) * (ay - iy);
+      double sb = (bx - ix) * (bx - ix) + (by - iy) * (by - iy);
+      x = sa < sb ? ax : bx;
+      y = sa < sb ? ay : by;
+    } else {
+      double r1 = 0.5 - a, r2 = b - 0.5;
+      x = (r2 * ax + r1 * bx) / (r1 + r2);
+      y = (r2 * ay + r1 * by) / (r1 + r2);
+    }
+    value = std::sqrt((ix - x) * (ix - x) + (iy - y) * (iy - y));
+    return true;
+  }
+
+  // Sorts the values of a lane and drops duplicates
+  void sortValues(int l) {
+    std::sort(values[l], values[l] + numValues[l]);
+    numValues[l] = static_cast<int>(
+        std::unique(values[l], values[l] + numValues[l]) - values[l]);
+  }
+
+  // Lock-step binary search over the sorted values of the active lanes.
+  // Returns in found the index of the smallest feasible value (-1 if none)
+  // and in rejected the number of values below it that were infeasible.
+  void search(const bool* active, int* found, int* rejected) {
+    int left[Lanes], right[Lanes], mid[Lanes];
+    for (int l = 0; l < Lanes; ++l) {
+      left[l] = 0;
+      right[l] = active[l] ? numValues[l] - 1 : -1;
+      mid[l] = 0;
+      found[l] = -1;
+    }
+    while (true) {
+      bool pending = false;
+      Pack eps = zeros;
+      for (int l = 0; l < Lanes; ++l) {
+        if (left[l] > right[l]) continue;
+        mid[l] = left[l] + (right[l] - left[l]) / 2;
+        eps[l] = values[l][mid[l]];
+        pending = true;
+      }
+      if (!pending) break;
+
+      Mask within;
+      decideGroup(eps, within);
+      for (int l = 0; l < Lanes; ++l) {
+        if (left[l] > right[l]) continue;
+        if (within[l]) {
+          found[l] = mid[l];
+          right[l] = mid[l] - 1;
+        } else {
+          left[l] = mid[l] + 1;
+        }
+      }
+    }
+    for (int l = 0; l < Lanes; ++l) rejected[l] = left[l];
+  }
+
+  // Appends the Type C values of the points of A and the edges of B in lane
+  // l that lie in (lower, upper). The value of points i and j is at least
+  // half their distance, which skips whole pairs of points.
+  void collectTypeC(const Pack* ax, const Pack* ay, int n, const Pack* bx,
+                    const Pack* by, int m, int l, double lower,
+                    double upper) {
+    double* v = values[l];
+    int& count = numValues[l];
+    double limit = upper * (1 + 1e-9);
+    for (int i = 0; i < n - 1; ++i) {
+      for (int j = i + 1; j < n; ++j) {
+        double dx = ax[j][l] - ax[i][l], dy = ay[j][l] - ay[i][l];
+        if (std::sqrt(dx * dx + dy * dy) / 2 > limit) continue;
+        for (int k = 0; k < m - 1; ++k) {
+          double value;
+          if (bisectorValue(ax[i][l], ay[i][l], ax[j][l], ay[j][l], bx[k][l],
+                            by[k][l], bx[k + 1][l], by[k + 1][l], value) &&
+              value > lower && value < upper) {
+            v[count++] = value;
+          }
+        }
+      }
+    }
+  }
+
+  // Frechet distance of the lanes, as FDistance
+  void distanceGroup(double* result, int size) {
+    bool active[Lanes];
+    double lower[Lanes], upper[Lanes];
+
+    // Step 1: A single point is matched to every vertex of the other curve;
+    // the other lanes collect their Type A and B values
+    for (int l = 0; l < Lanes; ++l) {
+      int n = sizeP[l], m = sizeQ[l];
+      active[l] = l < size && n >= 2 && m >= 2;
+      numValues[l] = 0;
+      if (l < size && !active[l]) {
+        double maxDistance = 0.0;
+        for (int i = 0; i < std::max(n, m); ++i) {
+          double dx = px[std::min(i, n - 1)][l] - qx[std::min(i, m - 1)][l];
+          double dy = py[std::min(i, n - 1)][l] - qy[std::min(i, m - 1)][l];
+          maxDistance = std::max(maxDistance, std::sqrt(dx * dx + dy * dy));
+        }
+        result[l] = maxDistance;
+      }
+      if (!active[l]) continue;
+
+      double* v = values[l];
+      int& count = numValues[l];
+      double sx = px[0][l] - qx[0][l], sy = py[0][l] - qy[0][l];
+      double ex = px[n - 1][l] - qx[m - 1][l];
+      double ey = py[n - 1][l] - qy[m - 1][l];
+      v[count++] = std::sqrt(sx * sx + sy * sy);
+      v[count++] = std::sqrt(ex * ex + ey * ey);
+      for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < m - 1; ++j) {
+          v[count++] = edgeDistance(px[i][l], py[i][l], qx[j][l], qy[j][l],
+                                    qx[j + 1][l], qy[j + 1][l]);
+        }
+      }
+      for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n - 1; ++j) {
+          v[count++] = edgeDistance(qx[i][l], qy[i][l], px[j][l], py[j][l],
+                                    px[j + 1][l], py[j + 1][l]);
+        }
+      }
+      sortValues(l);
+    }
+
+    // Step 2: The Type A and B values bracket the distance in
+    // (lower, upper]
+    int found[Lanes], rejected[Lanes];
+    search(active, found, rejected);
+    for (int l = 0; l < Lanes; ++l) {
+      if (!active[l]) continue;
+      lower[l] = rejected[l] > 0 ? values[l][rejected[l] - 1]
+                                 : -std::numeric_limits<double>::infinity();
+      upper[l] = found[l] >= 0 ? values[l][found[l]]
+                               : std::numeric_limits<double>::infinity();
+    }
+
+    // Step 3: Only the Type C values inside the bracket are candidates
+    for (int l = 0; l < Lanes; ++l) {
+      if (!active[l]) continue;
+      numValues[l] = 0;
+      collectTypeC(px, py, sizeP[l], qx, qy, sizeQ[l], l, lower[l], upper[l]);
+      collectTypeC(qx, qy, sizeQ[l], px, py, sizeP[l], l, lower[l], upper[l]);
+      if (found[l] >= 0) values[l][numValues[l]++] = upper[l];
+      sortValues(l);
+    }
+
+    // Step 4: The smallest feasible candidate is the distance
+    search(active, found, rejected);
+    for (int l = 0; l < size; ++l) {
+      if (active[l]) result[l] = found[l] >= 0 ? values[l][found[l]] : -1.0;
+    }
+  }
+};
+
+#endif  // SMALL_FRECHET_H
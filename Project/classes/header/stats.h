@@ -0,0 +1,121 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Hot-path counters and timers are compiled in only if ENABLE_STATS is defined
+// (cmake -DENABLE_STATS=ON). Otherwise the macros below only mark their stats
+// argument as used and every stats struct stays zero.
+#define STATS_CONCAT_INNER(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_STATS
+// Adds value to stats.field
+#define STATS_ADD(stats, field, value) ((stats).field += (value))
+// Adds value to stats->field if stats is not null
+#define STATS_ADD_PTR(stats, field, value) \
+  do {                                     \
+    if (stats) (stats)->field += (value);  \
+  } while (0)
+// Adds the time until the end of the scope (in seconds) to stats.field
+#define STATS_TIMER(stats, field) \
+  ScopedTimer STATS_CONCAT(statsTimer_, __LINE__)(&(stats).field)
+// Adds the time until the end of the scope to stats->field if not null
+#define STATS_TIMER_PTR(stats, field)             \
+  ScopedTimer STATS_CONCAT(statsTimer_, __LINE__)( \
+      (stats) ? &(stats)->field : nullptr)
+#else
+#define STATS_ADD(stats, field, value) ((void)(stats))
+#define STATS_ADD_PTR(stats, field, value) ((void)(stats))
+#define STATS_TIMER(stats, field) ((void)(stats))
+#define STATS_TIMER_PTR(stats, field) ((void)(stats))
+#endif
+
+// Returns true if the library was compiled with ENABLE_STATS
+bool statsEnabled();
+
+// Adds the lifetime of the object (in seconds) to a counter
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(double* target);
+  ~ScopedTimer();
+
+ private:
+  double* target;  // Counter to add to (ignored if null)
+  std::chrono::steady_clock::time_point start;
+};
+
+// Counters of CriticalValue
+struct CriticalValueStats {
+  std::uint64_t typeA = 0;   // Number of Type A values
+  std::uint64_t typeB = 0;   // Number of Type B values
+  std::uint64_t typeC = 0;   // Number of Type C values
+  std::uint64_t unique = 0;  // Number of critical values after deduplication
+  double seconds = 0.0;      // Time to compute and sort all types
+};
+
+// Counters of DecisionProblem (accumulated over all epsilon values)
+struct DecisionStats {
+  std::uint64_t decisionCalls = 0;      // Number of decisions
+  std::uint64_t freeSpaceCells = 0;     // Free-space intervals evaluated
+  std::uint64_t reachabilityCells = 0;  // Cells propagated in L_R/B_R
+  double freeSpaceSeconds = 0.0;        // Time to compute free space
+  double reachabilitySeconds = 0.0;     // Time to propagate reachability
+};
+
+// Counters of one FDistance computation
+struct FDistanceStats {
+  CriticalValueStats criticalValues;
+  DecisionStats decisions;
+  std::uint64_t binarySearchSteps = 0;  // Probes of the binary search
+  std::uint64_t weakSkippedValues = 0;  // Values below the weak FD bound
+  double searchSeconds = 0.0;           // Time of the binary search
+};
+
+// Counters of one GED computation
+struct GEDStats {
+  std::uint64_t levels = 0;         // Grid levels tried
+  std::uint64_t skippedLevels = 0;  // Levels skipped without a trial
+  std::uint64_t trials = 0;         // Randomly shifted grids tried
+  std::uint64_t sedCalls = 0;       // SED computations
+  std::uint64_t sedDiagonals = 0;   // L_h,e values of the diagonal DP
+  std::uint64_t slideLength = 0;    // Total slide steps of the diagonal DP
+  std::uint64_t bitParallelColumns = 0;  // Columns of the bit-parallel SED
+  double transformSeconds = 0.0;         // Time to transform to strings
+  double sedSeconds = 0.0;               // Time spent in SED
+  double seconds = 0.0;                  // Total time
+};
+
+// Counters of one Hausdorff distance computation
+struct HausdorffStats {
+  std::uint64_t vertexQueries = 0;      // Nearest-segment grid queries
+  std::uint64_t candidateSegments = 0;  // Segments returned by the grid
+  std::uint64_t earlyBreaks = 0;        // Scans stopped below the best value
+  std::uint64_t prunedEdges = 0;        // Edges skipped by their upper bound
+  std::uint64_t examinedEdges = 0;      // Edges searched for crossings
+  std::uint64_t crossings = 0;          // Crossing points evaluated
+  double seconds = 0.0;                 // Total time
+};
+
+// Counters of DTW computations and searches
+struct DTWStats {
+  std::uint64_t candidates = 0;     // Candidates of nearestNeighbors
+  std::uint64_t prunedByKim = 0;    // Candidates rejected by LB_Kim
+  std::uint64_t prunedByKeogh = 0;  // Candidates rejected by LB_Keogh
+  std::uint64_t dtwCalls = 0;       // Full DP computations started
+  std::uint64_t abandoned = 0;      // DP computations abandoned early
+  std::uint64_t cells = 0;          // DP cells computed
+  double seconds = 0.0;             // Total time
+};
+
+// JSON emitters for dashboards
+std::string toJSON(const CriticalValueStats& stats);
+std::string toJSON(const DecisionStats& stats);
+std::string toJSON(const FDistanceStats& stats);
+std::string toJSON(const GEDStats& stats);
+std::string toJSON(const HausdorffStats& stats);
+std::string toJSON(const DTWStats& stats);
+
+#endif  // STATS_H
@@ -0,0 +1,99 @@
+#ifndef SUBTRAJECTORY_SEARCH_H
+#define SUBTRAJECTORY_SEARCH_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "decision_problem.h"
+
+// Portion of Q matched by a subtrajectory search. Positions are parameters of
+// Q: vertex index plus the fraction of the following edge.
+struct SubtrajectoryMatch {
+  double start;  // Start of the portion of Q
+  double end;    // End of the portion of Q
+};
+
+// Finds the maximal portions Q[start, end] of a long curve Q with
+// F(P, Q[start, end]) <= epsilon for a short curve P. In the free space
+// diagram the monotone path may start anywhere on the bottom boundary and end
+// anywhere on the top boundary. Q is streamed point by point and only one
+// column of the diagram is kept, so the search takes O(pq) time and O(p)
+// memory. Every reachable interval carries the leftmost start reaching each
+// of its points. P is referenced and must outlive the object.
+class SubtrajectorySearch {
+ public:
+  typedef std::function<void(const SubtrajectoryMatch&)> MatchCallback;
+
+  // Constructor to initialize with the query curve P and epsilon. Every
+  // maximal match is passed to callback as soon as no later match can
+  // contain it.
+  SubtrajectorySearch(const PolygonalCurve& P, double epsilon,
+                      MatchCallback callback);
+
+  // P is referenced, so a temporary would dangle
+  SubtrajectorySearch(PolygonalCurve&&, double, MatchCallback) = delete;
+
+  // Appends the next point of Q
+  void addPoint(const Point_2& point);
+
+  // Reports the remaining matches (call after the last point of Q)
+  void finish();
+
+  // Getter
+  const PolygonalCurve& getCurveP() const;
+  double getEpsilon() const;
+  std::size_t numPointsQ() const;
+
+ private:
+  // Steps (position, label) of the leftmost start reaching the points of a
+  // boundary interval: points at or after a position have at most its label.
+  // Positions increase and labels decrease.
+  typedef std::vector<std::pair<double, double>> LabelSteps;
+
+  // Reachable boundary interval with its labels
+  struct LabeledInterval {
+    PointPair interval;
+    LabelSteps steps;
+  };
+
+  const PolygonalCurve& P;  // Query curve P
+  double epsilon;           // Epsilon value
+  MatchCallback callback;   // Receives the maximal matches
+
+  std::size_t numQ;  // Number of points of Q so far
+  Point_2 lastQ;     // Last point of Q
+
+  std::vector<LabeledInterval> column;      // Reachable L at x = numQ - 1
+  std::vector<LabeledInterval> nextColumn;  // Reachable L being computed
+  LabeledInterval below;                    // Bottom of the current cell
+  LabeledInterval above;                    // Top of the current cell
+
+  bool bottomConnected;   // True if the free bottom boundary reaches x
+  double bottomRunStart;  // Start of that free run
+
+  bool runActive;   // True if the reachable top boundary reaches x
+  double runStart;  // Leftmost start of that reachable run
+  double runEnd;    // End of that reachable run
+
+  std::deque<SubtrajectoryMatch> pending;  // Matches that may be contained
+
+  // Helper functions
+  void startColumn(const Point_2& point);
+  void extendTopRun(const LabeledInterval& top);
+  void closeTopRun();
+  void flushPending(double threshold);
+  void labelInterval(const PointPair& interval, bool vertical,
+                     const LabeledInterval* parallel, double crossLabel,
+                     LabelSteps& steps) const;
+};
+
+// Finds all maximal portions of Q within Frechet distance epsilon of P, in
+// the order of their end on Q
+std::vector<SubtrajectoryMatch> findSubtrajectories(const PolygonalCurve& P,
+                                                    const PolygonalCurve& Q,
+                                                    double epsilon);
+
+#endif  // SUBTRAJECTORY_SEARCH_H
@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads executing submitted tasks in FIFO order
+class ThreadPool {
+ public:
+  // Constructor to start the workers (0: hardware concurrency)
+  explicit ThreadPool(std::size_t numThreads = 0);
+
+  // Destructor (finishes the queued tasks and joins the workers)
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Getter
+  std::size_t numThreads() const;
+
+  // Queues a task (tasks must not throw)
+  void submit(std::function<void()> task);
+
+  // Blocks until every submitted task has finished
+  void wait();
+
+ private:
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable taskAvailable;
+  std::condition_variable allDone;
+  std::size_t running;  // Tasks currently executing
+  bool stopping;
+
+  void workerLoop();
+};
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,41 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+// Disjoint sets over 0, ..., n - 1 with path halving. The parent array is
+// owned by the caller so that it can live in a Workspace.
+class UnionFind {
+ public:
+  UnionFind(std::vector<int>& parent, std::size_t n) : parent(parent) {
+    parent.resize(n);
+    std::iota(parent.begin(), parent.end(), 0);
+  }
+
+  // Representative of the set of x
+  int find(int x) {
+    while (parent[x] != x) {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  }
+
+  // Merges the sets of a and b
+  void unite(int a, int b) {
+    a = find(a);
+    b = find(b);
+    if (a < b) {
+      parent[b] = a;
+    } else if (b < a) {
+      parent[a] = b;
+    }
+  }
+
+ private:
+  std::vector<int>& parent;
+};
+
+#endif  // UNION_FIND_H
@@ -0,0 +1,89 @@
+#ifndef WARM_DECISION_H
+#define WARM_DECISION_H
+
+#include <utility>
+#include <vector>
+
+#include "free_space.h"
+#include "stats.h"
+
+// Decides F(P, Q) <= epsilon for a sequence of epsilon values on the same
+// curves, such as the probes of a binary search, and reuses the work of
+// earlier probes. The free space only grows with epsilon, so
+//  - every epsilon at or above the smallest feasible one is feasible and
+//    every epsilon at or below the largest infeasible one is not, without
+//    any work, and
+//  - a monotone path at a smaller epsilon runs through cells that lie on a
+//    monotone path at the smallest feasible epsilon. After a feasible probe
+//    a backward pass keeps, per row, the column range of those cells (the
+//    corridor), and later probes propagate only inside it.
+// The free intervals are computed on the fly for the visited cells, which are
+// the cells reachable from (0, 0) inside the corridor; a row without any
+// reachable cell ends the probe. The answers are those of DecisionProblem.
+// The curves are referenced and must outlive the object.
+class WarmDecision {
+ public:
+  // Constructor to initialize with two polygonal curves
+  WarmDecision(const PolygonalCurve& P, const PolygonalCurve& Q,
+               Workspace* workspace = nullptr);
+
+  // The curves are referenced, so temporaries would dangle
+  WarmDecision(PolygonalCurve&&, const PolygonalCurve&,
+               Workspace* = nullptr) = delete;
+  WarmDecision(const PolygonalCurve&, PolygonalCurve&&,
+               Workspace* = nullptr) = delete;
+  WarmDecision(PolygonalCurve&&, PolygonalCurve&&,
+               Workspace* = nullptr) = delete;
+
+  WarmDecision(const WarmDecision&) = delete;
+  WarmDecision& operator=(const WarmDecision&) = delete;
+
+  // Decides if a monotone path exists at epsilon
+  bool decide(double epsilon);
+
+  // Forgets the bracket and the corridor
+  void reset();
+
+  // Getter
+  double getFeasibleEpsilon() const;    // Smallest feasible (inf: none)
+  double getInfeasibleEpsilon() const;  // Largest infeasible (-1: none)
+  const DecisionStats& getStats() const;
+
+ private:
+  std::vector<int> ownCells;
+  std::vector<unsigned char> ownFlags;
+  std::vector<int> ownRows;
+  std::vector<std::pair<int, int>> ownCorridor;
+  std::vector<char> ownMarks;
+  FreeIntervalVector ownBottom, ownTop;
+
+  const PolygonalCurve& P;  // Polygonal curve P
+  const PolygonalCurve& Q;  // Polygonal curve Q
+  double feasibleEpsilon;   // Smallest feasible epsilon so far
+  double infeasibleEpsilon; // Largest infeasible epsilon so far
+
+  std::vector<int>& cells;                        // Visited columns by row
+  std::vector<unsigned char>& flags;              // Their reachable sides
+  std::vector<int>& rows;                         // Row starts of cells
+  std::vector<std::pair<int, int>>& corridor;     // Column range per row
+  std::vector<char>& marks;                       // Backward pass, two rows
+  FreeIntervalVector& reachableBottom;  // Reachable B below the current row
+  FreeIntervalVector& reachableTop;     // Reachable B above the current row
+
+  DecisionStats stats;  // Counters (filled only with ENABLE_STATS)
+
+  // Free intervals of L on P edge i at Q vertex j and of B at P vertex i on
+  // Q edge j, as in FreeSpace
+  PointPair freeL(int i, int j, double epsilon) const;
+  PointPair freeB(int i, int j, double epsilon) const;
+
+  // Forward propagation inside the corridor
+  bool propagate(double epsilon);
+
+  // Backward pass over the visited cells of a feasible probe
+  void narrowCorridor();
+
+  bool checkDegenerateCurve(double epsilon) const;
+};
+
+#endif  // WARM_DECISION_H
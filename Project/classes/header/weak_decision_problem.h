@@ -0,0 +1,44 @@
+#ifndef WEAK_DECISION_PROBLEM_H
+#define WEAK_DECISION_PROBLEM_H
+
+#include "free_space.h"
+
+// Decides if the weak Frechet distance of two curves is at most epsilon, i.e.
+// if (0, 0) and (q-1, p-1) are connected in the free space without the
+// monotonicity constraint. The weak Frechet distance is a lower bound of the
+// Frechet distance, so a negative answer also rejects DecisionProblem. The
+// curves are referenced and must outlive the object.
+class WeakDecisionProblem {
+ public:
+  // Constructor to initialize with two polygonal curves and epsilon
+  WeakDecisionProblem(const PolygonalCurve& P, const PolygonalCurve& Q,
+                      double epsilon, Workspace* workspace = nullptr);
+
+  // The curves are referenced, so temporaries would dangle
+  WeakDecisionProblem(PolygonalCurve&&, const PolygonalCurve&, double,
+                      Workspace* = nullptr) = delete;
+  WeakDecisionProblem(const PolygonalCurve&, PolygonalCurve&&, double,
+                      Workspace* = nullptr) = delete;
+  WeakDecisionProblem(PolygonalCurve&&, PolygonalCurve&&, double,
+                      Workspace* = nullptr) = delete;
+
+  // Getter
+  bool doesPathExist() const;
+  double getEpsilon() const;
+
+  // Checks if (0, 0) and (q-1, p-1) are connected in a computed free space
+  // (for example the one of a DecisionProblem). parent is scratch space.
+  static bool isConnected(const FreeSpace& freeSpace,
+                          std::vector<int>& parent);
+
+ private:
+  std::vector<int> ownParent;  // Union-find array without a workspace
+
+  const PolygonalCurve& P;  // Polygonal curve P
+  const PolygonalCurve& Q;  // Polygonal curve Q
+  double epsilon;           // Epsilon value
+  FreeSpace freeSpace;      // FreeSpace object
+  bool pathExists;          // True if the weak decision is positive
+};
+
+#endif  // WEAK_DECISION_PROBLEM_H
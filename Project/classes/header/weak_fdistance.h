@@ -0,0 +1,36 @@
+#ifndef WEAK_FDISTANCE_H
+#define WEAK_FDISTANCE_H
+
+#include "critical_value.h"
+
+// Weak Frechet distance. Free space boundaries open at their Type B critical
+// values, so the weak Frechet distance is the larger of the Type A values and
+// the bottleneck value connecting the first and the last cell. It is found
+// by adding the boundaries in increasing order to a union-find over the
+// cells, in O(pq log(pq)) time and without decision calls.
+class WeakFDistance {
+ public:
+  // Constructor to compute the Type A and B critical values of P and Q
+  WeakFDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                Workspace* workspace = nullptr);
+
+  // Constructor to reuse critical values that include Types A and B
+  WeakFDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                const CriticalValue& criticalVal,
+                Workspace* workspace = nullptr);
+
+  // Getter
+  double getWeakFDistance() const;
+
+ private:
+  std::vector<int> ownOrder;   // Boundary order without a workspace
+  std::vector<int> ownParent;  // Union-find array without a workspace
+
+  double weakFDistance;  // Computed weak Frechet distance
+
+  void computeWeakFDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                            const CriticalValue& criticalVal,
+                            Workspace* workspace);
+};
+
+#endif  // WEAK_FDISTANCE_H
@@ -0,0 +1,96 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "bit_parallel_sed.h"
+#include "free_space.h"
+#include "ged.h"
+#include "polygonal_curve.h"
+
+// Scratch buffers of the FD and GED engines. An engine that is given a
+// Workspace uses these buffers instead of allocating its own, and the buffers
+// keep their capacity between binary-search steps and between queries. After
+// the first few pairs a batch therefore runs without heap allocations. A
+// Workspace must not be shared by concurrent computations; use one per thread.
+class Workspace {
+ public:
+  // Constructor with a random seed of the grid shifts
+  Workspace();
+
+  // Constructor with a fixed seed of the grid shifts (reproducible GED)
+  explicit Workspace(std::uint32_t seed);
+
+  Workspace(const Workspace&) = delete;
+  Workspace& operator=(const Workspace&) = delete;
+
+  // Bytes currently reserved by all buffers
+  std::size_t capacityBytes() const;
+
+  // Releases the memory of all buffers
+  void release();
+
+  // CriticalValue
+  std::vector<double> typeAValues;
+  std::vector<double> typeBValues;
+  std::vector<double> typeCValues;
+  std::vector<double> criticalValues;
+
+  // FreeSpace and DecisionProblem
+  PointPairVector freeSpaceL;
+  PointPairVector freeSpaceB;
+  PointPairVector reachableL;
+  PointPairVector reachableB;
+
+  // Sparse FreeSpace and DecisionProblem
+  SegmentGrid gridP;                  // Segments of P
+  SegmentGrid gridQ;                  // Segments of Q
+  FreeIntervalVector sparseL;         // Non-empty L, row by row
+  FreeIntervalVector sparseB;         // Non-empty B, row by row
+  std::vector<int> sparseRowsL;       // Row starts of sparseL
+  std::vector<int> sparseRowsB;       // Row starts of sparseB
+  FreeIntervalVector sparseScratch;   // L entries before bucketing
+  std::vector<int> gridCandidates;    // Result of a grid query
+  FreeIntervalVector reachableBottom; // Reachable B below the current row
+  FreeIntervalVector reachableTop;    // Reachable B above the current row
+
+  // WarmDecision (also uses reachableBottom and reachableTop)
+  std::vector<int> warmCells;                     // Visited columns by row
+  std::vector<unsigned char> warmFlags;           // Their reachable sides
+  std::vector<int> warmRows;                      // Row starts of warmCells
+  std::vector<std::pair<int, int>> warmCorridor;  // Column range per row
+  std::vector<char> warmMarks;                    // Backward pass marks
+
+  // HausdorffDistance (also uses the grids and gridCandidates)
+  std::vector<double> hausdorffBounds;    // Distance bound per vertex
+  std::vector<double> hausdorffFeatures;  // Quadratics of an edge
+
+  // DTW
+  std::vector<double> dtwCosts;     // Point distances of the current row
+  std::vector<double> dtwRows;      // Previous and current DP rows
+  std::vector<double> dtwEnvelope;  // Band bounding box per row
+  std::vector<double> dtwBounds;    // LB_Keogh terms and their suffix sums
+  std::vector<int> dtwDeque;        // Sliding-window extremum indices
+
+  // WeakDecisionProblem and WeakFDistance
+  std::vector<int> weakOrder;   // Boundaries sorted by critical value
+  std::vector<int> weakParent;  // Union-find over the cells
+
+  // GED
+  CurveString stringP;               // Transformed P
+  CurveString stringQ;               // Transformed Q
+  Matching matching;                 // Matching of the current trial
+  Matching bestMatching;             // Matching of the best level so far
+  std::vector<int> sedTable;         // Banded DP table of diagonalSED
+  std::vector<int> sedDiagonals;     // L values of diagonalSED
+  BitParallelSED bitParallel;        // Match bitmasks of the query string
+  std::vector<std::uint64_t> sedColumns;  // Columns of the bit-parallel SED
+  std::mt19937 generator;                 // Random grid shifts
+  std::vector<double> gedRows;            // Two rows of computeExactGED
+};
+
+#endif  // WORKSPACE_H
@@ -0,0 +1,38 @@
+#include "anytime.h"
+
+#include <limits>
+
+using namespace std;
+
+// Constructor for a token without deadline
+CancellationToken::CancellationToken() : state(make_shared<State>()) {
+  state->deadline = numeric_limits<int64_t>::max();
+}
+
+// Constructor for a token that stops at the deadline
+CancellationToken::CancellationToken(Clock::time_point deadline)
+    : CancellationToken() {
+  state->deadline = deadline.time_since_epoch().count();
+}
+
+// Requests the stop
+void CancellationToken::cancel() const {
+  state->cancelled.store(true, memory_order_relaxed);
+}
+
+// True if cancelled or past the deadline
+bool CancellationToken::stopRequested() const {
+  return stopReason() != AnytimeStatus::Complete;
+}
+
+// Reason of the stop
+AnytimeStatus CancellationToken::stopReason() const {
+  if (state->cancelled.load(memory_order_relaxed)) {
+    return AnytimeStatus::Cancelled;
+  }
+  if (state->deadline != numeric_limits<int64_t>::max() &&
+      Clock::now().time_since_epoch().count() >= state->deadline) {
+    return AnytimeStatus::DeadlineExceeded;
+  }
+  return AnytimeStatus::Complete;
+}
@@ -0,0 +1,118 @@
+#include "async_distance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <utility>
+
+#include "fdistance.h"
+#include "ged.h"
+#include "workspace.h"
+
+using namespace std;
+
+// Constructor to start the workers
+AsyncDistanceExecutor::AsyncDistanceExecutor(size_t numThreads)
+    : pool(numThreads) {}
+
+// Destructor (the pool joins its workers first)
+AsyncDistanceExecutor::~AsyncDistanceExecutor() {}
+
+// Getter for the number of workers
+size_t AsyncDistanceExecutor::numThreads() const { return pool.numThreads(); }
+
+// Queues a Frechet distance query
+future<AnytimeResult> AsyncDistanceExecutor::submitFD(const PolygonalCurve& P,
+                                                      const PolygonalCurve& Q,
+                                                      CancellationToken cancel,
+                                                      FreeSpaceMode mode) {
+  auto promise = make_shared<std::promise<AnytimeResult>>();
+  future<AnytimeResult> result = promise->get_future();
+  pool.submit([this, promise, P, Q, cancel, mode]() {
+    try {
+      // A query that waited past its deadline returns the summary bounds
+      if (cancel.stopRequested()) {
+        double lower = frechetLowerBound(P.summary(), Q.summary());
+        double upper = frechetUpperBound(P.summary(), Q.summary());
+        promise->set_value({upper, lower, upper, cancel.stopReason()});
+        return;
+      }
+      AnytimeResult anytime;
+      {
+        WorkspaceLease workspace(*this);
+        anytime = FDistance(P, Q, workspace.get(), mode, &cancel)
+                      .getAnytimeResult();
+      }
+      promise->set_value(anytime);
+    } catch (...) {
+      promise->set_exception(current_exception());
+    }
+  });
+  return result;
+}
+
+// Queues a GED query
+future<AnytimeResult> AsyncDistanceExecutor::submitGED(
+    const PolygonalCurve& P, const PolygonalCurve& Q,
+    CancellationToken cancel) {
+  auto promise = make_shared<std::promise<AnytimeResult>>();
+  future<AnytimeResult> result = promise->get_future();
+  pool.submit([this, promise, P, Q, cancel]() {
+    try {
+      // A query that waited past its deadline returns the O(n) bounds
+      if (cancel.stopRequested()) {
+        double lockstep = 0.0;
+        for (size_t i = 0; i < min(P.numPoints(), Q.numPoints()); ++i) {
+          double dx = P.xData()[i] - Q.xData()[i];
+          double dy = P.yData()[i] - Q.yData()[i];
+          lockstep += sqrt(dx * dx + dy * dy);
+        }
+        GED::GEDBounds bounds = GED::computeGEDBounds(P, Q, lockstep);
+        promise->set_value({bounds.upper, min(bounds.lower, bounds.upper),
+                            bounds.upper, cancel.stopReason()});
+        return;
+      }
+      AnytimeResult anytime;
+      {
+        WorkspaceLease workspace(*this);
+        anytime = GED::computeAnytimeApproxGED(P, Q, cancel, nullptr,
+                                               workspace.get());
+      }
+      promise->set_value(anytime);
+    } catch (...) {
+      promise->set_exception(current_exception());
+    }
+  });
+  return result;
+}
+
+// Constructor: takes a workspace of the executor
+AsyncDistanceExecutor::WorkspaceLease::WorkspaceLease(
+    AsyncDistanceExecutor& executor)
+    : executor(executor), workspace(executor.acquireWorkspace()) {}
+
+// Destructor: returns the workspace
+AsyncDistanceExecutor::WorkspaceLease::~WorkspaceLease() {
+  executor.releaseWorkspace(move(workspace));
+}
+
+// Getter for the workspace
+Workspace* AsyncDistanceExecutor::WorkspaceLease::get() const {
+  return workspace.get();
+}
+
+// Takes an idle workspace or creates one (at most one per worker is in use)
+unique_ptr<Workspace> AsyncDistanceExecutor::acquireWorkspace() {
+  lock_guard<std::mutex> lock(mutex);
+  if (idleWorkspaces.empty()) return make_unique<Workspace>();
+  unique_ptr<Workspace> workspace = move(idleWorkspaces.back());
+  idleWorkspaces.pop_back();
+  return workspace;
+}
+
+// Returns a workspace for the next query
+void AsyncDistanceExecutor::releaseWorkspace(
+    unique_ptr<Workspace> workspace) {
+  lock_guard<std::mutex> lock(mutex);
+  idleWorkspaces.push_back(move(workspace));
+}
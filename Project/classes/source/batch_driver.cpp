@@ -0,0 +1,401 @@
+#include "batch_driver.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bounded_queue.h"
+#include "curve_file.h"
+#include "decision_problem.h"
+#include "distance_cache.h"
+#include "dtw.h"
+#include "fdistance.h"
+#include "ged.h"
+#include "hausdorff_distance.h"
+#include "small_frechet.h"
+#include "thread_pool.h"
+#include "weak_fdistance.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+// Pairs read from the pair list, tagged with their position in the input
+struct PairChunk {
+  size_t sequence;
+  vector<pair<uint64_t, uint64_t>> pairs;
+};
+
+// Results of one chunk
+struct ResultChunk {
+  size_t sequence;
+  vector<BatchRecord> records;
+};
+
+// Reads the pair list into chunks
+void readPairs(const BatchOptions& options, BoundedQueue<PairChunk>& queue) {
+  bool binary = options.pairsPath.size() >= 4 &&
+                options.pairsPath.compare(options.pairsPath.size() - 4, 4,
+                                          ".bin") == 0;
+  ifstream in(options.pairsPath, binary ? ios::binary : ios::in);
+  if (!in) {
+    throw runtime_error("Cannot open pair list " + options.pairsPath + ".");
+  }
+
+  PairChunk chunk{0, {}};
+  chunk.pairs.reserve(options.chunkSize);
+  string line;
+  size_t lineNumber = 0;
+  while (true) {
+    uint64_t ids[2];
+    if (binary) {
+      if (!in.read(reinterpret_cast<char*>(ids), sizeof(ids))) break;
+    } else {
+      if (!getline(in, line)) break;
+      ++lineNumber;
+      char* end = nullptr;
+      ids[0] = strtoull(line.c_str(), &end, 10);
+      if (end == line.c_str()) continue;  // Skip empty and header lines
+      while (*end == ',' || *end == ' ' || *end == '\t') ++end;
+      char* end2 = nullptr;
+      ids[1] = strtoull(end, &end2, 10);
+      while (*end2 == ' ' || *end2 == '\t' || *end2 == '\r') ++end2;
+      if (end2 == end || *end2 != '\0') {
+        throw runtime_error("Malformed pair list line " +
+                            to_string(lineNumber) + ".");
+      }
+    }
+
+    chunk.pairs.emplace_back(ids[0], ids[1]);
+    if (chunk.pairs.size() == options.chunkSize) {
+      size_t next = chunk.sequence + 1;
+      if (!queue.push(move(chunk))) return;
+      chunk = PairChunk{next, {}};
+      chunk.pairs.reserve(options.chunkSize);
+    }
+  }
+  if (!chunk.pairs.empty()) queue.push(move(chunk));
+}
+
+// Writes one chunk of records. Returns false if a write failed.
+bool writeRecords(FILE* out, const BatchOptions& options,
+                  const vector<BatchRecord>& records) {
+  if (options.format == BatchFormat::Binary) {
+    return fwrite(records.data(), sizeof(BatchRecord), records.size(), out) ==
+           records.size();
+  }
+  for (const auto& record : records) {
+    if (fprintf(out, "%llu,%llu,%.17g\n",
+                static_cast<unsigned long long>(record.idP),
+                static_cast<unsigned long long>(record.idQ),
+                record.value) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+// Computes the metric for one pair with the buffers of the worker's workspace
+double computeBatchMetric(const MappedCurveFile& store,
+                          const BatchOptions& options, uint64_t idP,
+                          uint64_t idQ, Workspace& workspace,
+                          DistanceCache* cache) {
+  // Handles on the mapped columns (no copy)
+  PolygonalCurve P = store.borrowCurve(idP);
+  PolygonalCurve Q = store.borrowCurve(idQ);
+  switch (options.metric) {
+    case BatchMetric::FrechetDistance:
+      if (cache) {
+        return cache->frechetDistance(P, Q, &workspace,
+                                      options.freeSpaceMode);
+      }
+      return FDistance(P, Q, &workspace, options.freeSpaceMode)
+          .getFDistance();
+    case BatchMetric::WeakFrechetDistance:
+      return WeakFDistance(P, Q, &workspace).getWeakFDistance();
+    case BatchMetric::HausdorffDistance:
+      return HausdorffDistance(P, Q, &workspace).getHausdorffDistance();
+    case BatchMetric::DTW:
+      return DTW::computeDTW(P, Q, options.window,
+                             numeric_limits<double>::infinity(), nullptr,
+                             &workspace);
+    case BatchMetric::GED:
+      if (cache) return cache->approximateGED(P, Q, &workspace);
+      return GED::computeSquareRootApproxGED(P, Q, nullptr, &workspace);
+    case BatchMetric::Threshold:
+      // The summaries and the Hausdorff distance give lower bounds that
+      // reject most pairs much more cheaply
+      if (frechetLowerBound(P.summary(), Q.summary()) > options.epsilon ||
+          !HausdorffDistance::isWithin(P, Q, options.epsilon, &workspace)) {
+        return 0.0;
+      }
+      return DecisionProblem(P, Q, options.epsilon, &workspace,
+                             options.freeSpaceMode)
+                     .doesMonotoneCurveExist()
+                 ? 1.0
+                 : 0.0;
+  }
+  return -1.0;
+}
+
+namespace {
+
+// A pair of a chunk for the small-curve engine
+struct SmallPair {
+  size_t index;  // Position in the chunk
+  CurveView P, Q;
+};
+
+// Computes the records of a chunk. For FD without a cache and for Threshold,
+// the pairs of curves with at most kSmallCurveMaxPoints points go through
+// the small-curve engine, in groups of similar sizes that need little
+// padding; all other pairs go through computeBatchMetric.
+void computeChunk(const MappedCurveFile& store, const BatchOptions& options,
+                  const PairChunk& chunk, Workspace& workspace,
+                  DistanceCache* cache,
+                  SmallFrechet<kSmallCurveMaxPoints>& small,
+                  vector<BatchRecord>& records) {
+  bool useSmall =
+      (options.metric == BatchMetric::FrechetDistance && !cache) ||
+      options.metric == BatchMetric::Threshold;
+
+  // Step 1: Compute the large pairs and set the small ones aside
+  vector<SmallPair> smallPairs;
+  for (const auto& ids : chunk.pairs) {
+    records.push_back({ids.first, ids.second, 0.0});
+    if (useSmall) {
+      CurveView P = store.getCurve(ids.first);
+      CurveView Q = store.getCurve(ids.second);
+      if (SmallFrechet<kSmallCurveMaxPoints>::fits(P) &&
+          SmallFrechet<kSmallCurveMaxPoints>::fits(Q)) {
+        // The summary bound still rejects most Threshold pairs for less
+        if (options.metric == BatchMetric::Threshold &&
+            frechetLowerBound(store.borrowCurve(ids.first).summary(),
+                              store.borrowCurve(ids.second).summary()) >
+                options.epsilon) {
+          continue;
+        }
+        smallPairs.push_back({records.size() - 1, P, Q});
+        continue;
+      }
+    }
+    records.back().value = computeBatchMetric(store, options, ids.first,
+                                              ids.second, workspace, cache);
+  }
+  if (smallPairs.empty()) return;
+
+  // Step 2: Sort the small pairs by size, so that the lanes of a group are
+  // padded to about the same curves
+  sort(smallPairs.begin(), smallPairs.end(),
+       [](const SmallPair& a, const SmallPair& b) {
+         return make_pair(a.P.n, a.Q.n) < make_pair(b.P.n, b.Q.n);
+       });
+  size_t count = smallPairs.size();
+  vector<CurveView> P(count), Q(count);
+  for (size_t k = 0; k < count; ++k) {
+    P[k] = smallPairs[k].P;
+    Q[k] = smallPairs[k].Q;
+  }
+
+  // Step 3: Run the groups and put the results back in input order
+  vector<double> values(count);
+  if (options.metric == BatchMetric::Threshold) {
+    vector<double> epsilon(count, options.epsilon);
+    unique_ptr<bool[]> within(new bool[count]);
+    small.decide(P.data(), Q.data(), epsilon.data(), within.get(), count);
+    for (size_t k = 0; k < count; ++k) values[k] = within[k] ? 1.0 : 0.0;
+  } else {
+    small.distance(P.data(), Q.data(), values.data(), count);
+  }
+  for (size_t k = 0; k < count; ++k) {
+    records[smallPairs[k].index].value = values[k];
+  }
+}
+
+}  // namespace
+
+// Streams a pair list through load -> compute -> write
+size_t runBatch(const BatchOptions& options, DistanceCacheStats* cacheStats) {
+  MappedCurveFile store(options.storePath);
+  unique_ptr<DistanceCache> cache;
+  if (!options.cachePath.empty()) {
+    DistanceCacheOptions cacheOptions;
+    cacheOptions.path = options.cachePath;
+    cache.reset(new DistanceCache(cacheOptions));
+  }
+
+  FILE* out = fopen(options.outputPath.c_str(), "wb");
+  if (!out) {
+    throw runtime_error("Cannot open output " + options.outputPath + ".");
+  }
+  vector<char> outputBuffer(1 << 22);  // Flush in 4 MiB blocks
+  setvbuf(out, outputBuffer.data(), _IOFBF, outputBuffer.size());
+
+  BoundedQueue<PairChunk> pairQueue(options.queueCapacity);
+  BoundedQueue<ResultChunk> resultQueue(options.queueCapacity);
+  mutex errorMutex;
+  string error;
+  auto fail = [&](const string& message) {
+    lock_guard<mutex> lock(errorMutex);
+    if (error.empty()) error = message;
+    pairQueue.close();
+    resultQueue.close();
+  };
+
+  // Stage 1: Reader
+  thread reader([&]() {
+    try {
+      readPairs(options, pairQueue);
+    } catch (const exception& e) {
+      fail(e.what());
+    }
+    pairQueue.close();
+  });
+
+  // Stage 3: Writer (restores the input order of the chunks)
+  size_t numPairs = 0;
+  thread writer([&]() {
+    map<size_t, vector<BatchRecord>> pending;
+    size_t nextSequence = 0;
+    ResultChunk chunk;
+    while (resultQueue.pop(chunk)) {
+      pending[chunk.sequence] = move(chunk.records);
+      for (auto it = pending.find(nextSequence); it != pending.end();
+           it = pending.find(nextSequence)) {
+        if (!writeRecords(out, options, it->second)) {
+          fail("Failed to write the output.");
+          return;
+        }
+        numPairs += it->second.size();
+        pending.erase(it);
+        ++nextSequence;
+      }
+    }
+  });
+
+  // Stage 2: Workers
+  {
+    ThreadPool pool(options.numThreads);
+    for (size_t t = 0; t < pool.numThreads(); ++t) {
+      pool.submit([&]() {
+        Workspace workspace;  // Reused for every pair of this worker
+        unique_ptr<SmallFrechet<kSmallCurveMaxPoints>> small(
+            new SmallFrechet<kSmallCurveMaxPoints>());
+        PairChunk chunk;
+        while (pairQueue.pop(chunk)) {
+          ResultChunk result{chunk.sequence, {}};
+          result.records.reserve(chunk.pairs.size());
+          try {
+            computeChunk(store, options, chunk, workspace, cache.get(), *small,
+                         result.records);
+          } catch (const exception& e) {
+            fail(e.what());
+            return;
+          }
+          if (!resultQueue.push(move(result))) return;
+        }
+      });
+    }
+    pool.wait();
+  }
+
+  reader.join();
+  resultQueue.close();
+  writer.join();
+  // Buffered writes fail late: check the stream and the final flush too
+  bool writeFailed = ferror(out) != 0;
+  if (fclose(out) != 0) writeFailed = true;
+
+  if (!error.empty()) {
+    throw runtime_error(error);
+  }
+  if (writeFailed) {
+    throw runtime_error("Failed to write the output.");
+  }
+  if (cache) {
+    cache->close();
+    if (cacheStats) *cacheStats = cache->getStats();
+  }
+  return numPairs;
+}
+
+// Parses a metric name ("fd", "weak-fd", "hausdorff", "dtw", "ged",
+// "threshold")
+BatchMetric parseBatchMetric(const string& value) {
+  if (value == "fd") return BatchMetric::FrechetDistance;
+  if (value == "weak-fd") return BatchMetric::WeakFrechetDistance;
+  if (value == "hausdorff") return BatchMetric::HausdorffDistance;
+  if (value == "dtw") return BatchMetric::DTW;
+  if (value == "ged") return BatchMetric::GED;
+  if (value == "threshold") return BatchMetric::Threshold;
+  throw invalid_argument("Unknown metric " + value + ".");
+}
+
+// Parses a free-space mode name ("dense", "sparse")
+FreeSpaceMode parseFreeSpaceMode(const string& value) {
+  if (value == "dense") return FreeSpaceMode::Dense;
+  if (value == "sparse") return FreeSpaceMode::Sparse;
+  throw invalid_argument("Unknown free-space mode " + value + ".");
+}
+
+// Parses "batch" command line arguments into options
+BatchOptions parseBatchArguments(int argc, char** argv) {
+  BatchOptions options;
+  for (int i = 0; i < argc; ++i) {
+    string flag = argv[i];
+    if (i + 1 >= argc) {
+      throw invalid_argument("Missing value for " + flag + ".");
+    }
+    string value = argv[++i];
+    if (flag == "--store") {
+      options.storePath = value;
+    } else if (flag == "--pairs") {
+      options.pairsPath = value;
+    } else if (flag == "--out") {
+      options.outputPath = value;
+    } else if (flag == "--metric") {
+      options.metric = parseBatchMetric(value);
+    } else if (flag == "--format") {
+      if (value == "csv") {
+        options.format = BatchFormat::CSV;
+      } else if (value == "bin") {
+        options.format = BatchFormat::Binary;
+      } else {
+        throw invalid_argument("Unknown format " + value + ".");
+      }
+    } else if (flag == "--free-space") {
+      options.freeSpaceMode = parseFreeSpaceMode(value);
+    } else if (flag == "--epsilon") {
+      options.epsilon = stod(value);
+    } else if (flag == "--window") {
+      options.window = stoi(value);
+    } else if (flag == "--threads") {
+      options.numThreads = stoul(value);
+    } else if (flag == "--cache") {
+      options.cachePath = value;
+    } else if (flag == "--chunk") {
+      options.chunkSize = max<size_t>(1, stoul(value));
+    } else {
+      throw invalid_argument("Unknown option " + flag + ".");
+    }
+  }
+
+  if (options.storePath.empty() || options.pairsPath.empty() ||
+      options.outputPath.empty()) {
+    throw invalid_argument("--store, --pairs and --out are required.");
+  }
+  return options;
+}
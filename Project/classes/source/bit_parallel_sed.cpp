@@ -0,0 +1,197 @@
+#include "bit_parallel_sed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+
+namespace {
+
+// Number of set bits of a word
+inline int popcount64(uint64_t x) { return __builtin_popcountll(x); }
+
+// Mixes the two coordinates of a grid cell into a table index
+inline size_t hashSymbol(const CurveAlphabet& a) {
+  uint64_t h = static_cast<uint32_t>(a.first) * 0x9E3779B97F4A7C15ULL ^
+               static_cast<uint32_t>(a.second);
+  h *= 0xBF58476D1CE4E5B9ULL;
+  return static_cast<size_t>(h ^ (h >> 31));
+}
+
+}  // namespace
+
+// Returns true if a query of the given length fits in kMaxWords words
+bool BitParallelSED::fitsQuery(size_t length) {
+  return length > 0 && length <= kMaxWords * 64;
+}
+
+// Constructor to create an empty query
+BitParallelSED::BitParallelSED() : words(0), lastMask(~0ULL) {}
+
+// Constructor to build the match bitmasks of the query S
+BitParallelSED::BitParallelSED(const CurveString& S)
+    : words(0), lastMask(~0ULL) {
+  reset(S);
+}
+
+// Rebuilds the match bitmasks for a new query
+void BitParallelSED::reset(const CurveString& newS) {
+  S.assign(newS.begin(), newS.end());
+  words = (S.size() + 63) / 64;
+  lastMask = (S.size() % 64 != 0) ? (1ULL << (S.size() % 64)) - 1 : ~0ULL;
+
+  // Step 1: Size the table to a power of two with load factor <= 1/2
+  size_t slots = 1;
+  while (slots < 2 * S.size()) slots <<= 1;
+  slotSymbols.assign(slots, CurveAlphabet(0, 0));
+  slotUsed.assign(slots, 0);
+  slotMasks.assign(slots * words, 0);
+
+  // Step 2: Set bit i of the mask of S[i]
+  for (size_t i = 0; i < S.size(); ++i) {
+    size_t slot = hashSymbol(S[i]) & (slots - 1);
+    while (slotUsed[slot] && slotSymbols[slot] != S[i]) {
+      slot = (slot + 1) & (slots - 1);  // Linear probing
+    }
+    slotUsed[slot] = 1;
+    slotSymbols[slot] = S[i];
+    slotMasks[slot * words + i / 64] |= 1ULL << (i % 64);
+  }
+}
+
+// Returns the mask of a symbol, or null if it does not occur in S
+const uint64_t* BitParallelSED::findMask(const CurveAlphabet& a) const {
+  size_t slots = slotUsed.size();
+  size_t slot = hashSymbol(a) & (slots - 1);
+  while (slotUsed[slot]) {
+    if (slotSymbols[slot] == a) return &slotMasks[slot * words];
+    slot = (slot + 1) & (slots - 1);
+  }
+  return nullptr;
+}
+
+// Getter for the query length
+size_t BitParallelSED::queryLength() const { return S.size(); }
+
+// Computes the SED between the query and T
+int BitParallelSED::distance(const CurveString& T) const {
+  int lcs = 0;
+  run(T, numeric_limits<int>::max(), lcs, nullptr);
+  return static_cast<int>(S.size() + T.size()) - 2 * lcs;
+}
+
+// Checks if the SED between the query and T is at most k
+bool BitParallelSED::isWithin(const CurveString& T, int k) const {
+  int lcs = 0;
+  return run(T, k, lcs, nullptr);
+}
+
+// Computes the matching of SED(S, T) if it is within the threshold
+Matching BitParallelSED::match(const CurveString& T, double threshold,
+                               GEDStats* stats) const {
+  Matching M;
+  vector<uint64_t> columns;
+  matchInto(T, threshold, M, columns, stats);
+  return M;
+}
+
+// Computes the matching into caller-owned buffers
+bool BitParallelSED::matchInto(const CurveString& T, double threshold,
+                               Matching& M, vector<uint64_t>& columns,
+                               GEDStats* stats) const {
+  size_t n = S.size();
+  size_t m = T.size();
+  int k = static_cast<int>(floor(threshold));
+  M.clear();
+
+  // Step 1: Run the recurrence and keep every column for the backtrace
+  columns.clear();
+  columns.reserve((m + 1) * words);
+  int lcs = 0;
+  if (!run(T, k, lcs, &columns, stats)) {
+    return false;  // Leave the matching empty
+  }
+
+  // Step 2: Backtrace. Bit i of column j is zero iff
+  // LCS(i + 1, j) = LCS(i, j) + 1.
+  size_t i = n, j = m;
+  while (i > 0 && j > 0) {
+    const uint64_t* column = &columns[j * words];
+    if (S[i - 1] == T[j - 1]) {
+      // Diagonal move: match (i, j)
+      M.emplace_back(i - 1, j - 1);
+      --i;
+      --j;
+    } else if (((column[(i - 1) / 64] >> ((i - 1) % 64)) & 1ULL) != 0) {
+      // Up move: LCS(i - 1, j) == LCS(i, j), skip a point in S
+      --i;
+    } else {
+      // Left move: LCS(i, j - 1) == LCS(i, j), skip a point in T
+      --j;
+    }
+  }
+
+  return true;
+}
+
+// Computes match() for every candidate
+vector<Matching> BitParallelSED::matchAll(const vector<CurveString>& candidates,
+                                          double threshold) const {
+  vector<Matching> matchings;
+  matchings.reserve(candidates.size());
+  for (const auto& T : candidates) {
+    matchings.push_back(match(T, threshold));
+  }
+  return matchings;
+}
+
+// Runs the column recurrence V' = (V + (V & M)) | (V & ~M) over T
+bool BitParallelSED::run(const CurveString& T, int k, int& lcs,
+                         vector<uint64_t>* columns, GEDStats* stats) const {
+  long long n = static_cast<long long>(S.size());
+  long long m = static_cast<long long>(T.size());
+
+  // Step 1: The length difference is a lower bound of the SED
+  if (llabs(n - m) > k) return false;
+
+  // Step 2: Initialize V (no symbol matched yet)
+  uint64_t V[kMaxWords];
+  fill(V, V + words, ~0ULL);
+  if (columns) columns->insert(columns->end(), V, V + words);
+
+  lcs = 0;
+  for (long long j = 0; j < m; ++j) {
+    const uint64_t* M = findMask(T[j]);
+
+    // Step 3: Advance V by one column, propagating the carry across words
+    if (M) {
+      uint64_t carry = 0;
+      for (size_t w = 0; w < words; ++w) {
+        uint64_t U = V[w] & M[w];
+        uint64_t sum = V[w] + U;
+        uint64_t carryOut = sum < V[w] ? 1 : 0;
+        sum += carry;
+        carryOut |= (sum < carry) ? 1 : 0;
+        carry = carryOut;
+        V[w] = sum | (V[w] & ~M[w]);
+      }
+    }
+    if (columns) columns->insert(columns->end(), V, V + words);
+    STATS_ADD_PTR(stats, bitParallelColumns, 1);
+
+    // Step 4: Early abandoning. LCS grows by at most one per column, so the
+    // final SED is at least n + m - 2 * min(n, lcs + remaining columns).
+    int zeros = 0;
+    for (size_t w = 0; w < words; ++w) {
+      uint64_t valid = (w + 1 == words) ? lastMask : ~0ULL;
+      zeros += popcount64(~V[w] & valid);
+    }
+    lcs = zeros;
+    long long bestLCS = min(n, static_cast<long long>(lcs) + (m - j - 1));
+    if (n + m - 2 * bestLCS > k) return false;
+  }
+
+  return n + m - 2 * static_cast<long long>(lcs) <= k;
+}
@@ -6,11 +6,24 @@
 #include <cmath>
 #include <iostream>
 
+#include "workspace.h"
+
 using namespace std;
 
 // Constructor to initialize the polygonal curves P and Q
-CriticalValue::CriticalValue(const PolygonalCurve& P, const PolygonalCurve& Q)
-    : P(P), Q(Q) {
+CriticalValue::CriticalValue(const PolygonalCurve& P, const PolygonalCurve& Q,
+                             Workspace* workspace, bool includeTypeC,
+                             const CancellationToken* cancel)
+    : P(P),
+      Q(Q),
+      includeTypeC(includeTypeC),
+      cancel(cancel),
+      interrupted(false),
+      typeAValues(workspace ? workspace->typeAValues : ownTypeAValues),
+      typeBValues(workspace ? workspace->typeBValues : ownTypeBValues),
+      typeCValues(workspace ? workspace->typeCValues : ownTypeCValues),
+      critical_values(workspace ? workspace->criticalValues
+                                : ownCriticalValues) {
   computeAndSortAllTypes();
 }
 
@@ -111,6 +124,7 @@ void CriticalValue::computeTypeA() {
 void CriticalValue::computeTypeB() {
   int p = P.numPoints();
   int q = Q.numPoints();
+  typeBValues.reserve(typeBValues.size() + p * (q - 1) + q * (p - 1));
 
   // For each point in P, find the closest point on each edge of Q
   for (int i = 0; i < p; ++i) {
@@ -134,8 +148,13 @@ void CriticalValue::computeTypeC() {
   int p = P.numPoints();
   int q = Q.numPoints();
 
-  // Compute distances for pairs of points on P and edges of Q
+  // Compute distances for pairs of points on P and edges of Q. A stop is
+  // polled once per row of O(pq) values.
   for (int i = 0; i < p - 1; ++i) {
+    if (cancel && cancel->stopRequested()) {
+      interrupted = true;
+      return;
+    }
     for (int j = i + 1; j < p; ++j) {
       for (int k = 0; k < q - 1; ++k) {
         Point_2 intersection = findIntersectionWithPerpendicularBisector(
@@ -155,6 +174,10 @@ void CriticalValue::computeTypeC() {
 
   // Compute distances for pairs of points on Q and edges of P
   for (int i = 0; i < q - 1; ++i) {
+    if (cancel && cancel->stopRequested()) {
+      interrupted = true;
+      return;
+    }
     for (int j = i + 1; j < q; ++j) {
       for (int k = 0; k < p - 1; ++k) {
         Point_2 intersection = findIntersectionWithPerpendicularBisector(
@@ -175,12 +198,24 @@ void CriticalValue::computeTypeC() {
 
 // Function to compute all types of values, integrate them, and sort them
 void CriticalValue::computeAndSortAllTypes() {
+  STATS_TIMER(stats, seconds);
+  typeAValues.clear();
+  typeBValues.clear();
+  typeCValues.clear();
+  critical_values.clear();
+
   // Compute Type A, B, and C values
   computeTypeA();
   computeTypeB();
-  computeTypeC();
+  if (includeTypeC) computeTypeC();
+  if (interrupted) {
+    typeCValues.clear();
+    return;  // critical_values stays empty
+  }
 
   // Combine all values into critical_values
+  critical_values.reserve(typeAValues.size() + typeBValues.size() +
+                          typeCValues.size());
   critical_values.insert(critical_values.end(), typeAValues.begin(),
                          typeAValues.end());
   critical_values.insert(critical_values.end(), typeBValues.begin(),
@@ -196,6 +231,11 @@ void CriticalValue::computeAndSortAllTypes() {
 
   // Resize the vector to remove the duplicate elements
   critical_values.erase(last, critical_values.end());
+
+  STATS_ADD(stats, typeA, typeAValues.size());
+  STATS_ADD(stats, typeB, typeBValues.size());
+  STATS_ADD(stats, typeC, typeCValues.size());
+  STATS_ADD(stats, unique, critical_values.size());
 }
 
 // Getter for Type A values
@@ -217,3 +257,9 @@ const vector<double>& CriticalValue::getTypeCValues() const {
 const vector<double>& CriticalValue::getCriticalValues() const {
   return critical_values;
 }
+
+// Getter for the counters
+const CriticalValueStats& CriticalValue::getStats() const { return stats; }
+
+// Getter for the interruption flag
+bool CriticalValue::wasInterrupted() const { return interrupted; }
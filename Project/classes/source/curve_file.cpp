@@ -0,0 +1,411 @@
+#include "curve_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const char kCurveFileMagic[8] = {'P', 'S', 'C', 'U', 'R', 'V', 'E', '1'};
+
+// Rounds a byte offset up to the section alignment
+uint64_t alignOffset(uint64_t offset) {
+  return (offset + kCurveFileAlignment - 1) / kCurveFileAlignment *
+         kCurveFileAlignment;
+}
+
+// Writes zero bytes until the stream position is aligned
+void padStream(ofstream& out) {
+  uint64_t position = static_cast<uint64_t>(out.tellp());
+  static const char zeros[kCurveFileAlignment] = {};
+  out.write(zeros, alignOffset(position) - position);
+}
+
+// Appends the content of a temporary file to out and removes it
+void appendFile(ofstream& out, const string& path) {
+  ifstream in(path, ios::binary);
+  vector<char> buffer(1 << 20);
+  while (in) {
+    in.read(buffer.data(), buffer.size());
+    out.write(buffer.data(), in.gcount());
+  }
+  in.close();
+  remove(path.c_str());
+}
+
+// Checks that a section of count elements starts aligned at offset and ends
+// within the file. Written so that no product or sum can overflow.
+bool isValidSection(uint64_t offset, uint64_t count, uint64_t elementSize,
+                    uint64_t fileSize) {
+  if (offset % kCurveFileAlignment != 0 || offset > fileSize) return false;
+  return count <= (fileSize - offset) / elementSize;
+}
+
+// Checks that offsets[] starts at 0, never decreases and ends at numPoints
+bool areValidOffsets(const uint64_t* offsets, uint64_t numCurves,
+                     uint64_t numPoints) {
+  if (offsets[0] != 0) return false;
+  for (uint64_t i = 0; i < numCurves; ++i) {
+    if (offsets[i + 1] < offsets[i]) return false;
+  }
+  return offsets[numCurves] == numPoints;
+}
+
+}  // namespace
+
+// Constructor to open the output file and reserve the header
+CurveFileWriter::CurveFileWriter(const string& path)
+    : path(path),
+      out(path, ios::binary | ios::trunc),
+      yOut(path + ".y.tmp", ios::binary | ios::trunc),
+      offsetsOut(path + ".offsets.tmp", ios::binary | ios::trunc),
+      summariesOut(path + ".summaries.tmp", ios::binary | ios::trunc),
+      numCurves(0),
+      numPoints(0),
+      closed(false) {
+  if (!out || !yOut || !offsetsOut || !summariesOut) {
+    throw runtime_error("Cannot open curve file " + path + " for writing.");
+  }
+
+  // The header is rewritten by close(), x[] starts right after it
+  CurveFileHeader header = {};
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  padStream(out);
+
+  uint64_t firstOffset = 0;
+  offsetsOut.write(reinterpret_cast<const char*>(&firstOffset),
+                   sizeof(firstOffset));
+}
+
+// Destructor
+CurveFileWriter::~CurveFileWriter() {
+  if (!closed) {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+}
+
+// Appends a curve given by points
+void CurveFileWriter::addCurve(const vector<Point_2>& points) {
+  for (const auto& point : points) addPoint(point.x(), point.y());
+  endCurve();
+}
+
+// Appends a PolygonalCurve
+void CurveFileWriter::addCurve(const PolygonalCurve& curve) {
+  addCurve(curve.view());
+}
+
+// Appends a curve given by a view
+void CurveFileWriter::addCurve(const CurveView& curve) {
+  addCurve(curve, CurveSummary(curve));
+}
+
+// Appends a curve given by a view with its summary
+void CurveFileWriter::addCurve(const CurveView& curve,
+                               const CurveSummary& summary) {
+  out.write(reinterpret_cast<const char*>(curve.x), curve.n * sizeof(double));
+  yOut.write(reinterpret_cast<const char*>(curve.y), curve.n * sizeof(double));
+  numPoints += curve.n;
+  this->summary = summary;
+  endCurve();
+}
+
+// Appends one point of the current curve
+void CurveFileWriter::addPoint(double x, double y) {
+  out.write(reinterpret_cast<const char*>(&x), sizeof(x));
+  yOut.write(reinterpret_cast<const char*>(&y), sizeof(y));
+  summary.addPoint(x, y);
+  ++numPoints;
+}
+
+// Ends the current curve
+void CurveFileWriter::endCurve() {
+  offsetsOut.write(reinterpret_cast<const char*>(&numPoints),
+                   sizeof(numPoints));
+  summariesOut.write(reinterpret_cast<const char*>(&summary),
+                     sizeof(summary));
+  summary = CurveSummary();
+  ++numCurves;
+}
+
+// Finishes the file
+void CurveFileWriter::close() {
+  if (closed) return;
+  closed = true;
+  yOut.close();
+  offsetsOut.close();
+  summariesOut.close();
+
+  // Step 1: Append y[], offsets[] and summaries[] after x[]
+  CurveFileHeader header = {};
+  memcpy(header.magic, kCurveFileMagic, sizeof(header.magic));
+  header.version = kCurveFileVersion;
+  header.flags = kCurveFileHasSummaries;
+  header.numCurves = numCurves;
+  header.numPoints = numPoints;
+  header.xOffset = alignOffset(sizeof(CurveFileHeader));
+
+  padStream(out);
+  header.yOffset = static_cast<uint64_t>(out.tellp());
+  appendFile(out, path + ".y.tmp");
+
+  padStream(out);
+  header.offsetsOffset = static_cast<uint64_t>(out.tellp());
+  appendFile(out, path + ".offsets.tmp");
+
+  padStream(out);
+  header.summariesOffset = static_cast<uint64_t>(out.tellp());
+  appendFile(out, path + ".summaries.tmp");
+
+  // Step 2: Write the header
+  out.seekp(0);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.close();
+  if (!out) {
+    throw runtime_error("Failed to write curve file " + path + ".");
+  }
+}
+
+// Constructor to map the file and validate the header
+MappedCurveFile::MappedCurveFile(const string& path)
+    : data(nullptr),
+      size(0),
+      header(nullptr),
+      x(nullptr),
+      y(nullptr),
+      curveOffsets(nullptr),
+      summaries(nullptr) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw runtime_error("Cannot open curve file " + path + ".");
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(CurveFileHeader)) {
+    ::close(fd);
+    throw runtime_error("Invalid curve file " + path + ".");
+  }
+  size = static_cast<size_t>(info.st_size);
+
+  data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // The mapping stays valid after closing the descriptor
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    throw runtime_error("Cannot map curve file " + path + ".");
+  }
+
+  // Validate the header and the section bounds and alignment. numCurves is
+  // bounded before numCurves + 1 is formed.
+  header = static_cast<const CurveFileHeader*>(data);
+  bool withSummaries = (header->flags & kCurveFileHasSummaries) != 0;
+  if (memcmp(header->magic, kCurveFileMagic, sizeof(header->magic)) != 0 ||
+      header->version != kCurveFileVersion ||
+      !isValidSection(header->xOffset, header->numPoints, sizeof(double),
+                      size) ||
+      !isValidSection(header->yOffset, header->numPoints, sizeof(double),
+                      size) ||
+      header->numCurves >= size / sizeof(uint64_t) ||
+      !isValidSection(header->offsetsOffset, header->numCurves + 1,
+                      sizeof(uint64_t), size) ||
+      (withSummaries &&
+       !isValidSection(header->summariesOffset, header->numCurves,
+                       sizeof(CurveSummary), size))) {
+    munmap(data, size);
+    data = nullptr;
+    throw runtime_error("Invalid curve file " + path + ".");
+  }
+
+  // Validate offsets[] once, so that getCurve() never leaves the columns
+  const char* base = static_cast<const char*>(data);
+  if (!areValidOffsets(
+          reinterpret_cast<const uint64_t*>(base + header->offsetsOffset),
+          header->numCurves, header->numPoints)) {
+    munmap(data, size);
+    data = nullptr;
+    throw runtime_error("Invalid curve offsets in " + path + ".");
+  }
+
+  x = reinterpret_cast<const double*>(base + header->xOffset);
+  y = reinterpret_cast<const double*>(base + header->yOffset);
+  curveOffsets =
+      reinterpret_cast<const uint64_t*>(base + header->offsetsOffset);
+  if (withSummaries) {
+    summaries =
+        reinterpret_cast<const CurveSummary*>(base + header->summariesOffset);
+  }
+
+  // Curves are usually read in order
+  madvise(data, size, MADV_SEQUENTIAL);
+}
+
+// Destructor
+MappedCurveFile::~MappedCurveFile() {
+  if (data) munmap(data, size);
+}
+
+// Getter for the number of curves
+size_t MappedCurveFile::numCurves() const { return header->numCurves; }
+
+// Getter for the total number of points
+size_t MappedCurveFile::numPoints() const { return header->numPoints; }
+
+// Getter for the number of points of a curve
+size_t MappedCurveFile::curveSize(size_t id) const {
+  if (id >= header->numCurves) {
+    throw out_of_range("Curve index out of range.");
+  }
+  return curveOffsets[id + 1] - curveOffsets[id];
+}
+
+// Returns a view of a curve (no copy)
+CurveView MappedCurveFile::getCurve(size_t id) const {
+  if (id >= header->numCurves) {
+    throw out_of_range("Curve index out of range.");
+  }
+  uint64_t begin = curveOffsets[id];
+  return CurveView(x + begin, y + begin, curveOffsets[id + 1] - begin);
+}
+
+// Checks if the file stores summaries
+bool MappedCurveFile::hasSummaries() const { return summaries != nullptr; }
+
+// Getter for the x column
+const double* MappedCurveFile::xColumn() const { return x; }
+
+// Getter for the y column
+const double* MappedCurveFile::yColumn() const { return y; }
+
+// Getter for the offsets array
+const uint64_t* MappedCurveFile::offsets() const { return curveOffsets; }
+
+// Returns the summary of a curve (older files have none, then it is computed)
+CurveSummary MappedCurveFile::getSummary(size_t id) const {
+  CurveView curve = getCurve(id);
+  return summaries ? summaries[id] : CurveSummary(curve);
+}
+
+// Returns a handle of a curve that borrows the mapping
+PolygonalCurve MappedCurveFile::borrowCurve(size_t id) const {
+  return PolygonalCurve::borrow(getCurve(id), getSummary(id));
+}
+
+// Copies a curve into a PolygonalCurve for the engines
+PolygonalCurve MappedCurveFile::toPolygonalCurve(size_t id) const {
+  return PolygonalCurve(getCurve(id));
+}
+
+// Converts a CSV file with lines "curve_id,x,y" into a curve file
+size_t convertCSVToCurveFile(const string& csvPath, const string& outputPath) {
+  ifstream in(csvPath);
+  if (!in) {
+    throw runtime_error("Cannot open CSV file " + csvPath + ".");
+  }
+
+  CurveFileWriter writer(outputPath);
+  vector<Point_2> points;
+  string line, currentId;
+  bool hasCurve = false;
+  size_t lineNumber = 0, numCurves = 0;
+  while (getline(in, line)) {
+    ++lineNumber;
+    if (line.empty() || line[0] == '#') continue;
+
+    // Split "curve_id,x,y"
+    size_t first = line.find(',');
+    size_t second = first == string::npos ? first : line.find(',', first + 1);
+    if (second == string::npos) {
+      throw runtime_error("Malformed CSV line " + to_string(lineNumber) + ".");
+    }
+    string id = line.substr(0, first);
+    char* end = nullptr;
+    double x = strtod(line.c_str() + first + 1, &end);
+    if (end != line.c_str() + second) {
+      // Skip a header line such as "id,x,y"
+      if (lineNumber == 1) continue;
+      throw runtime_error("Malformed CSV line " + to_string(lineNumber) + ".");
+    }
+    const char* yStart = line.c_str() + second + 1;
+    double y = strtod(yStart, &end);
+    while (isspace(static_cast<unsigned char>(*end))) ++end;
+    if (end == yStart || *end != '\0') {
+      throw runtime_error("Malformed CSV line " + to_string(lineNumber) + ".");
+    }
+
+    if (hasCurve && id != currentId) {
+      writer.addCurve(points);
+      ++numCurves;
+      points.clear();
+    }
+    currentId = id;
+    hasCurve = true;
+    points.emplace_back(x, y);
+  }
+  if (hasCurve) {
+    writer.addCurve(points);
+    ++numCurves;
+  }
+  writer.close();
+
+  return numCurves;
+}
+
+// Converts a file with one WKT LINESTRING per line into a curve file
+size_t convertWKTToCurveFile(const string& wktPath, const string& outputPath) {
+  ifstream in(wktPath);
+  if (!in) {
+    throw runtime_error("Cannot open WKT file " + wktPath + ".");
+  }
+
+  CurveFileWriter writer(outputPath);
+  vector<Point_2> points;
+  string line;
+  size_t lineNumber = 0, numCurves = 0;
+  while (getline(in, line)) {
+    ++lineNumber;
+    size_t keyword = line.find("LINESTRING");
+    if (keyword == string::npos) {
+      if (line.find_first_not_of(" \t\r") == string::npos) continue;
+      throw runtime_error("Expected LINESTRING on line " +
+                          to_string(lineNumber) + ".");
+    }
+    size_t open = line.find('(', keyword);
+    size_t close = line.find(')', open);
+    if (open == string::npos || close == string::npos) {
+      throw runtime_error("Malformed LINESTRING on line " +
+                          to_string(lineNumber) + ".");
+    }
+
+    // Parse "x y, x y, ..."
+    points.clear();
+    istringstream coordinates(line.substr(open + 1, close - open - 1));
+    string pair;
+    while (getline(coordinates, pair, ',')) {
+      istringstream values(pair);
+      double x, y;
+      if (!(values >> x >> y)) {
+        throw runtime_error("Malformed coordinate on line " +
+                            to_string(lineNumber) + ".");
+      }
+      points.emplace_back(x, y);
+    }
+    writer.addCurve(points);
+    ++numCurves;
+  }
+  writer.close();
+
+  return numCurves;
+}
@@ -0,0 +1,158 @@
+#include "curve_store.h"
+
+#include <stdexcept>
+
+#include "curve_file.h"
+
+using namespace std;
+
+// Constructor: creates an empty store
+CurveStore::CurveStore() : curveOffsets(1, 0), pyramidsBuilt(false) {}
+
+// Reserves space for curves and points
+void CurveStore::reserve(size_t numCurves, size_t numPoints) {
+  x.reserve(numPoints);
+  y.reserve(numPoints);
+  curveOffsets.reserve(numCurves + 1);
+  summaries.reserve(numCurves);
+}
+
+// Appends a curve given by points
+size_t CurveStore::addCurve(const vector<Point_2>& points) {
+  CurveSummary summary;
+  for (const auto& point : points) {
+    x.push_back(point.x());
+    y.push_back(point.y());
+    summary.addPoint(point.x(), point.y());
+  }
+  curveOffsets.push_back(x.size());
+  summaries.push_back(summary);
+  size_t id = numCurves() - 1;
+  if (pyramidsBuilt) pyramids.emplace_back(getView(id));
+  return id;
+}
+
+// Appends a PolygonalCurve (its summary is reused)
+size_t CurveStore::addCurve(const PolygonalCurve& curve) {
+  CurveView view = curve.view();
+  x.insert(x.end(), view.x, view.x + view.n);
+  y.insert(y.end(), view.y, view.y + view.n);
+  curveOffsets.push_back(x.size());
+  summaries.push_back(curve.summary());
+  size_t id = numCurves() - 1;
+  if (pyramidsBuilt) pyramids.emplace_back(getView(id));
+  return id;
+}
+
+// Appends a curve given by a view
+size_t CurveStore::addCurve(const CurveView& curve) {
+  x.insert(x.end(), curve.x, curve.x + curve.n);
+  y.insert(y.end(), curve.y, curve.y + curve.n);
+  curveOffsets.push_back(x.size());
+  summaries.emplace_back(curve);
+  size_t id = numCurves() - 1;
+  if (pyramidsBuilt) pyramids.emplace_back(getView(id));
+  return id;
+}
+
+// Returns the number of curves
+size_t CurveStore::numCurves() const { return curveOffsets.size() - 1; }
+
+// Returns the total number of points
+size_t CurveStore::numPoints() const { return x.size(); }
+
+// Returns the number of points of a curve
+size_t CurveStore::curveSize(size_t id) const {
+  if (id >= numCurves()) {
+    throw out_of_range("Curve id out of range.");
+  }
+  return curveOffsets[id + 1] - curveOffsets[id];
+}
+
+// Returns a view of a curve
+CurveView CurveStore::getView(size_t id) const {
+  size_t n = curveSize(id);
+  size_t start = curveOffsets[id];
+  return CurveView(x.data() + start, y.data() + start, n);
+}
+
+// Returns the summary of a curve
+const CurveSummary& CurveStore::getSummary(size_t id) const {
+  if (id >= numCurves()) {
+    throw out_of_range("Curve id out of range.");
+  }
+  return summaries[id];
+}
+
+// Returns the x column
+const double* CurveStore::xColumn() const { return x.data(); }
+
+// Returns the y column
+const double* CurveStore::yColumn() const { return y.data(); }
+
+// Returns the offsets array
+const uint64_t* CurveStore::offsets() const { return curveOffsets.data(); }
+
+// Returns a handle of a curve that borrows the columns
+PolygonalCurve CurveStore::getCurve(size_t id) const {
+  return PolygonalCurve::borrow(getView(id), summaries[id]);
+}
+
+// Builds the simplification pyramids of all curves
+void CurveStore::buildPyramids() {
+  pyramids.clear();
+  pyramids.reserve(numCurves());
+  for (size_t id = 0; id < numCurves(); ++id) {
+    pyramids.emplace_back(getView(id));
+  }
+  pyramidsBuilt = true;
+}
+
+// Checks if the pyramids are built
+bool CurveStore::hasPyramids() const { return pyramidsBuilt; }
+
+// Returns the pyramid of a curve
+const SimplificationPyramid& CurveStore::getPyramid(size_t id) const {
+  if (!pyramidsBuilt) {
+    throw logic_error("Simplification pyramids are not built.");
+  }
+  if (id >= numCurves()) {
+    throw out_of_range("Curve id out of range.");
+  }
+  return pyramids[id];
+}
+
+// Removes all curves and pyramids
+void CurveStore::clear() {
+  x.clear();
+  y.clear();
+  curveOffsets.assign(1, 0);
+  summaries.clear();
+  pyramids.clear();
+  pyramidsBuilt = false;
+}
+
+// Writes the store as a curve file
+void CurveStore::save(const string& path) const {
+  CurveFileWriter writer(path);
+  for (size_t id = 0; id < numCurves(); ++id) {
+    writer.addCurve(getView(id), summaries[id]);
+  }
+  writer.close();
+}
+
+// Reads a curve file into a store (the columns are copied in one pass each)
+CurveStore CurveStore::load(const string& path) {
+  MappedCurveFile file(path);
+  CurveStore store;
+  size_t numPoints = file.numPoints();
+  size_t numCurves = file.numCurves();
+  store.x.assign(file.xColumn(), file.xColumn() + numPoints);
+  store.y.assign(file.yColumn(), file.yColumn() + numPoints);
+  store.curveOffsets.assign(file.offsets(), file.offsets() + numCurves + 1);
+  store.summaries.reserve(numCurves);
+  for (size_t id = 0; id < numCurves; ++id) {
+    store.summaries.push_back(file.getSummary(id));
+  }
+  return store;
+}
@@ -0,0 +1,56 @@
+#include "curve_summary.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Constructor: summarizes the points of a curve view
+CurveSummary::CurveSummary(const CurveView& curve) {
+  for (size_t i = 0; i < curve.n; ++i) addPoint(curve.x[i], curve.y[i]);
+}
+
+// Accounts for a point appended to the curve
+void CurveSummary::addPoint(double x, double y) {
+  if (numPoints == 0) {
+    startX = x;
+    startY = y;
+  } else {
+    double dx = x - endX;
+    double dy = y - endY;
+    length += sqrt(dx * dx + dy * dy);
+  }
+  endX = x;
+  endY = y;
+  minX = min(minX, x);
+  minY = min(minY, y);
+  maxX = max(maxX, x);
+  maxY = max(maxY, y);
+  ++numPoints;
+}
+
+// Lower bound of the Hausdorff distance from the bounding boxes
+double hausdorffLowerBound(const CurveSummary& a, const CurveSummary& b) {
+  if (a.numPoints == 0 || b.numPoints == 0) return 0.0;
+  return max(max(fabs(a.minX - b.minX), fabs(a.minY - b.minY)),
+             max(fabs(a.maxX - b.maxX), fabs(a.maxY - b.maxY)));
+}
+
+// Lower bound of the Frechet distance from the end points and the boxes
+double frechetLowerBound(const CurveSummary& a, const CurveSummary& b) {
+  if (a.numPoints == 0 || b.numPoints == 0) return 0.0;
+  double dx = a.startX - b.startX, dy = a.startY - b.startY;
+  double start = sqrt(dx * dx + dy * dy);
+  dx = a.endX - b.endX;
+  dy = a.endY - b.endY;
+  double end = sqrt(dx * dx + dy * dy);
+  return max(max(start, end), hausdorffLowerBound(a, b));
+}
+
+// Upper bound of the Frechet distance from the bounding boxes
+double frechetUpperBound(const CurveSummary& a, const CurveSummary& b) {
+  if (a.numPoints == 0 || b.numPoints == 0) return 0.0;
+  double dx = max(a.maxX - b.minX, b.maxX - a.minX);
+  double dy = max(a.maxY - b.minY, b.maxY - a.minY);
+  return sqrt(dx * dx + dy * dy);
+}
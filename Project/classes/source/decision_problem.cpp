@@ -1,15 +1,42 @@
 #include "decision_problem.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "workspace.h"
+
 using namespace std;
 
+namespace {
+
+const PointPair kEmptyInterval(Point_2(-1, -1), Point_2(-1, -1));
+
+// Intervals that miss each other by less than this still connect. At a Type C
+// critical value two intervals touch in a single point, which must not be
+// lost to rounding.
+const double kTouchTolerance = 1e-9;
+
+// Returns true if the interval is empty
+bool isEmpty(const PointPair& interval) {
+  return interval.first == kEmptyInterval.first;
+}
+
+}  // namespace
+
 // Constructor to initialize with two curves and epsilon
 DecisionProblem::DecisionProblem(const PolygonalCurve& P,
-                                 const PolygonalCurve& Q, double epsilon)
+                                 const PolygonalCurve& Q, double epsilon,
+                                 Workspace* workspace, FreeSpaceMode mode)
     : P(P),
       Q(Q),
       epsilon(epsilon),
-      freeSpace(P, Q, epsilon),
+      freeSpace(P, Q, epsilon, workspace, mode),
+      L_R(workspace ? workspace->reachableL : ownL_R),
+      B_R(workspace ? workspace->reachableB : ownB_R),
+      reachableBottom(workspace ? workspace->reachableBottom : ownBottom),
+      reachableTop(workspace ? workspace->reachableTop : ownTop),
       monotoneCurveExists(false) {
+  STATS_ADD(stats, freeSpaceCells, freeSpace.getNumEvaluated());
   checkMonotoneCurve();
 }
 
@@ -27,15 +54,36 @@ const PolygonalCurve& DecisionProblem::getCurveQ() const { return Q; }
 // Getter for epsilon
 double DecisionProblem::getEpsilon() const { return epsilon; }
 
+// Getter for the counters
+const DecisionStats& DecisionProblem::getStats() const { return stats; }
+
 // Setter for epsilon and recompute monotone curve existence
 void DecisionProblem::setEpsilon(double newEpsilon) {
   epsilon = newEpsilon;
-  freeSpace.setEpsilon(newEpsilon);  // Update FreeSpace with new epsilon
-  checkMonotoneCurve();              // Recheck if a monotone curve exists
+  {
+    STATS_TIMER(stats, freeSpaceSeconds);
+    freeSpace.setEpsilon(newEpsilon);  // Update FreeSpace with new epsilon
+  }
+  STATS_ADD(stats, freeSpaceCells, freeSpace.getNumEvaluated());
+  checkMonotoneCurve();  // Recheck if a monotone curve exists
 }
 
 // Function to check if there is a monotone curve
 void DecisionProblem::checkMonotoneCurve() {
+  STATS_ADD(stats, decisionCalls, 1);
+
+  // A single point has no free space diagram
+  if (P.numPoints() < 2 || Q.numPoints() < 2) {
+    monotoneCurveExists = checkDegenerateCurve();
+    return;
+  }
+
+  if (freeSpace.getMode() == FreeSpaceMode::Sparse) {
+    monotoneCurveExists = checkSparseStartAndEndConditions() &&
+                          checkIfSparseMonotoneCurveExists();
+    return;
+  }
+
   // Step 1: Check start and end conditions
   if (!checkStartAndEndConditions()) {
     monotoneCurveExists = false;
@@ -73,99 +121,213 @@ bool DecisionProblem::checkStartAndEndConditions() {
 
 // Function to check if a monotone curve exists
 bool DecisionProblem::checkIfMonotoneCurveExists() {
+  STATS_TIMER(stats, reachabilitySeconds);
   int p = P.numPoints();
   int q = Q.numPoints();
+  STATS_ADD(stats, reachabilityCells, (p - 1) * (q - 1));
+  const PointPairVector& L = freeSpace.getL();
+  const PointPairVector& B = freeSpace.getB();
 
-  // Step 1: Initialize L_R and B_R
-  PointPairVector L_R((p - 1) * q, {Point_2(-1, -1), Point_2(-1, -1)});
-  PointPairVector B_R((q - 1) * p, {Point_2(-1, -1), Point_2(-1, -1)});
+  // Step 1: Initialize L_R and B_R (the buffers keep their capacity)
+  L_R.assign((p - 1) * q, kEmptyInterval);
+  B_R.assign((q - 1) * p, kEmptyInterval);
 
-  // Set the initial elements based on L and B
+  // The left boundary is reachable while the free intervals are connected
+  // from (0, 0) upwards, and the bottom boundary likewise to the right
   for (int i = 0; i < p - 1; ++i) {
     int index = i * q;
-    if (index < L_R.size()) {
-      L_R[index] = freeSpace.getL()[index];
-    }
+    if (isEmpty(L[index]) || L[index].first.y() != i ||
+        (i > 0 && (isEmpty(L_R[index - q]) || L_R[index - q].second.y() != i)))
+      break;
+    L_R[index] = L[index];
   }
 
   for (int j = 0; j < q - 1; ++j) {
     int index = j * p;
-    if (index < B_R.size()) {
-      B_R[index] = freeSpace.getB()[index];
+    if (isEmpty(B[index]) || B[index].first.x() != j ||
+        (j > 0 && (isEmpty(B_R[index - p]) || B_R[index - p].second.x() != j)))
+      break;
+    B_R[index] = B[index];
+  }
+
+  // Step 2: Propagate through the cells. Cell (i, j) has the left boundary
+  // L[l], the right boundary L[l + 1], the bottom boundary B[b] and the top
+  // boundary B[b + 1].
+  for (int i = 0; i < p - 1; ++i) {
+    for (int j = 0; j < q - 1; ++j) {
+      int l = i * q + j;
+      int b = j * p + i;
+      propagateCell(i, j, L_R[l], B_R[b], L[l + 1], B[b + 1], L_R[l + 1],
+                    B_R[b + 1]);
     }
   }
 
-  // Step 2: Nested loop for processing L_R and B_R
+  // Step 3: Check if (q-1, p-1) is reachable on the boundary of the last cell
+  Point_2 end(q - 1, p - 1);
+  return L_R.back().second == end || B_R.back().second == end;
+}
+
+// Sparse form of checkStartAndEndConditions: (0, 0) must be free on the
+// first row and (q-1, p-1) on the last
+bool DecisionProblem::checkSparseStartAndEndConditions() const {
+  int p = P.numPoints();
+  int q = Q.numPoints();
+  Point_2 startPoint(0, 0);
+  Point_2 endPoint(q - 1, p - 1);
+  auto contains = [](const FreeInterval* first, const FreeInterval* last,
+                     int index, const Point_2& point) {
+    return first != last && first->index == index &&
+           (first->interval.first == point || first->interval.second == point);
+  };
+
+  auto L0 = freeSpace.rowL(0);
+  auto B0 = freeSpace.rowB(0);
+  bool startCondition = contains(L0.first, L0.second, 0, startPoint) ||
+                        contains(B0.first, B0.second, 0, startPoint);
+
+  // The last interval of a row is the one with the largest index
+  auto Ln = freeSpace.rowL(p - 2);
+  auto Bn = freeSpace.rowB(p - 1);
+  bool endCondition =
+      (Ln.first != Ln.second &&
+       contains(Ln.second - 1, Ln.second, q - 1, endPoint)) ||
+      (Bn.first != Bn.second &&
+       contains(Bn.second - 1, Bn.second, q - 2, endPoint));
+
+  return startCondition && endCondition;
+}
+
+// Sparse propagation, row by row. Row i keeps the reachable intervals of its
+// bottom boundary as a sorted list. Within the row, a cell is visited only
+// if its left boundary was reached from the previous cell or its bottom
+// boundary is reachable; runs of cells reachable from neither side are
+// skipped, since all of their boundaries stay unreachable.
+bool DecisionProblem::checkIfSparseMonotoneCurveExists() {
+  STATS_TIMER(stats, reachabilitySeconds);
+  int p = P.numPoints();
+  int q = Q.numPoints();
+
+  // Step 1: The bottom row is reachable while the free intervals are
+  // connected from (0, 0) to the right
+  reachableBottom.clear();
+  auto B0 = freeSpace.rowB(0);
+  int next = 0;
+  for (const FreeInterval* b = B0.first; b != B0.second; ++b) {
+    if (b->index != next || b->interval.first.x() != next) break;
+    reachableBottom.push_back(*b);
+    ++next;
+    if (b->interval.second.x() != next) break;
+  }
+
+  // Step 2: Propagate row by row
+  bool leftColumn = true;  // Left boundary reachable up to the current row
+  PointPair left = kEmptyInterval;
   for (int i = 0; i < p - 1; ++i) {
-    int l_base = i * q;
-    int b_base = i;
+    auto rowL = freeSpace.rowL(i);
+    auto rowTop = freeSpace.rowB(i + 1);
+    const FreeInterval* l = rowL.first;
+    const FreeInterval* t = rowTop.first;
+    reachableTop.clear();
 
-    for (int j = 0; j < q - 1; ++j) {
-      int l = l_base + j;
-      int b = b_base + j * p;
-
-      // Compare L_R[l], B_R[b], and L[l + 1]
-      const auto& point1 = L_R[l].first;
-      const auto& point2 = L_R[l].second;
-      const auto& point3 = B_R[b].first;
-      const auto& point4 = B_R[b].second;
-      const auto& point5 = freeSpace.getL()[l + 1].first;
-      const auto& point6 = freeSpace.getL()[l + 1].second;
-
-      // Task 1: Handling point3 from B_R
-      if (point3 != Point_2(-1, -1)) {
-        L_R[l + 1] = freeSpace.getL()[l + 1];
-      } else {
-        if (point1 == Point_2(-1, -1) || point5 == Point_2(-1, -1)) {
-          L_R[l + 1] = {Point_2(-1, -1), Point_2(-1, -1)};
-        } else {
-          double y_L = std::max(point1.y(), point5.y());
-          double y_U = std::min(point2.y(), point6.y());
-          if (y_L > y_U) {
-            L_R[l + 1] = {Point_2(-1, -1), Point_2(-1, -1)};
-          } else {
-            L_R[l + 1] = {Point_2(j, y_L), Point_2(j, y_U)};
-          }
-        }
-      }
+    // The left boundary of the row is reachable from the one below
+    left = kEmptyInterval;
+    if (leftColumn && l != rowL.second && l->index == 0 &&
+        l->interval.first.y() == i) {
+      left = l->interval;
+    }
+    leftColumn = !isEmpty(left) && left.second.y() == i + 1;
+
+    size_t b = 0;
+    int j = 0;
+    if (isEmpty(left)) {
+      j = reachableBottom.empty() ? q : reachableBottom[0].index;
+    }
+    while (j < q - 1) {
+      const PointPair& bottom =
+          b < reachableBottom.size() && reachableBottom[b].index == j
+              ? reachableBottom[b++].interval
+              : kEmptyInterval;
+      while (l != rowL.second && l->index < j + 1) ++l;
+      const PointPair& freeRight =
+          l != rowL.second && l->index == j + 1 ? l->interval : kEmptyInterval;
+      while (t != rowTop.second && t->index < j) ++t;
+      const PointPair& freeTop =
+          t != rowTop.second && t->index == j ? t->interval : kEmptyInterval;
 
-      // Compare B_R[b], L_R[b], and B[b + 1]
-      const auto& b_point1 = B_R[b].first;
-      const auto& b_point2 = B_R[b].second;
-      const auto& b_point3 = L_R[b].first;
-      const auto& b_point4 = L_R[b].second;
-      const auto& b_point5 = freeSpace.getB()[b + 1].first;
-      const auto& b_point6 = freeSpace.getB()[b + 1].second;
-
-      // Task 2: Handling point3 from L_R
-      if (b_point3 != Point_2(-1, -1)) {
-        B_R[b + 1] = freeSpace.getB()[b + 1];
-      } else {
-        if (b_point1 == Point_2(-1, -1) || b_point5 == Point_2(-1, -1)) {
-          B_R[b + 1] = {Point_2(-1, -1), Point_2(-1, -1)};
-        } else {
-          double x_L = std::max(b_point1.x(), b_point5.x());
-          double x_U = std::min(b_point2.x(), b_point6.x());
-          if (x_L > x_U) {
-            B_R[b + 1] = {Point_2(-1, -1), Point_2(-1, -1)};
-          } else {
-            B_R[b + 1] = {Point_2(x_L, j + 1), Point_2(x_U, j + 1)};
-          }
-        }
+      PointPair right, top;
+      propagateCell(i, j, left, bottom, freeRight, freeTop, right, top);
+      STATS_ADD(stats, reachabilityCells, 1);
+      if (!isEmpty(top)) reachableTop.push_back({j, top});
+      left = right;
+      ++j;
+
+      // Skip to the next cell with a reachable bottom boundary
+      if (isEmpty(left)) {
+        j = b < reachableBottom.size() ? reachableBottom[b].index : q;
       }
     }
+    if (j != q - 1) left = kEmptyInterval;  // The right boundary was skipped
+    swap(reachableBottom, reachableTop);
   }
 
-  // Step 3: Check if a valid path exists
-  Point_2 start(0, 0);
+  // Step 3: Check if (q-1, p-1) is reachable on the boundary of the last cell
   Point_2 end(q - 1, p - 1);
+  return (!isEmpty(left) && left.second == end) ||
+         (!reachableBottom.empty() && reachableBottom.back().index == q - 2 &&
+          reachableBottom.back().interval.second == end);
+}
+
+// Propagates reachability through cell (i, j). Every free point of the right
+// boundary is reachable from the bottom, and the points above the lowest
+// reachable one from the left; the top boundary is symmetric.
+void DecisionProblem::propagateCell(int i, int j, const PointPair& left,
+                                    const PointPair& bottom,
+                                    const PointPair& freeRight,
+                                    const PointPair& freeTop, PointPair& right,
+                                    PointPair& top) {
+  // Task 1: Right boundary
+  right = kEmptyInterval;
+  if (!isEmpty(freeRight)) {
+    if (!isEmpty(bottom)) {
+      right = freeRight;
+    } else if (!isEmpty(left)) {
+      double y_L = max(left.first.y(), freeRight.first.y());
+      double y_U = freeRight.second.y();
+      if (y_L <= y_U + kTouchTolerance) {
+        y_L = min(y_L, y_U);
+        right = {Point_2(j + 1, y_L), Point_2(j + 1, y_U)};
+      }
+    }
+  }
 
-  if ((L_R[0].first == start || L_R[0].second == start ||
-       B_R[0].first == start || B_R[0].second == start) &&
-      (L_R.back().first == end || L_R.back().second == end ||
-       B_R.back().first == end || B_R.back().second == end)) {
-    return true;
+  // Task 2: Top boundary
+  top = kEmptyInterval;
+  if (!isEmpty(freeTop)) {
+    if (!isEmpty(left)) {
+      top = freeTop;
+    } else if (!isEmpty(bottom)) {
+      double x_L = max(bottom.first.x(), freeTop.first.x());
+      double x_U = freeTop.second.x();
+      if (x_L <= x_U + kTouchTolerance) {
+        x_L = min(x_L, x_U);
+        top = {Point_2(x_L, i + 1), Point_2(x_U, i + 1)};
+      }
+    }
   }
+}
 
-  return false;
+// Decides the case where one of the curves is a single point: every vertex of
+// the other curve must be within epsilon of that point. The distances are
+// compared as FDistance computes them, so its result is always accepted
+// (the square of a rounded square root may exceed the squared distance).
+bool DecisionProblem::checkDegenerateCurve() const {
+  if (P.numPoints() == 0 || Q.numPoints() == 0) return false;
+  const PolygonalCurve& point = P.numPoints() < 2 ? P : Q;
+  const PolygonalCurve& curve = P.numPoints() < 2 ? Q : P;
+  for (size_t i = 0; i < curve.numPoints(); ++i) {
+    double dx = curve.getPoint(i).x() - point.getPoint(0).x();
+    double dy = curve.getPoint(i).y() - point.getPoint(0).y();
+    if (sqrt(dx * dx + dy * dy) > epsilon) return false;
+  }
+  return true;
 }
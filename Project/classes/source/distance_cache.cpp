@@ -0,0 +1,372 @@
+#include "distance_cache.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "fdistance.h"
+#include "ged.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+const char kCacheMagic[8] = {'P', 'S', 'C', 'A', 'C', 'H', 'E', '1'};
+
+// Seeds of the two hash lanes and of the record checksums
+const uint64_t kLowSeed = 0x243F6A8885A308D3ULL;
+const uint64_t kHighSeed = 0x13198A2E03707344ULL;
+const uint64_t kCheckSeed = 0xA4093822299F31D0ULL;
+
+// Record of the disk tier
+struct DiskRecord {
+  uint64_t low;
+  uint64_t high;
+  double value;
+  uint64_t check;  // Detects torn and foreign records
+};
+
+// Header of the disk tier
+struct DiskHeader {
+  char magic[8];
+  uint64_t recordSize;
+};
+
+// Records read per pread while scanning the disk tier
+const size_t kScanRecords = 4096;
+
+// Bijective 64-bit mixer (the splitmix64 finalizer)
+uint64_t mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return h;
+}
+
+// Feeds a word into a lane; the rotation makes the lane order-dependent
+uint64_t absorb(uint64_t lane, uint64_t word, uint64_t seed) {
+  lane ^= mix(word + seed);
+  return (lane << 27 | lane >> 37) * 0x9E3779B97F4A7C15ULL;
+}
+
+uint64_t doubleBits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+uint64_t recordCheck(uint64_t low, uint64_t high, double value) {
+  return mix(low ^ (high << 17 | high >> 47) ^ mix(doubleBits(value)) ^
+             kCheckSeed);
+}
+
+bool validRecord(const DiskRecord& record) {
+  return record.check == recordCheck(record.low, record.high, record.value);
+}
+
+// Exclusive lock of the disk tier among processes (threads of one process
+// share the descriptor and are ordered by diskLock)
+class FileLock {
+ public:
+  explicit FileLock(int fd) : fd(fd) {
+    while (flock(fd, LOCK_EX) != 0) {
+      if (errno != EINTR) throw runtime_error("Cannot lock the cache.");
+    }
+  }
+  ~FileLock() { flock(fd, LOCK_UN); }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+ private:
+  int fd;
+};
+
+}  // namespace
+
+// Hashes the x and y columns of a curve
+CurveDigest curveDigest(const PolygonalCurve& curve) {
+  size_t n = curve.numPoints();
+  uint64_t low = absorb(kLowSeed, n, kLowSeed);
+  uint64_t high = absorb(kHighSeed, n, kHighSeed);
+  for (const double* column : {curve.xData(), curve.yData()}) {
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t bits = doubleBits(column[i]);
+      low = absorb(low, bits, kLowSeed);
+      high = absorb(high, bits, kHighSeed);
+    }
+  }
+  return {mix(low), mix(high)};
+}
+
+// Key of a cached distance
+DistanceKey distanceKey(const CurveDigest& P, const CurveDigest& Q,
+                        CachedEngine engine, uint64_t parameters) {
+  uint64_t words[] = {P.low, P.high, Q.low, Q.high,
+                      static_cast<uint64_t>(engine), parameters};
+  uint64_t low = kLowSeed, high = kHighSeed;
+  for (uint64_t word : words) {
+    low = absorb(low, word, kLowSeed);
+    high = absorb(high, word, kHighSeed);
+  }
+  return {mix(low), mix(high)};
+}
+
+// Constructor to open (or create) the disk tier
+DistanceCache::DistanceCache(const DistanceCacheOptions& options)
+    : options(options),
+      fd(-1),
+      fileSize(0),
+      memoryHits(0),
+      diskHits(0),
+      misses(0),
+      insertions(0),
+      evictions(0) {
+  size_t numShards = max<size_t>(1, options.numShards);
+  shardCapacity = max<size_t>(1, options.capacity / numShards);
+  for (size_t s = 0; s < numShards; ++s) shards.emplace_back(new Shard());
+  if (!options.path.empty()) openDisk();
+}
+
+// Destructor (closes the disk tier)
+DistanceCache::~DistanceCache() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+// Syncs and closes the disk tier
+void DistanceCache::close() {
+  lock_guard<mutex> lock(diskLock);
+  if (fd < 0) return;
+  bool synced = fdatasync(fd) == 0;
+  ::close(fd);
+  fd = -1;
+  if (!synced) {
+    throw runtime_error("Failed to write cache " + options.path + ".");
+  }
+}
+
+// Opens the disk tier, scans it and drops a torn tail
+void DistanceCache::openDisk() {
+  fd = open(options.path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw runtime_error("Cannot open cache " + options.path + ".");
+  }
+  try {
+    // Another process may be creating or appending to the file
+    FileLock fileLock(fd);
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      throw runtime_error("Cannot open cache " + options.path + ".");
+    }
+
+    // Step 1: A new file gets the header
+    DiskHeader header;
+    if (info.st_size == 0) {
+      memcpy(header.magic, kCacheMagic, 8);
+      header.recordSize = sizeof(DiskRecord);
+      if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        throw runtime_error("Cannot write cache " + options.path + ".");
+      }
+    } else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+               memcmp(header.magic, kCacheMagic, 8) != 0 ||
+               header.recordSize != sizeof(DiskRecord)) {
+      throw runtime_error(options.path + " is not a distance cache.");
+    }
+
+    // Step 2: Index the records and cut off a torn one
+    lock_guard<mutex> lock(diskLock);
+    fileSize = sizeof(DiskHeader);
+    scanTail(true);
+  } catch (...) {
+    ::close(fd);
+    fd = -1;
+    throw;
+  }
+}
+
+// Indexes the records after fileSize up to the first invalid one
+void DistanceCache::scanTail(bool truncate) {
+  vector<DiskRecord> records(kScanRecords);
+  bool valid = true;
+  while (valid) {
+    ssize_t bytes = pread(fd, records.data(),
+                          records.size() * sizeof(DiskRecord), fileSize);
+    size_t count = bytes > 0 ? bytes / sizeof(DiskRecord) : 0;
+    if (count == 0) break;
+    for (size_t r = 0; r < count; ++r) {
+      if (!validRecord(records[r])) {
+        valid = false;
+        break;
+      }
+      diskIndex.emplace(records[r].low, fileSize);  // The first one stays
+      fileSize += sizeof(DiskRecord);
+    }
+  }
+
+  // Appends continue after the last valid record. Without the file lock a
+  // bad record may still be in flight, so it is left to its writer.
+  struct stat info;
+  if (truncate && fstat(fd, &info) == 0 &&
+      static_cast<uint64_t>(info.st_size) > fileSize &&
+      ftruncate(fd, fileSize) != 0) {
+    throw runtime_error("Cannot truncate cache " + options.path + ".");
+  }
+}
+
+// Looks a key up in the memory tier and marks it as most recent
+bool DistanceCache::lookupMemory(const DistanceKey& key, double& value) {
+  Shard& shard = *shards[key.high % shards.size()];
+  lock_guard<mutex> lock(shard.lock);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) return false;
+  shard.order.splice(shard.order.begin(), shard.order, it->second);
+  value = it->second->second;
+  return true;
+}
+
+// Inserts a key into the memory tier and evicts the least recent entry
+void DistanceCache::insertMemory(const DistanceKey& key, double value) {
+  Shard& shard = *shards[key.high % shards.size()];
+  lock_guard<mutex> lock(shard.lock);
+  if (shard.index.count(key)) return;  // The first value stays
+  shard.order.emplace_front(key, value);
+  shard.index[key] = shard.order.begin();
+  if (shard.order.size() > shardCapacity) {
+    shard.index.erase(shard.order.back().first);
+    shard.order.pop_back();
+    ++evictions;
+  }
+}
+
+// Reads a key back from the disk tier
+bool DistanceCache::lookupDisk(const DistanceKey& key, double& value) {
+  if (fd < 0) return false;
+  uint64_t offset;
+  {
+    lock_guard<mutex> lock(diskLock);
+    if (fd < 0) return false;
+    auto it = diskIndex.find(key.low);
+    if (it == diskIndex.end()) {
+      // Another process may have appended the key since the last scan
+      scanTail(false);
+      it = diskIndex.find(key.low);
+      if (it == diskIndex.end()) return false;
+    }
+    offset = it->second;
+  }
+  DiskRecord record;
+  if (pread(fd, &record, sizeof(record), offset) != sizeof(record) ||
+      !validRecord(record) || record.low != key.low ||
+      record.high != key.high) {
+    return false;
+  }
+  value = record.value;
+  return true;
+}
+
+// Appends a key to the disk tier (keys already there are skipped)
+void DistanceCache::appendDisk(const DistanceKey& key, double value) {
+  if (fd < 0) return;
+  DiskRecord record{key.low, key.high, value,
+                    recordCheck(key.low, key.high, value)};
+  lock_guard<mutex> lock(diskLock);
+  if (fd < 0 || diskIndex.count(key.low)) return;
+
+  // The end of the file may have moved: index the records of the other
+  // processes first, so the record goes after them and is not a duplicate
+  FileLock fileLock(fd);
+  scanTail(true);
+  if (diskIndex.count(key.low)) return;
+  if (pwrite(fd, &record, sizeof(record), fileSize) != sizeof(record)) {
+    throw runtime_error("Failed to write cache " + options.path + ".");
+  }
+  diskIndex[key.low] = fileSize;
+  fileSize += sizeof(record);
+  if (options.syncWrites && fdatasync(fd) != 0) {
+    throw runtime_error("Failed to write cache " + options.path + ".");
+  }
+}
+
+// Looks a key up in both tiers
+bool DistanceCache::lookup(const DistanceKey& key, double& value) {
+  if (lookupMemory(key, value)) {
+    ++memoryHits;
+    return true;
+  }
+  if (lookupDisk(key, value)) {
+    ++diskHits;
+    insertMemory(key, value);
+    return true;
+  }
+  ++misses;
+  return false;
+}
+
+// Inserts a value into both tiers
+void DistanceCache::insert(const DistanceKey& key, double value) {
+  ++insertions;
+  insertMemory(key, value);
+  appendDisk(key, value);
+}
+
+// Cached FDistance
+double DistanceCache::frechetDistance(const PolygonalCurve& P,
+                                      const PolygonalCurve& Q,
+                                      Workspace* workspace,
+                                      FreeSpaceMode mode) {
+  DistanceKey key = distanceKey(curveDigest(P), curveDigest(Q),
+                                CachedEngine::FrechetDistance);
+  double value;
+  if (lookup(key, value)) return value;
+  value = FDistance(P, Q, workspace, mode).getFDistance();
+  insert(key, value);
+  return value;
+}
+
+// Cached GED::computeSquareRootApproxGED
+double DistanceCache::approximateGED(const PolygonalCurve& P,
+                                     const PolygonalCurve& Q,
+                                     Workspace* workspace) {
+  DistanceKey key = distanceKey(curveDigest(P), curveDigest(Q),
+                                CachedEngine::ApproximateGED);
+  double value;
+  if (lookup(key, value)) return value;
+  value = GED::computeSquareRootApproxGED(P, Q, nullptr, workspace);
+  insert(key, value);
+  return value;
+}
+
+// Writes the appended records to the device
+void DistanceCache::flush() {
+  lock_guard<mutex> lock(diskLock);
+  if (fd >= 0 && fdatasync(fd) != 0) {
+    throw runtime_error("Failed to write cache " + options.path + ".");
+  }
+}
+
+// Getter for a snapshot of the counters
+DistanceCacheStats DistanceCache::getStats() const {
+  DistanceCacheStats stats;
+  stats.memoryHits = memoryHits;
+  stats.diskHits = diskHits;
+  stats.misses = misses;
+  stats.insertions = insertions;
+  stats.evictions = evictions;
+  {
+    lock_guard<mutex> lock(diskLock);
+    stats.diskEntries = diskIndex.size();
+  }
+  return stats;
+}
@@ -0,0 +1,863 @@
+#include "distance_matrix.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "curve_file.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+const char kMatrixFileMagic[8] = {'P', 'S', 'M', 'A', 'T', 'R', 'X', '1'};
+const char kJournalMagic[] = "PSJOURNAL1";
+
+// Rows [row0, row1) and columns [col0, col1) of the matrix
+struct Tile {
+  size_t id;    // band * tiles per band + column tile
+  size_t band;  // Row tile
+  size_t row0, row1, col0, col1;
+  double cost;  // Estimated cost from the curve sizes
+};
+
+// Tiles of a run and the units the journal records (tiles, or bands for
+// TopK) with their shards
+struct MatrixLayout {
+  size_t tileSize;
+  size_t numBands;
+  vector<Tile> tiles;         // Band by band
+  size_t numUnits;            // Unit ids are below numUnits
+  vector<size_t> unitShard;   // Shard of every unit id (numShards: none)
+  bool bandUnits;             // True if the units are bands
+
+  size_t unitOf(const Tile& tile) const {
+    return bandUnits ? tile.band : tile.id;
+  }
+};
+
+// Line that identifies the run; a journal resumes only the same run
+string journalHeader(const MatrixOptions& options, size_t numCurves,
+                     size_t tileSize) {
+  ostringstream out;
+  out.precision(17);
+  out << kJournalMagic << ' ' << numCurves << ' ' << tileSize << ' '
+      << static_cast<int>(options.metric) << ' '
+      << static_cast<int>(options.output) << ' ' << options.topK << ' '
+      << options.epsilon << ' ' << options.symmetric << ' ' << options.window
+      << ' ' << static_cast<int>(options.freeSpaceMode) << ' '
+      << options.shardIndex << ' ' << options.numShards << ' '
+      << options.seed;
+  return out.str();
+}
+
+// Journal content of earlier runs
+struct JournalState {
+  vector<char> completed;    // 1 for the recorded units
+  size_t numCompleted = 0;   // Number of such units
+  uint64_t sparseBytes = 0;  // Valid bytes of the sparse output
+  uint64_t validBytes = 0;   // Bytes up to the last complete line
+};
+
+// Reads a journal; returns false if it is missing or belongs to another
+// run. A line counts only once its newline was written.
+bool readJournal(const string& path, const string& header, size_t numUnits,
+                 JournalState& state) {
+  state = JournalState();
+  state.completed.assign(numUnits, 0);
+  ifstream in(path, ios::binary);
+  string line;
+  if (!getline(in, line) || in.eof() || line != header) return false;
+  state.validBytes = line.size() + 1;
+  while (getline(in, line) && !in.eof()) {
+    unsigned long long unit = 0, bytes = 0;
+    if (sscanf(line.c_str(), "%llu %llu", &unit, &bytes) != 2 ||
+        unit >= numUnits) {
+      break;
+    }
+    if (!state.completed[unit]) ++state.numCompleted;
+    state.completed[unit] = 1;
+    state.sparseBytes = max<uint64_t>(state.sparseBytes, bytes);
+    state.validBytes += line.size() + 1;
+  }
+  return true;
+}
+
+// Append-only record of the completed units (tiles, or bands for TopK) and
+// the size of the sparse output after each. Every line is synced before the
+// next unit is recorded, and a torn last line is dropped on reading.
+class ProgressJournal {
+ public:
+  ProgressJournal(const string& path, const string& header, size_t numUnits,
+                  bool resume) {
+    bool matches = resume && readJournal(path, header, numUnits, state);
+    if (!matches) state.completed.assign(numUnits, 0);
+
+    if (matches) {
+      if (truncate(path.c_str(), state.validBytes) != 0) {
+        throw runtime_error("Cannot truncate journal " + path + ".");
+      }
+      file = fopen(path.c_str(), "ab");
+    } else {
+      file = fopen(path.c_str(), "wb");
+      if (file) fprintf(file, "%s\n", header.c_str());
+    }
+    if (!file || fflush(file) != 0 || fsync(fileno(file)) != 0) {
+      throw runtime_error("Cannot write journal " + path + ".");
+    }
+    resumed = matches;
+  }
+
+  ~ProgressJournal() {
+    if (file) fclose(file);
+  }
+
+  ProgressJournal(const ProgressJournal&) = delete;
+  ProgressJournal& operator=(const ProgressJournal&) = delete;
+
+  // Records a completed unit (its output must already be durable)
+  void record(size_t unit, uint64_t sparseSize) {
+    fprintf(file, "%llu %llu\n", static_cast<unsigned long long>(unit),
+            static_cast<unsigned long long>(sparseSize));
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+      throw runtime_error("Failed to write the journal.");
+    }
+  }
+
+  JournalState state;  // Units of earlier runs
+  bool resumed;        // True if the journal matched the run
+
+ private:
+  FILE* file;
+};
+
+// Writable mapping of a dense matrix file with n columns, or of the rows
+// [firstRow, firstRow + numRows) of one (a shard)
+class MatrixMapping {
+ public:
+  MatrixMapping(const string& path, uint64_t n, uint64_t firstRow,
+                uint64_t numRows, bool reuse)
+      : data(nullptr), size(0), n(n), firstRow(firstRow), fresh(true) {
+    uint64_t dataOffset = kMatrixFileAlignment;
+    size = dataOffset + numRows * n * sizeof(double);
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | (reuse ? 0 : O_TRUNC),
+                  0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+      if (fd >= 0) ::close(fd);
+      throw runtime_error("Cannot open matrix file " + path + ".");
+    }
+    fresh = static_cast<uint64_t>(info.st_size) != size;
+    if (fresh && ftruncate(fd, size) != 0) {
+      ::close(fd);
+      throw runtime_error("Cannot resize matrix file " + path + ".");
+    }
+    void* mapping =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping stays valid after closing the descriptor
+    if (mapping == MAP_FAILED) {
+      throw runtime_error("Cannot map matrix file " + path + ".");
+    }
+    data = static_cast<char*>(mapping);
+
+    // A reused file must be the same matrix
+    MatrixFileHeader* header = reinterpret_cast<MatrixFileHeader*>(data);
+    if (!fresh && (memcmp(header->magic, kMatrixFileMagic, 8) != 0 ||
+                   header->numRows != numRows || header->numColumns != n ||
+                   header->firstRow != firstRow)) {
+      munmap(data, size);
+      throw runtime_error("Matrix file " + path + " does not match the run.");
+    }
+    memcpy(header->magic, kMatrixFileMagic, 8);
+    header->numRows = numRows;
+    header->numColumns = n;
+    header->dataOffset = dataOffset;
+    header->firstRow = firstRow;
+    entries = reinterpret_cast<double*>(data + dataOffset);
+  }
+
+  ~MatrixMapping() { munmap(data, size); }
+
+  MatrixMapping(const MatrixMapping&) = delete;
+  MatrixMapping& operator=(const MatrixMapping&) = delete;
+
+  // Row i of the matrix (firstRow <= i < firstRow + numRows)
+  double* row(uint64_t i) { return entries + (i - firstRow) * n; }
+
+  // True if the file was created (or had the wrong size) and is all zeros
+  bool isFresh() const { return fresh; }
+
+  // Writes entries [col0, col1) of rows [row0, row1) back to the file
+  void flush(uint64_t row0, uint64_t row1, uint64_t col0, uint64_t col1) {
+    uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    for (uint64_t i = row0; i < row1; ++i) {
+      uintptr_t begin = reinterpret_cast<uintptr_t>(row(i) + col0);
+      uintptr_t end = reinterpret_cast<uintptr_t>(row(i) + col1);
+      begin -= begin % page;
+      if (msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC) != 0) {
+        throw runtime_error("Failed to write the matrix file.");
+      }
+    }
+  }
+
+  // Writes the header back to the file
+  void flushHeader() {
+    if (msync(data, kMatrixFileAlignment, MS_SYNC) != 0) {
+      throw runtime_error("Failed to write the matrix file.");
+    }
+  }
+
+ private:
+  char* data;
+  uint64_t size;
+  uint64_t n;
+  uint64_t firstRow;
+  bool fresh;
+  double* entries;
+};
+
+// Append-only BatchRecord file
+class SparseOutput {
+ public:
+  SparseOutput(const string& path, uint64_t validBytes) : bytes(validBytes) {
+    fd = open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+      if (fd >= 0) ::close(fd);
+      throw runtime_error("Cannot open output " + path + ".");
+    }
+    // Records past the journal belong to unfinished units
+    if (static_cast<uint64_t>(info.st_size) < validBytes ||
+        ftruncate(fd, validBytes) != 0) {
+      ::close(fd);
+      throw runtime_error("Output " + path +
+                          " is shorter than its journal; use --restart.");
+    }
+  }
+
+  ~SparseOutput() { ::close(fd); }
+
+  SparseOutput(const SparseOutput&) = delete;
+  SparseOutput& operator=(const SparseOutput&) = delete;
+
+  // Appends and syncs records; returns the new size in bytes
+  uint64_t append(const vector<BatchRecord>& records) {
+    const char* source = reinterpret_cast<const char*>(records.data());
+    size_t remaining = records.size() * sizeof(BatchRecord);
+    while (remaining > 0) {
+      ssize_t written = pwrite(fd, source, remaining, bytes);
+      if (written <= 0) throw runtime_error("Failed to write the output.");
+      source += written;
+      bytes += written;
+      remaining -= written;
+    }
+    if (fsync(fd) != 0) throw runtime_error("Failed to write the output.");
+    return bytes;
+  }
+
+  uint64_t size() const { return bytes; }
+
+ private:
+  int fd;
+  uint64_t bytes;
+};
+
+// Rows of a band of tiles that collect their k smallest entries (TopK)
+struct BandState {
+  mutex lock;
+  size_t remainingTiles;
+  vector<vector<pair<double, uint64_t>>> rows;  // Max-heaps by value
+};
+
+// Offers an entry to the max-heap of the k smallest entries of a row
+void offerEntry(vector<pair<double, uint64_t>>& heap, size_t k, double value,
+                uint64_t column) {
+  if (heap.size() < k) {
+    heap.emplace_back(value, column);
+    push_heap(heap.begin(), heap.end());
+  } else if (make_pair(value, column) < heap.front()) {
+    pop_heap(heap.begin(), heap.end());
+    heap.back() = make_pair(value, column);
+    push_heap(heap.begin(), heap.end());
+  }
+}
+
+// Computes an entry that is only needed if it is at most bound. For FD the
+// decision at the bound (after the summary and Hausdorff filters) rejects
+// the entry without the binary search. Returns false if the entry exceeds
+// the bound.
+bool entryWithin(const MappedCurveFile& store, const BatchOptions& metric,
+                 uint64_t i, uint64_t j, double bound, Workspace& workspace,
+                 double& value) {
+  if (metric.metric == BatchMetric::FrechetDistance && isfinite(bound)) {
+    BatchOptions decision = metric;
+    decision.metric = BatchMetric::Threshold;
+    decision.epsilon = bound;
+    if (computeBatchMetric(store, decision, i, j, workspace) == 0.0) {
+      return false;
+    }
+  }
+  value = computeBatchMetric(store, metric, i, j, workspace);
+  return value <= bound;
+}
+
+// Tiles, units and shards of a run. Every process of a sharded run builds
+// the same layout from the curve file and the options.
+MatrixLayout buildLayout(const MappedCurveFile& store,
+                         const MatrixOptions& options) {
+  size_t n = store.numCurves();
+  MatrixLayout layout;
+  layout.tileSize = chooseTileSize(store, options);
+  layout.numBands = (n + layout.tileSize - 1) / layout.tileSize;
+  layout.bandUnits = options.output == MatrixOutput::TopK;
+  layout.numUnits =
+      layout.bandUnits ? layout.numBands : layout.numBands * layout.numBands;
+
+  // Step 1: Prefix sums of the sizes and squared sizes of the curves
+  vector<double> sizes(n + 1, 0.0), squares(n + 1, 0.0);
+  for (size_t i = 0; i < n; ++i) {
+    double size = static_cast<double>(store.curveSize(i));
+    sizes[i + 1] = sizes[i] + size;
+    squares[i + 1] = squares[i] + size * size;
+  }
+
+  // Step 2: Tiles, band by band, so the bands of TopK complete in order.
+  // A pair costs pq cells, and the critical values of FD add p^2 q + p q^2;
+  // both sum over a tile in O(1).
+  bool criticalValues = options.metric == BatchMetric::FrechetDistance ||
+                        options.metric == BatchMetric::WeakFrechetDistance;
+  size_t t = layout.tileSize;
+  for (size_t band = 0; band < layout.numBands; ++band) {
+    for (size_t c = options.symmetric ? band : 0; c < layout.numBands; ++c) {
+      Tile tile{band * layout.numBands + c, band, band * t,
+                min(n, (band + 1) * t), c * t, min(n, (c + 1) * t), 0.0};
+      double rowSizes = sizes[tile.row1] - sizes[tile.row0];
+      double colSizes = sizes[tile.col1] - sizes[tile.col0];
+      tile.cost = rowSizes * colSizes;
+      if (criticalValues) {
+        tile.cost += (squares[tile.row1] - squares[tile.row0]) * colSizes +
+                     rowSizes * (squares[tile.col1] - squares[tile.col0]);
+      }
+      if (options.symmetric && c == band) tile.cost /= 2;
+      layout.tiles.push_back(tile);
+    }
+  }
+
+  // Step 3: Contiguous runs of units with equal shares of the total cost.
+  // A unit goes to the shard that contains the middle of its cost.
+  vector<double> unitCosts(layout.numUnits, 0.0);
+  vector<size_t> order;
+  for (const auto& tile : layout.tiles) {
+    size_t unit = layout.unitOf(tile);
+    if (order.empty() || order.back() != unit) order.push_back(unit);
+    unitCosts[unit] += tile.cost;
+  }
+  double total = 0.0;
+  for (size_t unit : order) total += unitCosts[unit];
+  layout.unitShard.assign(layout.numUnits, options.numShards);  // No tiles
+  double before = 0.0;
+  for (size_t k = 0; k < order.size(); ++k) {
+    size_t unit = order[k];
+    double share = total > 0.0
+                       ? (before + unitCosts[unit] / 2) / total
+                       : (k + 0.5) / order.size();
+    layout.unitShard[unit] = min(options.numShards - 1,
+                                 static_cast<size_t>(share * options.numShards));
+    before += unitCosts[unit];
+  }
+  return layout;
+}
+
+// Rows covered by the tiles of a shard, [first, second). A run with one
+// shard covers the whole matrix.
+pair<size_t, size_t> shardRows(const MatrixLayout& layout,
+                               const MatrixOptions& options, size_t n,
+                               size_t shard) {
+  if (options.numShards <= 1) return {0, n};
+  size_t first = n, last = 0;
+  for (const auto& tile : layout.tiles) {
+    if (layout.unitShard[layout.unitOf(tile)] != shard) continue;
+    first = min(first, tile.row0);
+    last = max(last, tile.row1);
+  }
+  return first < last ? make_pair(first, last) : make_pair(n, n);
+}
+
+// Output and journal of a shard (of the run itself if it has one shard)
+string outputPathOf(const MatrixOptions& options, size_t shard) {
+  return options.numShards > 1 ? shardOutputPath(options.outputPath, shard)
+                               : options.outputPath;
+}
+
+string journalPathOf(const MatrixOptions& options, size_t shard) {
+  if (options.journalPath.empty()) {
+    return outputPathOf(options, shard) + ".journal";
+  }
+  return options.numShards > 1 ? shardOutputPath(options.journalPath, shard)
+                               : options.journalPath;
+}
+
+// Checks the options shared by runs and merges
+void validateOptions(const MatrixOptions& options) {
+  if (options.symmetric && options.output == MatrixOutput::TopK) {
+    throw invalid_argument("TopK output needs the full rows (no symmetric).");
+  }
+  if (options.output == MatrixOutput::TopK && options.topK == 0) {
+    throw invalid_argument("TopK output needs k > 0.");
+  }
+  if (options.numShards == 0 || options.shardIndex >= options.numShards) {
+    throw invalid_argument("Shard index out of range.");
+  }
+}
+
+}  // namespace
+
+// Output of one shard
+string shardOutputPath(const string& outputPath, size_t shard) {
+  return outputPath + ".shard" + to_string(shard);
+}
+
+// Tile size for a curve file
+size_t chooseTileSize(const MappedCurveFile& store,
+                      const MatrixOptions& options) {
+  size_t n = store.numCurves();
+  if (options.tileSize > 0) return min(options.tileSize, max<size_t>(n, 1));
+
+  // Step 1: One tile row and one tile column of curves stay in the cache
+  double pointsPerCurve =
+      n > 0 ? static_cast<double>(store.numPoints()) / n : 1.0;
+  double curveBytes = max(pointsPerCurve, 1.0) * 2 * sizeof(double);
+  double size = options.cacheBytes / (2 * curveBytes);
+
+  // Step 2: The sparse records of the tiles in flight fit in the budget. The
+  // shards of a run must agree on the size, so they ignore the hardware.
+  size_t threads = options.numThreads > 0 ? options.numThreads : 1;
+  if (options.numShards <= 1 && options.numThreads == 0) {
+    threads = max<size_t>(1, thread::hardware_concurrency());
+  }
+  size = min(size, sqrt(static_cast<double>(options.memoryBudget) /
+                        (threads * sizeof(BatchRecord))));
+  return min(max<size_t>(n, 1), max<size_t>(static_cast<size_t>(size), 1));
+}
+
+// Computes the all-pairs matrix tile by tile
+MatrixProgress runMatrix(const MatrixOptions& options) {
+  validateOptions(options);
+  MappedCurveFile store(options.storePath);
+  size_t n = store.numCurves();
+
+  // Step 1: Tiles of this shard
+  MatrixLayout layout = buildLayout(store, options);
+  MatrixProgress progress;
+  progress.tileSize = layout.tileSize;
+  vector<const Tile*> tiles;
+  for (const auto& tile : layout.tiles) {
+    if (layout.unitShard[layout.unitOf(tile)] == options.shardIndex) {
+      tiles.push_back(&tile);
+    }
+  }
+  progress.numTiles = tiles.size();
+
+  // Step 2: Journal and output. TopK records bands, the others tiles.
+  bool topK = options.output == MatrixOutput::TopK;
+  bool dense = options.output == MatrixOutput::Dense;
+  string outputPath = outputPathOf(options, options.shardIndex);
+  ProgressJournal journal(journalPathOf(options, options.shardIndex),
+                          journalHeader(options, n, layout.tileSize),
+                          layout.numUnits, options.resume);
+  const JournalState& earlier = journal.state;
+  unique_ptr<MatrixMapping> mapping;
+  unique_ptr<SparseOutput> sparse;
+  // A shard maps only its rows and leaves the mirrored entries to the merge
+  bool mirror = options.symmetric && options.numShards == 1;
+  if (dense) {
+    pair<size_t, size_t> rows = shardRows(layout, options, n,
+                                          options.shardIndex);
+    mapping.reset(new MatrixMapping(outputPath, n, rows.first,
+                                    rows.second - rows.first,
+                                    journal.resumed));
+    if (journal.resumed && earlier.numCompleted > 0 && mapping->isFresh()) {
+      throw runtime_error("Matrix file " + outputPath +
+                          " does not match its journal; use --restart.");
+    }
+    mapping->flushHeader();
+  } else {
+    sparse.reset(new SparseOutput(outputPath,
+                                  journal.resumed ? earlier.sparseBytes : 0));
+  }
+
+  vector<const Tile*> pending;
+  vector<unique_ptr<BandState>> bands(layout.numBands);
+  for (const Tile* tile : tiles) {
+    if (earlier.completed[layout.unitOf(*tile)]) {
+      ++progress.resumedTiles;
+      continue;
+    }
+    pending.push_back(tile);
+    if (topK) {
+      auto& band = bands[tile->band];
+      if (!band) {
+        band.reset(new BandState());
+        band->remainingTiles = 0;
+        band->rows.resize(tile->row1 - tile->row0);
+      }
+      ++band->remainingTiles;
+    }
+  }
+
+  BatchOptions metric;
+  metric.metric = options.metric;
+  metric.epsilon = options.epsilon;
+  metric.freeSpaceMode = options.freeSpaceMode;
+  metric.window = options.window;
+
+  // Step 3: Workers take the pending tiles in order
+  atomic<size_t> nextTile(0);
+  atomic<bool> failed(false);
+  mutex outputMutex;
+  string error;
+  auto fail = [&](const string& message) {
+    lock_guard<mutex> lock(outputMutex);
+    if (error.empty()) error = message;
+    failed = true;
+  };
+
+  {
+    ThreadPool pool(options.numThreads);
+    for (size_t t = 0; t < pool.numThreads(); ++t) {
+      pool.submit([&]() {
+        Workspace workspace;  // Reused for every tile of this worker
+        vector<BatchRecord> records;
+        vector<vector<pair<double, uint64_t>>> heaps;
+        try {
+          for (size_t index = nextTile++; index < pending.size() && !failed;
+               index = nextTile++) {
+            const Tile& tile = *pending[index];
+            records.clear();
+            seed_seq seed{options.seed, static_cast<uint32_t>(tile.id)};
+            workspace.generator.seed(seed);  // GED shifts of this tile
+            heaps.assign(topK ? tile.row1 - tile.row0 : 0, {});
+
+            // Task 1: Entries. The row curve stays hot across the columns.
+            for (uint64_t i = tile.row0; i < tile.row1; ++i) {
+              for (uint64_t j = tile.col0; j < tile.col1; ++j) {
+                if (options.symmetric && tile.row0 == tile.col0 && j < i) {
+                  continue;  // Mirrored from (j, i)
+                }
+                if (dense) {
+                  double value =
+                      computeBatchMetric(store, metric, i, j, workspace);
+                  mapping->row(i)[j] = value;
+                  if (mirror) mapping->row(j)[i] = value;
+                  continue;
+                }
+                if (i == j) continue;
+                double value;
+                if (topK) {
+                  auto& heap = heaps[i - tile.row0];
+                  double bound = heap.size() < options.topK
+                                     ? numeric_limits<double>::infinity()
+                                     : heap.front().first;
+                  if (entryWithin(store, metric, i, j, bound, workspace,
+                                  value)) {
+                    offerEntry(heap, options.topK, value, j);
+                  }
+                } else if (entryWithin(store, metric, i, j, options.epsilon,
+                                       workspace, value)) {
+                  records.push_back({i, j, value});
+                  if (options.symmetric) records.push_back({j, i, value});
+                }
+              }
+            }
+
+            // Task 2: Make the tile durable, then record it
+            if (dense) {
+              mapping->flush(tile.row0, tile.row1, tile.col0, tile.col1);
+              if (mirror) {
+                mapping->flush(tile.col0, tile.col1, tile.row0, tile.row1);
+              }
+              lock_guard<mutex> lock(outputMutex);
+              journal.record(tile.id, 0);
+              ++progress.computedTiles;
+            } else if (!topK) {
+              lock_guard<mutex> lock(outputMutex);
+              journal.record(tile.id, sparse->append(records));
+              ++progress.computedTiles;
+            } else {
+              // Task 3: Merge into the band; the last tile writes the band
+              BandState& band = *bands[tile.band];
+              bool complete;
+              {
+                lock_guard<mutex> lock(band.lock);
+                for (size_t r = 0; r < heaps.size(); ++r) {
+                  for (const auto& entry : heaps[r]) {
+                    offerEntry(band.rows[r], options.topK, entry.first,
+                               entry.second);
+                  }
+                }
+                complete = --band.remainingTiles == 0;
+              }
+              lock_guard<mutex> lock(outputMutex);
+              ++progress.computedTiles;
+              if (complete) {
+                for (size_t r = 0; r < band.rows.size(); ++r) {
+                  auto& row = band.rows[r];
+                  sort_heap(row.begin(), row.end());
+                  for (const auto& entry : row) {
+                    records.push_back(
+                        {tile.row0 + r, entry.second, entry.first});
+                  }
+                }
+                journal.record(tile.band, sparse->append(records));
+                bands[tile.band].reset();
+              }
+            }
+          }
+        } catch (const exception& e) {
+          fail(e.what());
+        }
+      });
+    }
+    pool.wait();
+  }
+
+  if (!error.empty()) {
+    throw runtime_error(error);
+  }
+  if (sparse) progress.sparseEntries = sparse->size() / sizeof(BatchRecord);
+  return progress;
+}
+
+// Merges the outputs of all shards
+MatrixProgress mergeMatrixShards(const MatrixOptions& options) {
+  validateOptions(options);
+  MappedCurveFile store(options.storePath);
+  size_t n = store.numCurves();
+  MatrixLayout layout = buildLayout(store, options);
+  MatrixProgress progress;
+  progress.tileSize = layout.tileSize;
+  progress.numTiles = progress.resumedTiles = layout.tiles.size();
+
+  // Step 1: Every shard must have completed all of its units
+  vector<JournalState> shards(options.numShards);
+  MatrixOptions shardOptions = options;
+  for (size_t s = 0; s < options.numShards; ++s) {
+    shardOptions.shardIndex = s;
+    if (!readJournal(journalPathOf(options, s),
+                     journalHeader(shardOptions, n, layout.tileSize),
+                     layout.numUnits, shards[s])) {
+      throw runtime_error("Shard " + to_string(s) +
+                          " has no journal of this run.");
+    }
+    for (size_t unit = 0; unit < layout.numUnits; ++unit) {
+      if (layout.unitShard[unit] == s && !shards[s].completed[unit]) {
+        throw runtime_error("Shard " + to_string(s) + " is incomplete.");
+      }
+    }
+  }
+
+  // Step 2: Dense shards hold the rows of their tiles; the mirrored entries
+  // of symmetric runs are filled in here
+  if (options.output == MatrixOutput::Dense) {
+    MatrixMapping merged(options.outputPath, n, 0, n, false);
+    for (size_t s = 0; s < options.numShards; ++s) {
+      string path = outputPathOf(options, s);
+      struct stat info;
+      if (stat(path.c_str(), &info) != 0) {
+        throw runtime_error("Missing shard output " + path + ".");
+      }
+      pair<size_t, size_t> rows = shardRows(layout, options, n, s);
+      MatrixMapping shard(path, n, rows.first, rows.second - rows.first,
+                          true);
+      if (shard.isFresh()) {
+        throw runtime_error("Shard output " + path +
+                            " does not match the run.");
+      }
+      for (const auto& tile : layout.tiles) {
+        if (layout.unitShard[layout.unitOf(tile)] != s) continue;
+        bool diagonal = tile.row0 == tile.col0;
+        for (uint64_t i = tile.row0; i < tile.row1; ++i) {
+          const double* source = shard.row(i);
+          if (!options.symmetric) {
+            memcpy(merged.row(i) + tile.col0, source + tile.col0,
+                   (tile.col1 - tile.col0) * sizeof(double));
+            continue;
+          }
+          for (uint64_t j = diagonal ? i : tile.col0; j < tile.col1; ++j) {
+            merged.row(i)[j] = source[j];
+            merged.row(j)[i] = source[j];
+          }
+        }
+      }
+    }
+    merged.flush(0, n, 0, n);
+    merged.flushHeader();
+    return progress;
+  }
+
+  // Step 3: Sparse shards hold the journaled prefix of their files, which
+  // are concatenated in shard order
+  SparseOutput merged(options.outputPath, 0);
+  vector<BatchRecord> records;
+  for (size_t s = 0; s < options.numShards; ++s) {
+    string path = outputPathOf(options, s);
+    ifstream in(path, ios::binary);
+    uint64_t remaining = shards[s].sparseBytes / sizeof(BatchRecord);
+    while (remaining > 0) {
+      records.resize(min<uint64_t>(remaining, 1 << 20));  // 24 MiB blocks
+      if (!in.read(reinterpret_cast<char*>(records.data()),
+                   records.size() * sizeof(BatchRecord))) {
+        throw runtime_error("Shard output " + path +
+                            " is shorter than its journal.");
+      }
+      merged.append(records);
+      remaining -= records.size();
+    }
+  }
+  progress.sparseEntries = merged.size() / sizeof(BatchRecord);
+  return progress;
+}
+
+// Runs all shards as child processes and merges their outputs
+MatrixProgress runLocalShards(const MatrixOptions& options,
+                              const string& executable,
+                              const vector<string>& arguments) {
+  validateOptions(options);
+
+  // Step 1: Argument lists of the children (built before forking)
+  size_t threads = options.numThreads;
+  if (threads == 0) {
+    threads = max<size_t>(1, thread::hardware_concurrency() /
+                                 options.numShards);
+  }
+  vector<vector<string>> commands(options.numShards);
+  for (size_t s = 0; s < options.numShards; ++s) {
+    commands[s].push_back(executable);
+    commands[s].insert(commands[s].end(), arguments.begin(), arguments.end());
+    commands[s].insert(commands[s].end(), {"--shard", to_string(s)});
+    if (options.numThreads == 0) {
+      commands[s].insert(commands[s].end(), {"--threads", to_string(threads)});
+    }
+  }
+
+  // Step 2: Start all children, then wait for every one of them
+  vector<pid_t> children;
+  for (auto& command : commands) {
+    vector<char*> argv;
+    for (auto& argument : command) argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+    pid_t child = fork();
+    if (child == 0) {
+      execv(executable.c_str(), argv.data());
+      _exit(127);
+    }
+    if (child < 0) break;
+    children.push_back(child);
+  }
+  size_t failures = options.numShards - children.size();
+  for (pid_t child : children) {
+    int status = 0;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      ++failures;
+    }
+  }
+  if (failures > 0) {
+    throw runtime_error(to_string(failures) + " of " +
+                        to_string(options.numShards) +
+                        " shards failed; run again to resume them.");
+  }
+
+  // Step 3: Merge
+  return mergeMatrixShards(options);
+}
+
+// Parses "matrix" command line arguments into options
+MatrixOptions parseMatrixArguments(int argc, char** argv) {
+  MatrixOptions options;
+  for (int i = 0; i < argc; ++i) {
+    string flag = argv[i];
+
+    // Flags without a value
+    if (flag == "--symmetric") {
+      options.symmetric = true;
+      continue;
+    }
+    if (flag == "--restart") {
+      options.resume = false;
+      continue;
+    }
+
+    if (i + 1 >= argc) {
+      throw invalid_argument("Missing value for " + flag + ".");
+    }
+    string value = argv[++i];
+    if (flag == "--store") {
+      options.storePath = value;
+    } else if (flag == "--out") {
+      options.outputPath = value;
+    } else if (flag == "--journal") {
+      options.journalPath = value;
+    } else if (flag == "--metric") {
+      options.metric = parseBatchMetric(value);
+    } else if (flag == "--output") {
+      if (value == "dense") {
+        options.output = MatrixOutput::Dense;
+      } else if (value == "top-k") {
+        options.output = MatrixOutput::TopK;
+      } else if (value == "threshold") {
+        options.output = MatrixOutput::Threshold;
+      } else {
+        throw invalid_argument("Unknown output " + value + ".");
+      }
+    } else if (flag == "--k") {
+      options.topK = stoul(value);
+    } else if (flag == "--epsilon") {
+      options.epsilon = stod(value);
+    } else if (flag == "--window") {
+      options.window = stoi(value);
+    } else if (flag == "--free-space") {
+      options.freeSpaceMode = parseFreeSpaceMode(value);
+    } else if (flag == "--tile") {
+      options.tileSize = stoul(value);
+    } else if (flag == "--threads") {
+      options.numThreads = stoul(value);
+    } else if (flag == "--shards") {
+      options.numShards = stoul(value);
+    } else if (flag == "--shard") {
+      options.shardIndex = stoul(value);
+    } else if (flag == "--seed") {
+      options.seed = static_cast<uint32_t>(stoul(value));
+    } else {
+      throw invalid_argument("Unknown option " + flag + ".");
+    }
+  }
+
+  if (options.storePath.empty() || options.outputPath.empty()) {
+    throw invalid_argument("--store and --out are required.");
+  }
+  if (options.numShards == 0 || options.shardIndex >= options.numShards) {
+    throw invalid_argument("--shard must be below --shards.");
+  }
+  return options;
+}
@@ -0,0 +1,255 @@
+#include "dtw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "workspace.h"
+
+using namespace std;
+
+namespace DTW {
+
+namespace {
+
+const double kInfinity = numeric_limits<double>::infinity();
+
+// Half width of the band for curves of n and m points
+int bandWidth(int n, int m, int window) {
+  if (window < 0) return max(n, m);
+  return max(window, abs(n - m));
+}
+
+// Distance between two points
+double pointDistance(const Point_2& a, const Point_2& b) {
+  double dx = a.x() - b.x(), dy = a.y() - b.y();
+  return sqrt(dx * dx + dy * dy);
+}
+
+// Writes the sliding minimum (sign 1) or maximum (sign -1) of the m values
+// over the windows [i - w, i + w] for i < n into out[i * 4]. The band width
+// is at least |n - m|, so no window is empty.
+void slidingExtremum(const double* values, int m, int n, int w, double sign,
+                     double* out, vector<int>& deque) {
+  deque.resize(m);
+  int head = 0, tail = 0, next = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int last = min(m - 1, i + w); next <= last; ++next) {
+      while (tail > head && sign * values[deque[tail - 1]] >=
+                                sign * values[next]) {
+        --tail;
+      }
+      deque[tail++] = next;
+    }
+    while (deque[head] < i - w) ++head;
+    out[4 * i] = values[deque[head]];
+  }
+}
+
+// Writes the LB_Keogh term of every vertex of P into terms: its distance to
+// the bounding box of the band of Q
+void keoghTerms(const PolygonalCurve& P, const PolygonalCurve& Q, int w,
+                Workspace& ws, vector<double>& terms) {
+  int n = P.numPoints();
+  int m = Q.numPoints();
+
+  // Envelope: minX, minY, maxX, maxY of the band of every row
+  vector<double>& envelope = ws.dtwEnvelope;
+  envelope.resize(4 * n);
+  slidingExtremum(Q.xData(), m, n, w, 1, &envelope[0], ws.dtwDeque);
+  slidingExtremum(Q.yData(), m, n, w, 1, &envelope[1], ws.dtwDeque);
+  slidingExtremum(Q.xData(), m, n, w, -1, &envelope[2], ws.dtwDeque);
+  slidingExtremum(Q.yData(), m, n, w, -1, &envelope[3], ws.dtwDeque);
+
+  terms.resize(n);
+  const double* px = P.xData();
+  const double* py = P.yData();
+  for (int i = 0; i < n; ++i) {
+    const double* box = &envelope[4 * i];
+    double x = px[i], y = py[i];
+    double dx = max(max(box[0] - x, x - box[2]), 0.0);
+    double dy = max(max(box[1] - y, y - box[3]), 0.0);
+    terms[i] = sqrt(dx * dx + dy * dy);
+  }
+}
+
+// Banded, early-abandoning DP of computeDTW with the buffers of ws
+double dtwInto(const PolygonalCurve& P, const PolygonalCurve& Q, int w,
+               double bestSoFar, Workspace& ws, DTWStats* stats) {
+  int n = P.numPoints();
+  int m = Q.numPoints();
+  STATS_ADD_PTR(stats, dtwCalls, 1);
+
+  // Step 1: Bound of the rows not computed yet. tail[i] is the sum of the
+  // LB_Keogh terms of rows i, ..., n - 1.
+  vector<double>& tail = ws.dtwBounds;
+  bool abandon = bestSoFar < kInfinity;
+  // The sums of the bound are rounded, so an alignment costing exactly
+  // bestSoFar needs a little slack to survive
+  double limit = bestSoFar + 1e-9 * max(bestSoFar, 1.0);
+  if (abandon) {
+    keoghTerms(P, Q, w, ws, tail);
+    tail.push_back(0.0);
+    for (int i = n - 1; i >= 0; --i) tail[i] += tail[i + 1];
+  }
+  const double* qx = Q.xData();
+  const double* qy = Q.yData();
+
+  // Step 2: DP row by row. The band moves right by at most one column per
+  // row, so one infinite sentinel on each side of a row suffices.
+  ws.dtwRows.assign(2 * m, kInfinity);
+  ws.dtwCosts.resize(m);
+  double* previous = ws.dtwRows.data();
+  double* current = previous + m;
+  double* cost = ws.dtwCosts.data();
+  for (int i = 0; i < n; ++i) {
+    int first = max(0, i - w);
+    int last = min(m - 1, i + w);
+    double px = P.xData()[i], py = P.yData()[i];
+
+    // Task 1: Point distances (independent, so the loop vectorizes)
+    for (int j = first; j <= last; ++j) {
+      double dx = px - qx[j], dy = py - qy[j];
+      cost[j] = sqrt(dx * dx + dy * dy);
+    }
+
+    // Task 2: Vertical and diagonal moves (independent as well)
+    if (i == 0) {
+      current[0] = cost[0];
+      fill(current + 1, current + last + 1, kInfinity);
+    } else {
+      int j = first;
+      if (j == 0) {
+        current[0] = cost[0] + previous[0];
+        ++j;
+      }
+      for (; j <= last; ++j) {
+        current[j] = cost[j] + min(previous[j], previous[j - 1]);
+      }
+    }
+
+    // Task 3: Horizontal moves (a prefix scan along the row)
+    for (int j = first + 1; j <= last; ++j) {
+      current[j] = min(current[j], current[j - 1] + cost[j]);
+    }
+    if (first > 0) current[first - 1] = kInfinity;
+    if (last + 1 < m) current[last + 1] = kInfinity;
+    STATS_ADD_PTR(stats, cells, last - first + 1);
+
+    // Task 4: Every alignment passes through this row and still has to
+    // cover the rows below
+    if (abandon) {
+      double rowMinimum = *min_element(current + first, current + last + 1);
+      if (rowMinimum + tail[i + 1] > limit) {
+        STATS_ADD_PTR(stats, abandoned, 1);
+        return kInfinity;
+      }
+    }
+    swap(previous, current);
+  }
+
+  return previous[m - 1];
+}
+
+}  // namespace
+
+// Computes the DTW distance
+double computeDTW(const PolygonalCurve& P, const PolygonalCurve& Q, int window,
+                  double bestSoFar, DTWStats* stats, Workspace* workspace) {
+  STATS_TIMER_PTR(stats, seconds);
+  int n = P.numPoints();
+  int m = Q.numPoints();
+  if (n == 0 || m == 0) {
+    throw invalid_argument("DTW of an empty curve.");
+  }
+
+  // Without a workspace the buffers live for this call only
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+  return dtwInto(P, Q, bandWidth(n, m, window), bestSoFar, ws, stats);
+}
+
+// LB_Kim from the first and the last pairs
+double lowerBoundKim(const PolygonalCurve& P, const PolygonalCurve& Q) {
+  if (P.numPoints() == 0 || Q.numPoints() == 0) {
+    throw invalid_argument("DTW of an empty curve.");
+  }
+  double bound = pointDistance(P.getPoint(0), Q.getPoint(0));
+  if (P.numPoints() > 1 || Q.numPoints() > 1) {
+    bound += pointDistance(P.getPoint(P.numPoints() - 1),
+                           Q.getPoint(Q.numPoints() - 1));
+  }
+  return bound;
+}
+
+// LB_Keogh of P against the envelope of Q
+double lowerBoundKeogh(const PolygonalCurve& P, const PolygonalCurve& Q,
+                       int window, Workspace* workspace) {
+  int n = P.numPoints();
+  int m = Q.numPoints();
+  if (n == 0 || m == 0) {
+    throw invalid_argument("DTW of an empty curve.");
+  }
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+  keoghTerms(P, Q, bandWidth(n, m, window), ws, ws.dtwBounds);
+
+  double bound = 0.0;
+  for (double term : ws.dtwBounds) bound += term;
+  return bound;
+}
+
+// k nearest candidates under DTW
+vector<Neighbor> nearestNeighbors(const PolygonalCurve& query,
+                                  const vector<PolygonalCurve>& candidates,
+                                  size_t k, int window, DTWStats* stats,
+                                  Workspace* workspace) {
+  STATS_TIMER_PTR(stats, seconds);
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+
+  // Max-heap of the k best candidates so far
+  auto farther = [](const Neighbor& a, const Neighbor& b) {
+    return a.distance < b.distance ||
+           (a.distance == b.distance && a.index < b.index);
+  };
+  vector<Neighbor> best;
+  if (k == 0) return best;
+  best.reserve(k);
+
+  for (size_t index = 0; index < candidates.size(); ++index) {
+    const PolygonalCurve& candidate = candidates[index];
+    STATS_ADD_PTR(stats, candidates, 1);
+    double threshold = best.size() < k ? kInfinity : best.front().distance;
+
+    // Stage 1: Endpoints
+    if (lowerBoundKim(query, candidate) >= threshold) {
+      STATS_ADD_PTR(stats, prunedByKim, 1);
+      continue;
+    }
+
+    // Stage 2: Envelopes in both directions
+    if (lowerBoundKeogh(candidate, query, window, &ws) >= threshold ||
+        lowerBoundKeogh(query, candidate, window, &ws) >= threshold) {
+      STATS_ADD_PTR(stats, prunedByKeogh, 1);
+      continue;
+    }
+
+    // Stage 3: Early-abandoning DP
+    int w = bandWidth(candidate.numPoints(), query.numPoints(), window);
+    double distance = dtwInto(candidate, query, w, threshold, ws, stats);
+    if (distance >= threshold) continue;
+
+    if (best.size() == k) {
+      pop_heap(best.begin(), best.end(), farther);
+      best.pop_back();
+    }
+    best.push_back({distance, index});
+    push_heap(best.begin(), best.end(), farther);
+  }
+
+  sort_heap(best.begin(), best.end(), farther);
+  return best;
+}
+
+}  // namespace DTW
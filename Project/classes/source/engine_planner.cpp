@@ -0,0 +1,289 @@
+#include "engine_planner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "decision_problem.h"
+#include "fdistance.h"
+#include "ged.h"
+#include "incremental_decision.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+// Bisection steps run at most (enough for full double precision)
+const int kMaxBisectionSteps = 64;
+
+// Bytes of the free space and reachable intervals of a dense decision
+double decisionBytes(double p, double q) {
+  return 4.0 * p * q * sizeof(PointPair);
+}
+
+// Number of bisection steps that shrink [lower, upper] to the tolerance
+int bisectionSteps(double lower, double upper, double tolerance) {
+  if (tolerance <= 0.0 || upper <= lower) return kMaxBisectionSteps;
+  double target = tolerance * max(lower, upper * tolerance);
+  double steps = ceil(log2(max((upper - lower) / target, 1.0)));
+  return min(kMaxBisectionSteps, static_cast<int>(steps));
+}
+
+// Bisection of epsilon over [lower, upper], where upper is feasible. Stops
+// when upper <= (1 + tolerance) * lower or when the bracket cannot shrink.
+template <typename Decide>
+void bisect(double tolerance, Decide decide, double& lower, double& upper) {
+  // The lower bound is often the answer (end points or boxes decide)
+  if (decide(lower)) {
+    upper = lower;
+    return;
+  }
+  for (int step = 0; step < kMaxBisectionSteps; ++step) {
+    if (tolerance > 0.0 && upper - lower <= tolerance * lower) break;
+    double middle = lower + (upper - lower) / 2;
+    if (middle <= lower || middle >= upper) break;
+    if (decide(middle)) {
+      upper = middle;
+    } else {
+      lower = middle;
+    }
+  }
+}
+
+}  // namespace
+
+// Name of a strategy
+const char* strategyName(DistanceStrategy strategy) {
+  switch (strategy) {
+    case DistanceStrategy::ExactFD:
+      return "exact-fd";
+    case DistanceStrategy::BisectionFD:
+      return "bisection-fd";
+    case DistanceStrategy::StreamingFD:
+      return "streaming-fd";
+    case DistanceStrategy::ExactGED:
+      return "exact-ged";
+    case DistanceStrategy::ApproximateGED:
+      return "approximate-ged";
+  }
+  return "unknown";
+}
+
+// Constructor to set the limits
+EnginePlanner::EnginePlanner(const PlannerOptions& options)
+    : options(options) {}
+
+// Getter
+const PlannerOptions& EnginePlanner::getOptions() const { return options; }
+
+// Estimates of all FD strategies
+vector<StrategyEstimate> EnginePlanner::estimateFD(
+    const PolygonalCurve& P, const PolygonalCurve& Q) const {
+  const CostModel& costs = options.costs;
+  double p = static_cast<double>(P.numPoints());
+  double q = static_cast<double>(Q.numPoints());
+  double cells = p * q;
+
+  // Step 1: Exact search. Type C dominates with O(p^2 q + q^2 p) values,
+  // which are stored twice (per type and merged), and about log2 of their
+  // number decisions follow.
+  double typeB = p * (q - 1) + q * (p - 1);
+  double typeC = p * (p - 1) / 2 * (q - 1) + q * (q - 1) / 2 * (p - 1);
+  double values = 2 + max(typeB, 0.0) + max(typeC, 0.0);
+  double searchSteps = log2(max(values, 1.0)) + 1;
+  StrategyEstimate exact;
+  exact.strategy = DistanceStrategy::ExactFD;
+  exact.seconds = values * costs.criticalValueSeconds +
+                  searchSteps * cells * costs.decisionCellSeconds;
+  exact.bytes = static_cast<size_t>(2 * values * sizeof(double) +
+                                    3 * cells * sizeof(int) +
+                                    decisionBytes(p, q));
+  exact.exact = true;
+
+  // Step 2: Bisections from the summary bounds
+  double lower = frechetLowerBound(P.summary(), Q.summary());
+  double upper = frechetUpperBound(P.summary(), Q.summary());
+  double steps = bisectionSteps(lower, upper, options.tolerance) + 1;
+
+  StrategyEstimate bisection;
+  bisection.strategy = DistanceStrategy::BisectionFD;
+  bisection.seconds = steps * cells * costs.decisionCellSeconds;
+  bisection.bytes = static_cast<size_t>(decisionBytes(p, q));
+  bisection.exact = false;
+
+  // An IncrementalDecision keeps a copy of P and three rows of q intervals,
+  // reused by every probe
+  StrategyEstimate streaming;
+  streaming.strategy = DistanceStrategy::StreamingFD;
+  streaming.seconds = steps * cells * costs.streamingCellSeconds;
+  streaming.bytes = static_cast<size_t>(2 * p * sizeof(double) +
+                                        3 * q * sizeof(PointPair));
+  streaming.exact = false;
+
+  return {exact, bisection, streaming};
+}
+
+// Estimates of all GED strategies
+vector<StrategyEstimate> EnginePlanner::estimateGED(
+    const PolygonalCurve& P, const PolygonalCurve& Q) const {
+  const CostModel& costs = options.costs;
+  double p = static_cast<double>(P.numPoints());
+  double q = static_cast<double>(Q.numPoints());
+  double n = max(min(p, q), 1.0);
+  double m = max(p, q);
+
+  StrategyEstimate exact;
+  exact.strategy = DistanceStrategy::ExactGED;
+  exact.seconds = p * q * costs.gedCellSeconds;
+  exact.bytes = static_cast<size_t>(2 * (q + 1) * sizeof(double));
+  exact.exact = true;
+
+  // The approximation binary-searches O(log n) grid levels with O(log n)
+  // trials each; a trial quantizes both curves and fills the banded SED
+  // table, whose threshold 12 sqrt(n) + 2g is about 14 sqrt(n) at the level
+  // that usually succeeds
+  double maxLevel = ceil(log2(n));
+  double levels = log2(maxLevel + 1) + 1;
+  double trials = ceil(9.0 * log(n)) + 1;
+  double band = min(2 * 14 * sqrt(n) + 1, m + 1);
+  double tableCells = (n + 1) * band;
+  StrategyEstimate approximate;
+  approximate.strategy = DistanceStrategy::ApproximateGED;
+  approximate.seconds =
+      levels * trials * (p + q + tableCells) * costs.sedCellSeconds;
+  approximate.bytes = static_cast<size_t>(
+      tableCells * sizeof(int) + (p + q) * sizeof(CurveAlphabet) +
+      2 * n * sizeof(pair<int, int>));
+  approximate.exact = false;
+
+  return {exact, approximate};
+}
+
+// Chooses the fastest estimate within the budget and the accuracy target
+StrategyEstimate EnginePlanner::choose(
+    const vector<StrategyEstimate>& estimates, bool* fallback) const {
+  auto accurate = [&](const StrategyEstimate& estimate) {
+    if (estimate.exact) return true;
+    if (estimate.strategy == DistanceStrategy::ApproximateGED) {
+      return options.allowApproximateGED;
+    }
+    return options.tolerance > 0.0;
+  };
+  auto fits = [&](const StrategyEstimate& estimate) {
+    return estimate.bytes <= options.memoryBudget;
+  };
+  auto faster = [](const StrategyEstimate* best,
+                   const StrategyEstimate& estimate) {
+    return !best || estimate.seconds < best->seconds;
+  };
+
+  // Pass 1: Budget and accuracy, pass 2: budget only
+  for (int pass = 0; pass < 2; ++pass) {
+    const StrategyEstimate* best = nullptr;
+    for (const auto& estimate : estimates) {
+      if (fits(estimate) && (pass == 1 || accurate(estimate)) &&
+          faster(best, estimate)) {
+        best = &estimate;
+      }
+    }
+    if (best) {
+      if (fallback) *fallback = pass == 1;
+      return *best;
+    }
+  }
+
+  // Pass 3: Nothing fits, so take the smallest memory
+  if (fallback) *fallback = true;
+  return *min_element(estimates.begin(), estimates.end(),
+                      [](const StrategyEstimate& a, const StrategyEstimate& b) {
+                        return a.bytes < b.bytes;
+                      });
+}
+
+// Chosen FD strategy
+StrategyEstimate EnginePlanner::planFD(const PolygonalCurve& P,
+                                       const PolygonalCurve& Q,
+                                       bool* fallback) const {
+  return choose(estimateFD(P, Q), fallback);
+}
+
+// Chosen GED strategy
+StrategyEstimate EnginePlanner::planGED(const PolygonalCurve& P,
+                                        const PolygonalCurve& Q,
+                                        bool* fallback) const {
+  return choose(estimateGED(P, Q), fallback);
+}
+
+// Plans and runs the FD computation
+PlannedResult EnginePlanner::computeFD(const PolygonalCurve& P,
+                                       const PolygonalCurve& Q,
+                                       Workspace* workspace) const {
+  PlannedResult result;
+  result.estimate = planFD(P, Q, &result.fallback);
+
+  // A single point needs no search, FDistance handles it in O(p + q)
+  if (P.numPoints() < 2 || Q.numPoints() < 2 ||
+      result.estimate.strategy == DistanceStrategy::ExactFD) {
+    result.value = FDistance(P, Q, workspace).getFDistance();
+    result.lower = result.upper = result.value;
+    return result;
+  }
+
+  // An approximation that had to fall back runs at full precision
+  double tolerance = result.fallback ? 0.0 : options.tolerance;
+  result.lower = frechetLowerBound(P.summary(), Q.summary());
+  result.upper = frechetUpperBound(P.summary(), Q.summary());
+  if (result.estimate.strategy == DistanceStrategy::BisectionFD) {
+    DecisionProblem decision(P, Q, result.upper, workspace);
+    bisect(
+        tolerance,
+        [&](double epsilon) {
+          decision.setEpsilon(epsilon);
+          return decision.doesMonotoneCurveExist();
+        },
+        result.lower, result.upper);
+  } else {
+    // One IncrementalDecision is re-armed per probe. A probe stops as soon as
+    // no prefix of Q matches, since the answer can only stay negative.
+    IncrementalDecision decision(Q, result.upper);
+    bisect(
+        tolerance,
+        [&](double epsilon) {
+          decision.reset(epsilon);
+          for (size_t i = 0; i < P.numPoints(); ++i) {
+            decision.addPoint(P.getPoint(i));
+            if (!decision.doesPrefixMatch()) return false;
+          }
+          return decision.doesMonotoneCurveExist();
+        },
+        result.lower, result.upper);
+  }
+  result.value = result.upper;
+  return result;
+}
+
+// Plans and runs the GED computation
+PlannedResult EnginePlanner::computeGED(const PolygonalCurve& P,
+                                        const PolygonalCurve& Q,
+                                        Workspace* workspace) const {
+  PlannedResult result;
+  result.estimate = planGED(P, Q, &result.fallback);
+  if (result.estimate.strategy == DistanceStrategy::ExactGED) {
+    result.value = GED::computeExactGED(P, Q, workspace);
+    result.lower = result.upper = result.value;
+    return result;
+  }
+
+  // The approximation returns the cost of a matching, an upper bound
+  result.value = GED::computeSquareRootApproxGED(P, Q, nullptr, workspace);
+  result.upper = result.value;
+  double lockstep = 0.0;
+  for (size_t i = 0; i < min(P.numPoints(), Q.numPoints()); ++i) {
+    double dx = P.xData()[i] - Q.xData()[i];
+    double dy = P.yData()[i] - Q.yData()[i];
+    lockstep += sqrt(dx * dx + dy * dy);
+  }
+  result.lower = min(result.value,
+                     GED::computeGEDBounds(P, Q, lockstep).lower);
+  return result;
+}
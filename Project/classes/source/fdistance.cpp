@@ -1,10 +1,29 @@
 #include "fdistance.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "weak_fdistance.h"
+
 using namespace std;
 
 // Constructor to initialize with two curves and set the F-distance
-FDistance::FDistance(const PolygonalCurve& P, const PolygonalCurve& Q)
-    : P(P), Q(Q), criticalVal(P, Q), decision(P, Q, 0.0), fDistance(-1.0) {
+FDistance::FDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                     Workspace* workspace, FreeSpaceMode mode,
+                     const CancellationToken* cancel)
+    : workspace(workspace),
+      P(P),
+      Q(Q),
+      cancel(cancel),
+      criticalVal(P, Q, workspace, true, cancel),
+      decision(P, Q, workspace),
+      fDistance(-1.0),
+      lowerBound(-1.0),
+      upperBound(-1.0),
+      status(AnytimeStatus::Complete) {
+  if (mode == FreeSpaceMode::Sparse) {
+    sparseDecision.reset(new DecisionProblem(P, Q, 0.0, workspace, mode));
+  }
   // Compute the F-distance using binary search on the critical values
   computeFDistance();
 }
@@ -12,8 +31,48 @@ FDistance::FDistance(const PolygonalCurve& P, const PolygonalCurve& Q)
 // Getter
 double FDistance::getFDistance() const { return fDistance; }
 
+// Getter for the counters of the critical values, decisions and search
+FDistanceStats FDistance::getStats() const {
+  FDistanceStats result = stats;
+  result.criticalValues = criticalVal.getStats();
+  result.decisions =
+      sparseDecision ? sparseDecision->getStats() : decision.getStats();
+  return result;
+}
+
+// Getter for the value, bracket and status of the search
+AnytimeResult FDistance::getAnytimeResult() const {
+  return {fDistance, lowerBound, upperBound, status};
+}
+
 // Helper function to compute F-distance using binary search on critical values
 void FDistance::computeFDistance() {
+  STATS_TIMER(stats, searchSeconds);
+
+  // A single point is matched to every vertex of the other curve
+  if (P.numPoints() < 2 || Q.numPoints() < 2) {
+    const PolygonalCurve& point = P.numPoints() < 2 ? P : Q;
+    const PolygonalCurve& curve = P.numPoints() < 2 ? Q : P;
+    double maxDistance = 0.0;
+    for (size_t i = 0; i < curve.numPoints(); ++i) {
+      double dx = curve.getPoint(i).x() - point.getPoint(0).x();
+      double dy = curve.getPoint(i).y() - point.getPoint(0).y();
+      maxDistance = max(maxDistance, sqrt(dx * dx + dy * dy));
+    }
+    fDistance = lowerBound = upperBound = maxDistance;
+    return;
+  }
+
+  // The summaries bracket the distance before any search. They are all an
+  // interrupted search returns if the critical values were not complete.
+  lowerBound = frechetLowerBound(P.summary(), Q.summary());
+  upperBound = frechetUpperBound(P.summary(), Q.summary());
+  if (criticalVal.wasInterrupted()) {
+    status = cancel->stopReason();
+    fDistance = upperBound;
+    return;
+  }
+
   // Get the sorted critical values from the CriticalValue object
   const std::vector<double>& criticalValues = criticalVal.getCriticalValues();
   if (criticalValues.empty()) {
@@ -21,29 +80,54 @@ void FDistance::computeFDistance() {
     return;
   }
 
+  // The weak Frechet distance is a lower bound and is found without decision
+  // calls, so the critical values below it are rejected up front
+  double weakBound =
+      WeakFDistance(P, Q, criticalVal, workspace).getWeakFDistance();
+  lowerBound = max(lowerBound, weakBound);
+  upperBound = min(upperBound, criticalValues.back());
+
   // Perform binary search on critical values
-  int left = 0;
+  int left = lower_bound(criticalValues.begin(), criticalValues.end(),
+                         weakBound) -
+             criticalValues.begin();
+  STATS_ADD(stats, weakSkippedValues, left);
   int right = criticalValues.size() - 1;
   double result = -1.0;  // To store the last true result
 
   while (left <= right) {
+    // A stop keeps the bracket of the values decided so far
+    if (cancel && cancel->stopRequested()) {
+      status = cancel->stopReason();
+      fDistance = upperBound;
+      return;
+    }
+
     int mid = left + (right - left) / 2;
     double currentEpsilon = criticalValues[mid];
-
-    // Update the DecisionProblem with the current epsilon
-    decision.setEpsilon(currentEpsilon);
+    STATS_ADD(stats, binarySearchSteps, 1);
 
     // Check if there is a monotone curve for this epsilon
-    if (decision.doesMonotoneCurveExist()) {
+    bool feasible;
+    if (sparseDecision) {
+      sparseDecision->setEpsilon(currentEpsilon);
+      feasible = sparseDecision->doesMonotoneCurveExist();
+    } else {
+      feasible = decision.decide(currentEpsilon);
+    }
+    if (feasible) {
       // If true, move to the left half (try smaller values)
       result = currentEpsilon;
+      upperBound = min(upperBound, currentEpsilon);
       right = mid - 1;
     } else {
       // If false, move to the right half (try larger values)
+      lowerBound = max(lowerBound, currentEpsilon);
       left = mid + 1;
     }
   }
 
   // Set the F-distance based on the result of the binary search
   fDistance = (result == -1.0) ? -1.0 : result;
+  lowerBound = upperBound = fDistance;
 }
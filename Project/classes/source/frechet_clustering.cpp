@@ -0,0 +1,487 @@
+#include "frechet_clustering.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "curve_store.h"
+#include "decision_problem.h"
+#include "fdistance.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+const double kInfinity = numeric_limits<double>::infinity();
+const size_t kNone = numeric_limits<size_t>::max();
+
+// Distances of one worker. Every comparison goes through here so that the
+// counters are exact.
+struct Evaluator {
+  explicit Evaluator(const CurveStore& store) : store(store) {}
+
+  const CurveStore& store;
+  Workspace workspace;  // Reused for every evaluation of this worker
+  ClusteringStats stats;
+
+  // Summary lower bound of F(curve i, curve j)
+  double lowerBound(size_t i, size_t j) const {
+    if (i == j) return 0.0;
+    return frechetLowerBound(store.getSummary(i), store.getSummary(j));
+  }
+
+  // F(curve i, curve j)
+  double exact(size_t i, size_t j) {
+    if (i == j) return 0.0;
+    ++stats.exactEvaluations;
+    PolygonalCurve P = store.getCurve(i);
+    PolygonalCurve Q = store.getCurve(j);
+    return FDistance(P, Q, &workspace).getFDistance();
+  }
+
+  // Decides F(curve i, curve j) <= epsilon, with the summaries first
+  bool within(size_t i, size_t j, double epsilon) {
+    if (i == j) return epsilon >= 0.0;
+    const CurveSummary& a = store.getSummary(i);
+    const CurveSummary& b = store.getSummary(j);
+    if (frechetLowerBound(a, b) > epsilon) {
+      ++stats.boundSkips;
+      return false;
+    }
+    if (frechetUpperBound(a, b) <= epsilon) {
+      ++stats.boundSkips;
+      return true;
+    }
+    ++stats.decisions;
+    PolygonalCurve P = store.getCurve(i);
+    PolygonalCurve Q = store.getCurve(j);
+    return DecisionProblem(P, Q, epsilon, &workspace).doesMonotoneCurveExist();
+  }
+};
+
+// Pool with one evaluator per worker
+class Workers {
+ public:
+  Workers(const CurveStore& store, size_t numThreads) : pool(numThreads) {
+    for (size_t t = 0; t < pool.numThreads(); ++t) {
+      evaluators.emplace_back(new Evaluator(store));
+    }
+  }
+
+  // Evaluator of the calling thread outside of run()
+  Evaluator& main() { return *evaluators[0]; }
+
+  // Runs body(evaluator, index) for every index below count
+  void run(size_t count, const function<void(Evaluator&, size_t)>& body) {
+    atomic<size_t> next(0);
+    atomic<bool> failed(false);
+    mutex errorMutex;
+    string error;
+    for (size_t t = 0; t < pool.numThreads(); ++t) {
+      pool.submit([&, t]() {
+        try {
+          for (size_t index = next++; index < count && !failed;
+               index = next++) {
+            body(*evaluators[t], index);
+          }
+        } catch (const exception& e) {
+          lock_guard<mutex> lock(errorMutex);
+          if (error.empty()) error = e.what();
+          failed = true;
+        }
+      });
+    }
+    pool.wait();
+    if (!error.empty()) throw runtime_error(error);
+  }
+
+  // Sum of the counters of all workers
+  ClusteringStats stats() const {
+    ClusteringStats total;
+    for (const auto& evaluator : evaluators) {
+      total.exactEvaluations += evaluator->stats.exactEvaluations;
+      total.decisions += evaluator->stats.decisions;
+      total.boundSkips += evaluator->stats.boundSkips;
+    }
+    return total;
+  }
+
+ private:
+  ThreadPool pool;
+  vector<unique_ptr<Evaluator>> evaluators;
+};
+
+void checkOptions(const CurveStore& store, const ClusteringOptions& options) {
+  if (options.k == 0) {
+    throw invalid_argument("The number of clusters must be positive.");
+  }
+  if (store.numCurves() == 0) {
+    throw invalid_argument("Cannot cluster an empty store.");
+  }
+  if (options.firstCenter >= store.numCurves()) {
+    throw invalid_argument("The first center is not a curve of the store.");
+  }
+}
+
+}  // namespace
+
+// Gonzalez's farthest-first k-center with lazy distances
+ClusteringResult gonzalezKCenter(const CurveStore& store,
+                                 const ClusteringOptions& options) {
+  checkOptions(store, options);
+  size_t n = store.numCurves();
+  size_t k = min(options.k, n);
+  Workers workers(store, options.numThreads);
+  Evaluator& evaluator = workers.main();
+
+  ClusteringResult result;
+  vector<size_t>& centers = result.centers;
+  vector<size_t>& assigned = result.assignment;
+  vector<double>& bound = result.upperBounds;
+  vector<char> isExact(n, 0);      // bound[i] is F to the nearest center
+  vector<char> isCenter(n, 0);
+  vector<vector<double>> between;  // F between the centers
+  assigned.assign(n, 0);
+  bound.assign(n, 0.0);
+
+  // Step 1: The first center bounds every curve by the summaries
+  centers.push_back(options.firstCenter);
+  isCenter[options.firstCenter] = 1;
+  isExact[options.firstCenter] = 1;
+  between.push_back({0.0});
+  workers.run(n, [&](Evaluator& worker, size_t i) {
+    if (isCenter[i]) return;
+    const CurveSummary& a = store.getSummary(i);
+    const CurveSummary& b = store.getSummary(options.firstCenter);
+    bound[i] = frechetUpperBound(a, b);
+    isExact[i] = frechetLowerBound(a, b) == bound[i];
+    ++worker.stats.boundSkips;
+  });
+
+  // Largest bounds first; an entry is current while its value is the bound
+  priority_queue<pair<double, size_t>> farthest;
+  for (size_t i = 0; i < n; ++i) {
+    if (!isCenter[i]) farthest.push({bound[i], i});
+  }
+
+  // Finds the curve farthest from its nearest center: the largest bound
+  // is tightened to F to the nearest center until the largest is exact
+  auto selectFarthest = [&]() -> size_t {
+    while (!farthest.empty()) {
+      pair<double, size_t> top = farthest.top();
+      size_t i = top.second;
+      if (isCenter[i] || top.first != bound[i]) {
+        farthest.pop();
+        continue;
+      }
+      if (isExact[i]) return i;
+      farthest.pop();
+
+      // Task 1: F to the assigned center, which is within the bound
+      size_t first = assigned[i];
+      double distance = evaluator.exact(i, centers[first]);
+      double firstDistance = distance;
+      size_t nearest = first;
+
+      // Task 2: A center is computed only if the decision says it is
+      // closer than the best so far
+      for (size_t c = 0; c < centers.size(); ++c) {
+        if (c == first) continue;
+        if (between[first][c] - firstDistance >= distance) {
+          ++evaluator.stats.boundSkips;
+          continue;
+        }
+        if (!evaluator.within(i, centers[c], distance)) continue;
+        double candidate = evaluator.exact(i, centers[c]);
+        if (candidate < distance) {
+          distance = candidate;
+          nearest = c;
+        }
+      }
+      assigned[i] = nearest;
+      bound[i] = distance;
+      isExact[i] = 1;
+      farthest.push({distance, i});
+    }
+    return kNone;
+  };
+
+  // Step 2: Add the farthest curve until there are k centers
+  while (centers.size() < k) {
+    size_t next = selectFarthest();
+    if (next == kNone) break;
+    size_t index = centers.size();
+    centers.push_back(next);
+    isCenter[next] = 1;
+
+    // Task 1: F between the new center and the others
+    vector<double> row(index + 1, 0.0);
+    workers.run(index, [&](Evaluator& worker, size_t c) {
+      row[c] = worker.exact(next, centers[c]);
+    });
+    for (size_t c = 0; c < index; ++c) between[c].push_back(row[c]);
+    between.push_back(move(row));
+
+    // Task 2: A curve only moves to the new center if it is within the
+    // bound, which stays valid; the triangle inequality
+    // F(i, new) >= F(old, new) - F(i, old) rules out most centers
+    workers.run(n, [&](Evaluator& worker, size_t i) {
+      if (i == next) {
+        assigned[i] = index;
+        bound[i] = 0.0;
+        isExact[i] = 1;
+        return;
+      }
+      if (isCenter[i] || bound[i] == 0.0 ||
+          between[assigned[i]][index] >= 2.0 * bound[i]) {
+        ++worker.stats.boundSkips;
+        return;
+      }
+      if (worker.within(i, next, bound[i])) {
+        assigned[i] = index;
+        isExact[i] = 0;
+      }
+    });
+  }
+
+  // Step 3: The radius is the distance of the next farthest curve
+  size_t last = selectFarthest();
+  result.radius = last == kNone ? 0.0 : bound[last];
+
+  result.stats = workers.stats();
+  result.stats.eagerEvaluations = static_cast<uint64_t>(n) * centers.size();
+  return result;
+}
+
+// Alternating k-medoids with Hamerly's bounds
+ClusteringResult kMedoids(const CurveStore& store,
+                          const ClusteringOptions& options) {
+  ClusteringResult result = gonzalezKCenter(store, options);
+  size_t n = store.numCurves();
+  size_t k = result.centers.size();
+  Workers workers(store, options.numThreads);
+  uint64_t eager = 0;
+
+  vector<size_t>& medoids = result.centers;
+  vector<size_t>& assigned = result.assignment;
+  vector<double>& upper = result.upperBounds;  // F to the assigned medoid
+  vector<double> lower(n, 0.0);  // F to every other medoid >= this
+  vector<char> isExact(n, 0);    // upper[i] is F to the assigned medoid
+  vector<size_t> medoidOf(n, kNone);
+  vector<vector<double>> between(k, vector<double>(k, 0.0));
+  vector<double> half(k);  // Half the distance to the nearest other medoid
+
+  // F between the medoids and the half distances
+  auto updateBetween = [&](const vector<char>& changed) {
+    vector<pair<size_t, size_t>> pairs;
+    for (size_t c = 0; c < k; ++c) {
+      for (size_t d = c + 1; d < k; ++d) {
+        if (changed[c] || changed[d]) pairs.push_back({c, d});
+      }
+    }
+    workers.run(pairs.size(), [&](Evaluator& worker, size_t p) {
+      size_t c = pairs[p].first;
+      size_t d = pairs[p].second;
+      between[c][d] = between[d][c] = worker.exact(medoids[c], medoids[d]);
+    });
+    for (size_t c = 0; c < k; ++c) {
+      double nearest = kInfinity;
+      for (size_t d = 0; d < k; ++d) {
+        if (d != c) nearest = min(nearest, between[c][d]);
+      }
+      half[c] = nearest / 2.0;
+    }
+  };
+
+  // Assignment step: a curve keeps its medoid if the bounds show that no
+  // other medoid is closer, otherwise it scans the medoids
+  auto assignAll = [&]() {
+    eager += static_cast<uint64_t>(n) * k;
+    workers.run(n, [&](Evaluator& worker, size_t i) {
+      if (medoidOf[i] != kNone) {
+        assigned[i] = medoidOf[i];
+        upper[i] = 0.0;
+        isExact[i] = 1;
+        lower[i] = 2.0 * half[medoidOf[i]];
+        return;
+      }
+
+      // Task 1: Hamerly's test, first with the bound, then with F
+      size_t first = assigned[i];
+      double limit = max(half[first], lower[i]);
+      if (upper[i] <= limit) {
+        ++worker.stats.boundSkips;
+        return;
+      }
+      if (!isExact[i]) {
+        upper[i] = worker.exact(i, medoids[first]);
+        isExact[i] = 1;
+        if (upper[i] <= limit) return;
+      }
+
+      // Task 2: Scan the other medoids. A medoid is computed only if the
+      // decision says it is closer than the best so far; the others keep
+      // their lower bound for the next round.
+      double firstDistance = upper[i];
+      double distance = firstDistance;
+      double others = kInfinity;
+      size_t nearest = first;
+      for (size_t c = 0; c < k; ++c) {
+        if (c == first) continue;
+        double bound = max(worker.lowerBound(i, medoids[c]),
+                           between[first][c] - firstDistance);
+        if (bound >= distance) {
+          ++worker.stats.boundSkips;
+          others = min(others, bound);
+          continue;
+        }
+        if (!worker.within(i, medoids[c], distance)) {
+          others = min(others, distance);
+          continue;
+        }
+        double candidate = worker.exact(i, medoids[c]);
+        if (candidate < distance) {
+          others = min(others, distance);
+          distance = candidate;
+          nearest = c;
+        } else {
+          others = min(others, candidate);
+        }
+      }
+      assigned[i] = nearest;
+      upper[i] = distance;
+      lower[i] = others == kInfinity ? 0.0 : others;
+    });
+  };
+
+  // Update step: the member with the smallest sum of distances over a
+  // sample of the cluster becomes the medoid
+  auto updateMedoids = [&](size_t round, vector<size_t>& next) {
+    vector<vector<size_t>> members(k);
+    for (size_t i = 0; i < n; ++i) members[assigned[i]].push_back(i);
+    vector<uint64_t> eagerOf(k, 0);
+
+    workers.run(k, [&](Evaluator& worker, size_t c) {
+      vector<size_t>& cluster = members[c];
+      next[c] = medoids[c];
+      if (cluster.size() < 3) return;
+
+      // Task 1: The references are a seeded sample of the members
+      vector<size_t> references = cluster;
+      if (references.size() > options.medoidReferences) {
+        mt19937 random(options.seed + 7919u * round + 104729u * c);
+        for (size_t r = 0; r < options.medoidReferences; ++r) {
+          uniform_int_distribution<size_t> pick(r, references.size() - 1);
+          swap(references[r], references[pick(random)]);
+        }
+        references.resize(options.medoidReferences);
+      }
+
+      // Task 2: The candidates are the members nearest to the medoid
+      vector<size_t> candidates;
+      for (size_t i : cluster) {
+        if (i != medoids[c]) candidates.push_back(i);
+      }
+      size_t numCandidates =
+          min(candidates.size(), options.medoidCandidates > 0
+                                     ? options.medoidCandidates - 1
+                                     : size_t(0));
+      partial_sort(candidates.begin(), candidates.begin() + numCandidates,
+                   candidates.end(), [&](size_t a, size_t b) {
+                     return upper[a] < upper[b] ||
+                            (upper[a] == upper[b] && a < b);
+                   });
+      candidates.resize(numCandidates);
+      eagerOf[c] = (numCandidates + 1) * references.size();
+
+      // Task 3: The sum of the medoid, from the exact bounds where known
+      double best = 0.0;
+      for (size_t r : references) {
+        best += isExact[r] ? upper[r] : worker.exact(medoids[c], r);
+      }
+
+      // Task 4: A candidate is abandoned once its sum plus the lower bounds
+      // of the remaining references reaches the best sum
+      for (size_t candidate : candidates) {
+        double remaining = 0.0;
+        for (size_t r : references) {
+          remaining += worker.lowerBound(candidate, r);
+        }
+        double sum = 0.0;
+        bool abandoned = false;
+        for (size_t r : references) {
+          if (sum + remaining >= best) {
+            abandoned = true;
+            break;
+          }
+          remaining -= worker.lowerBound(candidate, r);
+          sum += worker.exact(candidate, r);
+        }
+        if (!abandoned && sum < best) {
+          best = sum;
+          next[c] = candidate;
+        }
+      }
+    });
+    for (uint64_t count : eagerOf) eager += count;
+  };
+
+  // Step 1: Assign from the Gonzalez centers
+  for (size_t c = 0; c < k; ++c) medoidOf[medoids[c]] = c;
+  updateBetween(vector<char>(k, 1));
+  assignAll();
+
+  // Step 2: Alternate the steps until no medoid changes
+  vector<size_t> next(k);
+  while (result.iterations < options.maxIterations) {
+    ++result.iterations;
+    updateMedoids(result.iterations, next);
+    vector<char> changed(k, 0);
+    bool anyChanged = false;
+    for (size_t c = 0; c < k; ++c) {
+      changed[c] = next[c] != medoids[c];
+      anyChanged = anyChanged || changed[c];
+    }
+    if (!anyChanged) break;
+
+    // Task 1: A medoid that moved by s moves the bounds of its curves by s
+    vector<double> shift(k, 0.0);
+    workers.run(k, [&](Evaluator& worker, size_t c) {
+      if (changed[c]) shift[c] = worker.exact(medoids[c], next[c]);
+    });
+    double largestShift = *max_element(shift.begin(), shift.end());
+    for (size_t c = 0; c < k; ++c) {
+      medoidOf[medoids[c]] = kNone;
+      medoidOf[next[c]] = c;
+      medoids[c] = next[c];
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (shift[assigned[i]] > 0.0) {
+        upper[i] += shift[assigned[i]];
+        isExact[i] = 0;
+      }
+      lower[i] = max(0.0, lower[i] - largestShift);
+    }
+
+    // Task 2: Reassign with the new medoids
+    updateBetween(changed);
+    assignAll();
+  }
+
+  ClusteringStats stats = workers.stats();
+  result.stats.exactEvaluations += stats.exactEvaluations;
+  result.stats.decisions += stats.decisions;
+  result.stats.boundSkips += stats.boundSkips;
+  result.stats.eagerEvaluations += eager;
+  return result;
+}
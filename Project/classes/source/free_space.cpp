@@ -1,11 +1,55 @@
 #include "free_space.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "workspace.h"
+
 using namespace std;
 
+namespace {
+
+// Snaps a portion within rounding error of an end of the edge to that end.
+// At a critical epsilon a free interval degenerates to an end point, which
+// must not be lost to rounding.
+double snapToEdgeEnd(double t) {
+  const double tolerance = 1e-9;
+  if (fabs(t) < tolerance) return 0.0;
+  if (fabs(t - 1.0) < tolerance) return 1.0;
+  return t;
+}
+
+// Radius of the grid queries. The exact test accepts tangent points within a
+// relative tolerance, so the bounding box filter must not be tighter.
+double queryRadius(double epsilon) {
+  return epsilon + 1e-9 * max(epsilon, 1.0);
+}
+
+}  // namespace
+
 // Constructor: initialize with two curves and epsilon
 FreeSpace::FreeSpace(const PolygonalCurve& P, const PolygonalCurve& Q,
-                     double epsilon)
-    : P(P), Q(Q), epsilon(epsilon) {
+                     double epsilon, Workspace* workspace, FreeSpaceMode mode)
+    : P(P),
+      Q(Q),
+      epsilon(epsilon),
+      mode(mode),
+      numEvaluated(0),
+      L(workspace ? workspace->freeSpaceL : ownL),
+      B(workspace ? workspace->freeSpaceB : ownB),
+      gridP(workspace ? workspace->gridP : ownGridP),
+      gridQ(workspace ? workspace->gridQ : ownGridQ),
+      sparseL(workspace ? workspace->sparseL : ownSparseL),
+      sparseB(workspace ? workspace->sparseB : ownSparseB),
+      rowsL(workspace ? workspace->sparseRowsL : ownRowsL),
+      rowsB(workspace ? workspace->sparseRowsB : ownRowsB),
+      scratch(workspace ? workspace->sparseScratch : ownScratch),
+      candidates(workspace ? workspace->gridCandidates : ownCandidates) {
+  // The grids do not depend on epsilon and are kept by setEpsilon()
+  if (mode == FreeSpaceMode::Sparse) {
+    gridP.build(P);
+    gridQ.build(Q);
+  }
   computeFreeSpace();
 }
 
@@ -27,6 +71,22 @@ const PointPairVector& FreeSpace::getL() const { return L; }
 // Getter for B results
 const PointPairVector& FreeSpace::getB() const { return B; }
 
+// Getter for the storage mode
+FreeSpaceMode FreeSpace::getMode() const { return mode; }
+
+// Getter for the number of evaluated (edge, vertex) pairs
+size_t FreeSpace::getNumEvaluated() const { return numEvaluated; }
+
+// Non-empty L intervals of P edge i
+pair<const FreeInterval*, const FreeInterval*> FreeSpace::rowL(int i) const {
+  return {sparseL.data() + rowsL[i], sparseL.data() + rowsL[i + 1]};
+}
+
+// Non-empty B intervals at P vertex i
+pair<const FreeInterval*, const FreeInterval*> FreeSpace::rowB(int i) const {
+  return {sparseB.data() + rowsB[i], sparseB.data() + rowsB[i + 1]};
+}
+
 // Setter for epsilon
 void FreeSpace::setEpsilon(double newEpsilon) {
   epsilon = newEpsilon;
@@ -37,13 +97,22 @@ void FreeSpace::setEpsilon(double newEpsilon) {
 void FreeSpace::computeFreeSpace() {
   L.clear();
   B.clear();
+  numEvaluated = 0;
+  if (mode == FreeSpaceMode::Sparse) {
+    processSparseL();
+    processSparseB();
+    return;
+  }
   processCurveForL();
   processCurveForB();
+  numEvaluated = L.size() + B.size();
 }
 
 void FreeSpace::processCurveForL() {
   int p = P.numPoints();
   int q = Q.numPoints();
+  L.reserve(max(p - 1, 0) * q);
+  double portions[2];
 
   for (int i = 0; i < p - 1; ++i) {
     Point_2 startP = P.getPoint(i);
@@ -52,14 +121,14 @@ void FreeSpace::processCurveForL() {
     for (int j = 0; j < q; ++j) {
       Point_2 pointQ = Q.getPoint(j);
 
-      auto result = checkPointsOnEdge(startP, endP, pointQ);
+      int result = checkPointsOnEdge(startP, endP, pointQ, epsilon, portions);
 
-      if (result.first == 2) {
-        float k = result.second[0];
-        float l = result.second[1];
+      if (result == 2) {
+        double k = portions[0];
+        double l = portions[1];
         L.push_back({Point_2(j, i + k), Point_2(j, i + l)});
-      } else if (result.first == 1) {
-        float k = result.second[0];
+      } else if (result == 1) {
+        double k = portions[0];
         L.push_back({Point_2(j, i + k), Point_2(j, i + k)});
       } else {
         L.push_back({Point_2(-1, -1), Point_2(-1, -1)});
@@ -71,6 +140,8 @@ void FreeSpace::processCurveForL() {
 void FreeSpace::processCurveForB() {
   int p = P.numPoints();
   int q = Q.numPoints();
+  B.reserve(max(q - 1, 0) * p);
+  double portions[2];
 
   for (int i = 0; i < q - 1; ++i) {
     Point_2 startQ = Q.getPoint(i);
@@ -79,16 +150,16 @@ void FreeSpace::processCurveForB() {
     for (int j = 0; j < p; ++j) {
       Point_2 pointP = P.getPoint(j);
 
-      auto result = checkPointsOnEdge(startQ, endQ, pointP);
+      int result = checkPointsOnEdge(startQ, endQ, pointP, epsilon, portions);
 
-      if (result.first == 2) {
+      if (result == 2) {
         // Two points, add two pairs
-        float k = result.second[0];
-        float l = result.second[1];
+        double k = portions[0];
+        double l = portions[1];
         B.push_back({Point_2(i + k, j), Point_2(i + l, j)});
-      } else if (result.first == 1) {
+      } else if (result == 1) {
         // One point, add one pair
-        float k = result.second[0];
+        double k = portions[0];
         B.push_back({Point_2(i + k, j), Point_2(i + k, j)});
       } else {
         // No points, add (-1, -1) pairs
@@ -98,72 +169,143 @@ void FreeSpace::processCurveForB() {
   }
 }
 
-std::pair<int, std::vector<float>> FreeSpace::checkPointsOnEdge(
-    const Point_2& start, const Point_2& end, const Point_2& point) const {
-  std::vector<float> portions;
+// Sparse L: every vertex of Q is looked up in the grid of P, and the free
+// intervals are then bucketed by P edge (stable, so rows stay sorted by j)
+void FreeSpace::processSparseL() {
+  int p = P.numPoints();
+  int q = Q.numPoints();
+  int numRows = max(p - 1, 0);
+  rowsL.assign(numRows + 1, 0);
+  scratch.clear();
+  double portions[2];
+
+  // Step 1: Evaluate the candidate pairs, keeping the edge in index
+  for (int j = 0; j < q; ++j) {
+    const Point_2& pointQ = Q.getPoint(j);
+    gridP.query(pointQ, queryRadius(epsilon), candidates);
+    numEvaluated += candidates.size();
+    for (int i : candidates) {
+      int result = checkPointsOnEdge(P.getPoint(i), P.getPoint(i + 1), pointQ,
+                                     epsilon, portions);
+      if (result == 0) continue;
+      double l = portions[result - 1];
+      scratch.push_back(
+          {i, {Point_2(j, i + portions[0]), Point_2(j, i + l)}});
+      ++rowsL[i + 1];
+    }
+  }
+
+  // Step 2: Bucket by edge; the Q vertex is the x coordinate
+  for (int i = 0; i < numRows; ++i) rowsL[i + 1] += rowsL[i];
+  sparseL.resize(scratch.size());
+  for (const auto& entry : scratch) {
+    int position = rowsL[entry.index]++;
+    sparseL[position] = {static_cast<int>(entry.interval.first.x()),
+                         entry.interval};
+  }
+  for (int i = numRows; i > 0; --i) rowsL[i] = rowsL[i - 1];
+  rowsL[0] = 0;
+}
 
+// Sparse B: every vertex of P is looked up in the grid of Q. The candidates
+// are sorted, so each row is filled in order.
+void FreeSpace::processSparseB() {
+  int p = P.numPoints();
+  rowsB.assign(p + 1, 0);
+  sparseB.clear();
+  double portions[2];
+
+  for (int i = 0; i < p; ++i) {
+    const Point_2& pointP = P.getPoint(i);
+    gridQ.query(pointP, queryRadius(epsilon), candidates);
+    numEvaluated += candidates.size();
+    for (int j : candidates) {
+      int result = checkPointsOnEdge(Q.getPoint(j), Q.getPoint(j + 1), pointP,
+                                     epsilon, portions);
+      if (result == 0) continue;
+      double l = portions[result - 1];
+      sparseB.push_back(
+          {j, {Point_2(j + portions[0], i), Point_2(j + l, i)}});
+    }
+    rowsB[i + 1] = sparseB.size();
+  }
+}
+
+// Computes the portions of the edge at distance at most epsilon from the
+// point. Returns their number (0, 1 or 2) and writes them into portions.
+int FreeSpace::checkPointsOnEdge(const Point_2& start, const Point_2& end,
+                                 const Point_2& point, double epsilon,
+                                 double portions[2]) {
   // (x1, y1) is start, (x2, y2) is end, and (px, py) is the point
-  float x1 = start.x(), y1 = start.y();
-  float x2 = end.x(), y2 = end.y();
-  float px = point.x(), py = point.y();
+  double x1 = start.x(), y1 = start.y();
+  double x2 = end.x(), y2 = end.y();
+  double px = point.x(), py = point.y();
 
   // Compute the square of the Euclidean distance
-  float dx = x2 - x1;
-  float dy = y2 - y1;
-  float len2 = dx * dx + dy * dy;
+  double dx = x2 - x1;
+  double dy = y2 - y1;
+  double len2 = dx * dx + dy * dy;
 
-  if (len2 == 0) return {0, portions};  // Edge is degenerate (start == end)
+  // Degenerate edge (start == end): free everywhere or nowhere
+  if (len2 == 0) {
+    double ex = px - x1, ey = py - y1;
+    if (ex * ex + ey * ey > epsilon * epsilon) return 0;
+    portions[0] = 0.0;
+    portions[1] = 1.0;
+    return 2;
+  }
 
   // Project point onto the line
-  float t = ((px - x1) * dx + (py - y1) * dy) / len2;
-  float nearestX = x1 + t * dx;
-  float nearestY = y1 + t * dy;
+  double t = ((px - x1) * dx + (py - y1) * dy) / len2;
+  double nearestX = x1 + t * dx;
+  double nearestY = y1 + t * dy;
 
   // Compute the distance from the point to the nearest point on the line
-  float dist2 =
+  double dist2 =
       (px - nearestX) * (px - nearestX) + (py - nearestY) * (py - nearestY);
-  float eps2 = epsilon * epsilon;
+  double eps2 = epsilon * epsilon;
 
-  // Check if the projected point is on the edge
-  if (std::fabs(dist2 - eps2) < 1e-6) {
+  // Check if the projected point is on the edge (tangent within rounding
+  // error, relative to epsilon so that wide intervals are not collapsed)
+  if (std::fabs(dist2 - eps2) < 1e-12 * max(eps2, 1.0)) {
     if (t >= 0 && t <= 1) {
-      portions.push_back(t);
-      return {1, portions};
+      portions[0] = t;
+      return 1;
     } else {
-      return {0, portions};
+      return 0;
     }
   } else if (dist2 < eps2) {
-    float d = std::sqrt(eps2 - dist2);
-    float t1 = t - d / std::sqrt(len2);
-    float t2 = t + d / std::sqrt(len2);
+    double d = std::sqrt(eps2 - dist2);
+    double t1 = snapToEdgeEnd(t - d / std::sqrt(len2));
+    double t2 = snapToEdgeEnd(t + d / std::sqrt(len2));
 
     // Handle different cases based on t1 and t2 values
     if ((t1 < 0 && t2 < 0) || (t1 > 1 && t2 > 1)) {
       // Both points are outside the edge
-      return {0, portions};
+      return 0;
     } else if (0 <= t1 && t1 <= 1 && t2 > 1) {
       // One point is on the edge, t2 is beyond the edge
-      portions.push_back(t1);
-      portions.push_back(1.0f);  // t2 reaches the end of the edge
-      return {2, portions};
+      portions[0] = t1;
+      portions[1] = 1.0;  // t2 reaches the end of the edge
+      return 2;
     } else if (t1 < 0 && t2 > 1) {
       // Both t1 and t2 are beyond the edge bounds
-      portions.push_back(0.0f);  // t1 starts from the beginning of the edge
-      portions.push_back(1.0f);  // t2 reaches the end of the edge
-      return {2, portions};
+      portions[0] = 0.0;  // t1 starts from the beginning of the edge
+      portions[1] = 1.0;  // t2 reaches the end of the edge
+      return 2;
     } else if (t1 < 0 && 0 <= t2 && t2 <= 1) {
       // t1 is before the edge, but t2 is within the edge
-      portions.push_back(0.0f);  // t1 starts from the beginning of the edge
-      portions.push_back(t2);    // t2 is valid within the edge
-      return {2, portions};
+      portions[0] = 0.0;  // t1 starts from the beginning of the edge
+      portions[1] = t2;    // t2 is valid within the edge
+      return 2;
     } else {
       // Both points are on the edge
-      portions.push_back(t1);
-      portions.push_back(t2);
-      return {2, portions};
+      portions[0] = t1;
+      portions[1] = t2;
+      return 2;
     }
   } else {
     // No points at epsilon distance on the edge
-    return {0, portions};
+    return 0;
   }
 }
@@ -1,19 +1,277 @@
 #include "ged.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <limits>
 #include <random>
 
+#include "bit_parallel_sed.h"
+#include "workspace.h"
+
 using namespace std;
 
 namespace GED {
 
-// Computes O(n^(1/2))-approximation of GED
-double computeSquareRootApproxGED(const PolygonalCurve& P,
-                                  const PolygonalCurve& Q) {
+namespace {
+
+// Largest grid level i with 2^i <= max(value, 1)
+int levelAtMost(double value) {
+  return value <= 1.0 ? 0 : static_cast<int>(floor(log2(value)));
+}
+
+// Smallest grid level i with 2^i >= max(value, 1)
+int levelAtLeast(double value) {
+  return value <= 1.0 ? 0 : static_cast<int>(ceil(log2(value)));
+}
+
+// Quantizes the points of a curve on the grid with origin (x_o, y_o) and cell
+// size delta
+void quantizeCurve(const PolygonalCurve& C, double x_o, double y_o,
+                   double delta, CurveString& S) {
+  S.clear();
+  S.reserve(C.numPoints());
+  for (size_t i = 0; i < C.numPoints(); ++i) {
+    S.emplace_back(static_cast<int>(floor((C.getPoint(i).x() - x_o) / delta)),
+                   static_cast<int>(floor((C.getPoint(i).y() - y_o) / delta)));
+  }
+}
+
+// Same as transformCurvesToStrings, but writes into the workspace strings and
+// draws the shift from the workspace generator
+void transformCurvesInto(const PolygonalCurve& P, const PolygonalCurve& Q,
+                         int g, Workspace& workspace) {
   size_t n = min(P.numPoints(), Q.numPoints());
+  double delta = g / sqrt(n);
+  uniform_real_distribution<> dis(0.0, delta);
+  double x_o = dis(workspace.generator);
+  double y_o = dis(workspace.generator);
+  quantizeCurve(P, x_o, y_o, delta, workspace.stringP);
+  quantizeCurve(Q, x_o, y_o, delta, workspace.stringQ);
+}
+
+// Layout of the DP table of diagonalSEDInto. Within the threshold k only the
+// cells (x, y) on the diagonals y - x in [-lowBand, highBand] are reached,
+// so each row x keeps lowBand + highBand + 1 cells (or m + 1 cells if that
+// is fewer); all other cells read as -1.
+struct SEDTableLayout {
+  int lowBand;   // min(k, n)
+  int highBand;  // min(k, m)
+  size_t width;  // Cells per row
+  bool banded;   // True if rows hold the band only
+
+  SEDTableLayout(size_t n, size_t m, int k)
+      : lowBand(static_cast<int>(min<size_t>(k, n))),
+        highBand(static_cast<int>(min<size_t>(k, m))) {
+    size_t bandWidth = static_cast<size_t>(lowBand + highBand) + 1;
+    banded = bandWidth < m + 1;
+    width = banded ? bandWidth : m + 1;
+  }
+
+  // Checks if cell (x, y) lies in the band
+  bool contains(size_t x, size_t y) const {
+    long long h = static_cast<long long>(y) - static_cast<long long>(x);
+    return h >= -lowBand && h <= highBand;
+  }
+
+  // Index of a cell of the band
+  size_t index(size_t x, size_t y) const {
+    return banded ? x * width + (y + lowBand - x) : x * width + y;
+  }
+
+  // Value of a cell (-1 outside the band)
+  int value(const vector<int>& D, size_t x, size_t y) const {
+    return contains(x, y) ? D[index(x, y)] : -1;
+  }
+};
+
+// Backtraces the DP table of diagonalSEDInto
+void backtraceInto(const vector<int>& D, const SEDTableLayout& layout,
+                   size_t n, size_t m, Matching& M) {
+  size_t x = n, y = m;
+  M.clear();
+
+  while (x > 0 || y > 0) {
+    int current = layout.value(D, x, y);
+    if (x > 0 && y > 0 && current == layout.value(D, x - 1, y - 1)) {
+      // Diagonal move: match (x, y)
+      M.emplace_back(x - 1, y - 1);
+      --x;
+      --y;
+    } else if (y > 0 && current == layout.value(D, x, y - 1) + 1) {
+      // Left move: skip a point in T
+      --y;
+    } else if (x > 0 && current == layout.value(D, x - 1, y) + 1) {
+      // Up move: skip a point in S
+      --x;
+    }
+  }
+}
+
+// Computes the SED with the Landau-Vishkin diagonal DP into caller-owned
+// buffers. Returns false if the SED exceeds the threshold.
+bool diagonalSEDInto(const CurveString& S, const CurveString& T,
+                     double threshold, vector<int>& D, vector<int>& L,
+                     Matching& M, GEDStats* stats) {
+  size_t n = S.size();
+  size_t m = T.size();
+  int k = static_cast<int>(floor(threshold));
+  M.clear();
+
+  // Step 1: Initialize the DP table D, banded to the diagonals within k
+  SEDTableLayout layout(n, m, max(k, 0));
+  D.assign((n + 1) * layout.width, -1);
+  for (size_t i = 0; i <= n && layout.contains(i, 0); ++i) {
+    D[layout.index(i, 0)] = static_cast<int>(i);
+  }
+  for (size_t j = 0; j <= m && layout.contains(0, j); ++j) {
+    D[layout.index(0, j)] = static_cast<int>(j);
+  }
+
+  // Step 2: Initialize the vector L(that saves L values for each h and e) with
+  // length 2k+3
+  L.assign(2 * (k + 1) + 1, -1);
+
+  // Step 3: Dynamic programming loop
+  for (int e = 0; e <= k; ++e) {
+    // Set initial values for L_h,e of diagonal -(e+1), (e+1)
+    L[(k + 1) - (e + 1)] = e;   // h < 0: L_h,|h|-2 to |h|-1
+    L[(k + 1) + (e + 1)] = -1;  // h >= 0: L_h,|h|-2 to -1
+
+    for (int h = -e; h <= e; ++h) {
+      // Algorithm 3(from referenced paper)
+      if (abs(h) % 2 != e % 2)
+        continue;  // L_h,e is well-defined only if (h mod 2) == (e mod 2)
+
+      // Check if substitution values are infinity
+      if (L[(k + 1) + h - 1] == numeric_limits<int>::max() ||
+          L[(k + 1) + h + 1] == numeric_limits<int>::max()) {
+        L[(k + 1) + h] =
+            numeric_limits<int>::max();  // Set L[k + h] to infinity
+        continue;
+      }
+
+      // Compute r based on L
+      int r = max(L[(k + 1) + h - 1], L[(k + 1) + h + 1] + 1);
+      STATS_ADD_PTR(stats, sedDiagonals, 1);
+
+      // Slide
+      if (r >= 0 && r <= n && r + h >= 0 && r + h <= m) {
+        D[layout.index(r, r + h)] = e;
+      }
+      while (r + 1 > 0 && r + 1 <= n && r + h + 1 > 0 && r + h + 1 <= m &&
+             (S[(r + 1) - 1] == T[(r + h + 1) - 1])) {
+        D[layout.index(r + 1, r + h + 1)] = e;
+        ++r;
+        STATS_ADD_PTR(stats, slideLength, 1);
+      }
+
+      // Set L_h,e
+      if (r > static_cast<int>(n) || r + h > static_cast<int>(m)) {
+        L[(k + 1) + h] = numeric_limits<int>::max();  // Set to "infinity"
+      } else {
+        L[(k + 1) + h] = r;
+      }
+    }
+  }
+
+  // Step 4: Check if the edit distance is within the threshold
+  if (layout.value(D, n, m) == -1) {
+    return false;  // Leave the matching empty
+  }
+
+  // Step 5: Backtrace the DP table into the matching
+  backtraceInto(D, layout, n, m, M);
+  return true;
+}
+
+// Computes the SED of the workspace strings into workspace.matching. Returns
+// false if the SED exceeds the threshold.
+bool sedInto(double threshold, Workspace& workspace, GEDStats* stats) {
+  const CurveString& S = workspace.stringP;
+  const CurveString& T = workspace.stringQ;
+  STATS_ADD_PTR(stats, sedCalls, 1);
+
+  // Use the shorter string as the query of the bit-parallel backend
+  if (S.size() <= T.size() && BitParallelSED::fitsQuery(S.size())) {
+    workspace.bitParallel.reset(S);
+    return workspace.bitParallel.matchInto(T, threshold, workspace.matching,
+                                           workspace.sedColumns, stats);
+  }
+  if (T.size() < S.size() && BitParallelSED::fitsQuery(T.size())) {
+    workspace.bitParallel.reset(T);
+    if (!workspace.bitParallel.matchInto(S, threshold, workspace.matching,
+                                         workspace.sedColumns, stats)) {
+      return false;
+    }
+    for (auto& match : workspace.matching) {
+      swap(match.first, match.second);  // Restore (index in S, index in T)
+    }
+    return true;
+  }
+
+  return diagonalSEDInto(S, T, threshold, workspace.sedTable,
+                         workspace.sedDiagonals, workspace.matching, stats);
+}
+
+// Runs the randomized trials of grid level i and leaves the first matching
+// found in workspace.matching. Returns false if every trial fails.
+bool tryGridLevel(const PolygonalCurve& P, const PolygonalCurve& Q, int i,
+                  Workspace& workspace, GEDStats* stats,
+                  const CancellationToken* cancel) {
+  size_t n = min(P.numPoints(), Q.numPoints());
+  int g = static_cast<int>(pow(2, i));
+  int maxJ = static_cast<int>(ceil(9.0 * log(n)));  // Assuming c=9
+  double threshold = 12 * sqrt(n) + 2 * g;
+
+  // The SED is at least the length difference for every grid shift, so the
+  // whole level fails without running a trial
+  double lengthDifference =
+      fabs(static_cast<double>(P.numPoints()) - Q.numPoints());
+  if (lengthDifference > floor(threshold)) {
+    STATS_ADD_PTR(stats, skippedLevels, 1);
+    return false;
+  }
+  STATS_ADD_PTR(stats, levels, 1);
+
+  for (int j = 0; j <= maxJ; ++j) {
+    if (cancel && cancel->stopRequested()) return false;
+    STATS_ADD_PTR(stats, trials, 1);
+
+    // Transform curves into strings
+    {
+      STATS_TIMER_PTR(stats, transformSeconds);
+      transformCurvesInto(P, Q, g, workspace);
+    }
+
+    // Compute String Edit Distance (SED). Failing trials are abandoned as
+    // soon as the partial SED exceeds the threshold.
+    bool success;
+    {
+      STATS_TIMER_PTR(stats, sedSeconds);
+      success = sedInto(threshold, workspace, stats);
+    }
+
+    if (success && !workspace.matching.empty()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Approximation of GED with the buffers of ws. The bracket of result spans
+// the lower bound and the cheapest feasible cost seen. If cancel requests a
+// stop, the levels stop at the next trial and the value is the cheapest
+// feasible cost.
+void approximateGEDInto(const PolygonalCurve& P, const PolygonalCurve& Q,
+                        Workspace& ws, GEDStats* stats,
+                        const CancellationToken* cancel,
+                        AnytimeResult& result) {
+  size_t n = min(P.numPoints(), Q.numPoints());
+  Matching& approximationMatching = ws.bestMatching;
+  approximationMatching.clear();
 
   // Step 1: Check the sum of distances between corresponding points
   double totalDistance = 0.0;
@@ -22,43 +280,161 @@ double computeSquareRootApproxGED(const PolygonalCurve& P,
     double dy = P.getPoint(i).y() - Q.getPoint(i).y();
     totalDistance += sqrt(dx * dx + dy * dy);
   }
+  GEDBounds bounds = computeGEDBounds(P, Q, totalDistance);
+  result.lower = bounds.lower;
+  result.upper = bounds.upper;
+  result.status = AnytimeStatus::Complete;
 
   // If sum of distances is less or equal to 1
   if (totalDistance <= 1.0) {
     // Construct a matching [(0, 0), (1, 1), ..., (n-1, n-1)]
-    Matching approximationMatching;
     for (size_t i = 0; i < n; ++i) {
       approximationMatching.emplace_back(i, i);
     }
-    return computeCost(P, Q, approximationMatching);
+    result.value = computeCost(P, Q, approximationMatching);
+    result.upper = min(result.upper, result.value);
+    return;
+  }
+
+  // Step 2: Schedule the grid levels. Level i uses g = 2^i and succeeds with
+  // high probability once g >= GED, so the levels below the lower bound are
+  // skipped and the first successful level up to the upper bound is found by
+  // binary search instead of a linear scan.
+  int maxLevel = static_cast<int>(ceil(log2(n)));
+  int low = min(maxLevel, levelAtMost(bounds.lower));
+  int high = max(low, min(maxLevel, levelAtLeast(bounds.upper)));
+  auto stopped = [cancel]() { return cancel && cancel->stopRequested(); };
+
+  bool found = false;
+  int left = low;
+  int right = high;
+  while (left <= right && !stopped()) {
+    int mid = left + (right - left) / 2;
+    if (tryGridLevel(P, Q, mid, ws, stats, cancel)) {
+      // Keep the matching and try the lower levels
+      approximationMatching.swap(ws.matching);
+      result.upper =
+          min(result.upper, computeCost(P, Q, approximationMatching));
+      found = true;
+      right = mid - 1;
+    } else {
+      left = mid + 1;
+    }
   }
 
-  // Step 2: Approximation
-  for (int i = 0; i <= ceil(log2(n)); ++i) {
-    int g = static_cast<int>(pow(2, i));
-    int maxJ = static_cast<int>(ceil(9.0 * log(n)));  // Assuming c=9
+  // Step 3: If every scheduled level failed, continue with the levels above
+  // the upper bound as the original linear scan would
+  for (int i = high + 1; !found && i <= maxLevel && !stopped(); ++i) {
+    found = tryGridLevel(P, Q, i, ws, stats, cancel);
+    if (found) approximationMatching.swap(ws.matching);
+  }
+  if (stopped()) {
+    result.value = result.upper;
+    result.status = cancel->stopReason();
+    return;
+  }
 
-    for (int j = 0; j <= maxJ; ++j) {
-      // Transform curves into strings
-      CurveStringPair transformedStrings = transformCurvesToStrings(P, Q, g);
+  // If a matching is found, return the cost(which is O(n^(1/2))-approximation
+  // of GED)
+  if (found) {
+    result.value = computeCost(P, Q, approximationMatching);
+    result.upper = min(result.upper, result.value);
+    return;
+  }
 
-      // Compute String Edit Distance (SED)
-      Matching approximationMatching =
-          SED(transformedStrings.first, transformedStrings.second,
-              12 * sqrt(n) + 2 * g);
+  // Step 4: Return cost for empty matching if no matching found during the
+  // iteration
+  approximationMatching.clear();
+  result.value = computeCost(P, Q, approximationMatching);
+}
 
-      // If a matching is found, return the cost(which is
-      // O(n^(1/2))-approximation of GED)
-      if (!approximationMatching.empty()) {
-        return computeCost(P, Q, approximationMatching);
-      }
+}  // namespace
+
+// Computes O(n^(1/2))-approximation of GED
+double computeSquareRootApproxGED(const PolygonalCurve& P,
+                                  const PolygonalCurve& Q, GEDStats* stats,
+                                  Workspace* workspace) {
+  STATS_TIMER_PTR(stats, seconds);
+
+  // Without a workspace the buffers live for this call only
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+  AnytimeResult result;
+  approximateGEDInto(P, Q, ws, stats, nullptr, result);
+  return result.value;
+}
+
+// Computes the approximation of GED with a stop request
+AnytimeResult computeAnytimeApproxGED(const PolygonalCurve& P,
+                                      const PolygonalCurve& Q,
+                                      const CancellationToken& cancel,
+                                      GEDStats* stats, Workspace* workspace) {
+  STATS_TIMER_PTR(stats, seconds);
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+  AnytimeResult result;
+  approximateGEDInto(P, Q, ws, stats, &cancel, result);
+  result.lower = min(result.lower, result.upper);
+  return result;
+}
+
+// Computes the exact GED by the O(pq) edit distance DP with two rows
+double computeExactGED(const PolygonalCurve& P, const PolygonalCurve& Q,
+                       Workspace* workspace) {
+  size_t p = P.numPoints();
+  size_t q = Q.numPoints();
+
+  // Without a workspace the rows live for this call only
+  Workspace localWorkspace;
+  Workspace& ws = workspace ? *workspace : localWorkspace;
+  ws.gedRows.resize(2 * (q + 1));
+  double* previous = ws.gedRows.data();
+  double* current = previous + (q + 1);
+
+  // D[i][j] is the GED of the first i points of P and the first j points of
+  // Q: skipping a point costs 1, matching two points costs their distance
+  for (size_t j = 0; j <= q; ++j) previous[j] = static_cast<double>(j);
+  const double* qx = Q.xData();
+  const double* qy = Q.yData();
+  for (size_t i = 1; i <= p; ++i) {
+    double px = P.xData()[i - 1], py = P.yData()[i - 1];
+    current[0] = static_cast<double>(i);
+    for (size_t j = 1; j <= q; ++j) {
+      double dx = px - qx[j - 1], dy = py - qy[j - 1];
+      double match = previous[j - 1] + sqrt(dx * dx + dy * dy);
+      double skip = min(previous[j], current[j - 1]) + 1.0;
+      current[j] = min(match, skip);
     }
+    swap(previous, current);
   }
+  return previous[q];
+}
 
-  // Step 3: Return cost for empty matching if no matching found during the
-  // iteration
-  Matching emptyMatching;
-  return computeCost(P, Q, emptyMatching);
+// Computes cheap lower and upper bounds of GED for scheduling the grid levels
+GEDBounds computeGEDBounds(const PolygonalCurve& P, const PolygonalCurve& Q,
+                           double lockstepDistance) {
+  size_t p = P.numPoints();
+  size_t q = Q.numPoints();
+  size_t n = min(p, q);
+  double unmatched = fabs(static_cast<double>(p) - static_cast<double>(q));
+
+  // Step 1: The bounding boxes of P and Q come from the summaries
+  const CurveSummary& boxP = P.summary();
+  const CurveSummary& boxQ = Q.summary();
+
+  // Step 2: Every matched pair costs at least the gap between the boxes and
+  // every unmatched point costs 1, so with at most n matched pairs
+  // GED >= |p - q| + n * min(gap, 2)
+  double gapX = max(0.0, max(boxP.minX - boxQ.maxX, boxQ.minX - boxP.maxX));
+  double gapY = max(0.0, max(boxP.minY - boxQ.maxY, boxQ.minY - boxP.maxY));
+  double gap = sqrt(gapX * gapX + gapY * gapY);
+
+  GEDBounds bounds;
+  bounds.lower = unmatched + n * min(gap, 2.0);
+
+  // Step 3: The lockstep matching and the empty matching are both feasible
+  bounds.upper = min(lockstepDistance + unmatched, static_cast<double>(p + q));
+  return bounds;
 }
 
 // Computes the GED cost for given matching for two polygonal curves P, Q
@@ -86,116 +462,61 @@ double computeCost(const PolygonalCurve& P, const PolygonalCurve& Q,
 
 // Transfroms the curves into string by randomly shifted grid
 CurveStringPair transformCurvesToStrings(const PolygonalCurve& P,
-                                         const PolygonalCurve& Q, int g) {
+                                         const PolygonalCurve& Q, int g,
+                                         mt19937* generator) {
   size_t n = min(P.numPoints(), Q.numPoints());
 
   // Step 1: Calculate delta
   double delta = g / sqrt(n);
 
   // Step 2: Pick random values x_o, y_o in [0, delta]
-  random_device rd;
-  mt19937 gen(rd());
+  mt19937 randomGenerator;
+  if (!generator) {
+    randomGenerator.seed(random_device()());
+    generator = &randomGenerator;
+  }
   uniform_real_distribution<> dis(0.0, delta);
 
-  double x_o = dis(gen);
-  double y_o = dis(gen);
-
-  // Step 3: Copy P and Q
-  PolygonalCurve convertedP = P;
-  PolygonalCurve convertedQ = Q;
-
-  // Step 4: Set the new origin for both curves
-  convertedP.shiftOrigin(Point_2(x_o, y_o));
-  convertedQ.shiftOrigin(Point_2(x_o, y_o));
+  double x_o = dis(*generator);
+  double y_o = dis(*generator);
 
-  // Step 5: Scale the grid with delta as the scaling factor
-  convertedP.scaleGrid(delta);
-  convertedQ.scaleGrid(delta);
-
-  // Step 6: Floor the coordinates of the points
-  convertedP.floorCoordinates();
-  convertedQ.floorCoordinates();
-
-  // Step 7: Set CurveStrings with converted curves
+  // Step 3: Shift the origin, scale the grid by delta and floor the
+  // coordinates
   CurveString stringP, stringQ;
-  for (size_t i = 0; i < convertedP.numPoints(); ++i) {
-    stringP.emplace_back(static_cast<int>(convertedP.getPoint(i).x()),
-                         static_cast<int>(convertedP.getPoint(i).y()));
-  }
-  for (size_t i = 0; i < convertedQ.numPoints(); ++i) {
-    stringQ.emplace_back(static_cast<int>(convertedQ.getPoint(i).x()),
-                         static_cast<int>(convertedQ.getPoint(i).y()));
-  }
+  quantizeCurve(P, x_o, y_o, delta, stringP);
+  quantizeCurve(Q, x_o, y_o, delta, stringQ);
 
-  // Step 8: Return the CurveStringPair
+  // Step 4: Return the CurveStringPair
   return {stringP, stringQ};
 }
 
 // Computes the String Edit Distance (SED) for GED
-Matching SED(const CurveString& S, const CurveString& T, double threshold) {
-  size_t n = S.size();
-  size_t m = T.size();
-  int k = static_cast<int>(floor(threshold));
+Matching SED(const CurveString& S, const CurveString& T, double threshold,
+             GEDStats* stats) {
+  STATS_ADD_PTR(stats, sedCalls, 1);
 
-  // Step 1: Initialize the (n+1) by (n+1) DP table D
-  vector<vector<int>> D(n + 1, vector<int>(m + 1, -1));
-  for (size_t i = 0; i <= n; ++i) {
-    D[i][0] = static_cast<int>(i);
-  }
-  for (size_t j = 0; j <= m; ++j) {
-    D[0][j] = static_cast<int>(j);
+  // Use the shorter string as the query of the bit-parallel backend
+  if (S.size() <= T.size() && BitParallelSED::fitsQuery(S.size())) {
+    return BitParallelSED(S).match(T, threshold, stats);
   }
-
-  // Step 2: Initialize the vector L(that saves L values for each h and e) with
-  // length 2k+3
-  vector<int> L(2 * (k + 1) + 1, -1);
-
-  // Step 3: Dynamic programming loop
-  for (int e = 0; e <= k; ++e) {
-    // Set initial values for L_h,e of diagonal -(e+1), (e+1)
-    L[(k + 1) - (e + 1)] = e;   // h < 0: L_h,|h|-2 to |h|-1
-    L[(k + 1) + (e + 1)] = -1;  // h >= 0: L_h,|h|-2 to -1
-
-    for (int h = -e; h <= e; ++h) {
-      // Algorithm 3(from referenced paper)
-      if (abs(h) % 2 != e % 2)
-        continue;  // L_h,e is well-defined only if (h mod 2) == (e mod 2)
-
-      // Check if substitution values are infinity
-      if (L[(k + 1) + h - 1] == numeric_limits<int>::max() ||
-          L[(k + 1) + h + 1] == numeric_limits<int>::max()) {
-        L[(k + 1) + h] =
-            numeric_limits<int>::max();  // Set L[k + h] to infinity
-        continue;
-      }
-
-      // Compute r based on L
-      int r = max(L[(k + 1) + h - 1], L[(k + 1) + h + 1] + 1);
-
-      // Slide
-      if (r >= 0 && r <= n && r + h >= 0 && r + h <= m) D[r][r + h] = e;
-      while (r + 1 > 0 && r + 1 <= n && r + h + 1 > 0 && r + h + 1 <= m &&
-             (S[(r + 1) - 1] == T[(r + h + 1) - 1])) {
-        D[r + 1][r + h + 1] = e;
-        ++r;
-      }
-
-      // Set L_h,e
-      if (r > static_cast<int>(n) || r + h > static_cast<int>(m)) {
-        L[(k + 1) + h] = numeric_limits<int>::max();  // Set to "infinity"
-      } else {
-        L[(k + 1) + h] = r;
-      }
+  if (T.size() < S.size() && BitParallelSED::fitsQuery(T.size())) {
+    Matching M = BitParallelSED(T).match(S, threshold, stats);
+    for (auto& match : M) {
+      swap(match.first, match.second);  // Restore (index in S, index in T)
     }
+    return M;
   }
 
-  // Step 4: Check if the edit distance is within the threshold
-  if (D[n][m] == -1) {
-    return {};  // Return empty matching
-  }
+  return diagonalSED(S, T, threshold, stats);
+}
 
-  // Step 5: Backtrace the DP table and return matching
-  return backtrace(D);
+// Computes the SED for GED with the Landau-Vishkin diagonal DP
+Matching diagonalSED(const CurveString& S, const CurveString& T,
+                     double threshold, GEDStats* stats) {
+  vector<int> D, L;
+  Matching M;
+  diagonalSEDInto(S, T, threshold, D, L, M, stats);
+  return M;
 }
 
 // Backtrace the DP table and return matching
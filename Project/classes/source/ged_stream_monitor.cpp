@@ -0,0 +1,306 @@
+#include "ged_stream_monitor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// Largest grid level i with 2^i <= max(value, 1)
+int levelAtMost(double value) {
+  return value <= 1.0 ? 0 : static_cast<int>(floor(log2(value)));
+}
+
+// Keeps the window extremes of a coordinate at the front of a monotone
+// deque: positions that left the window or can no longer be an extreme are
+// dropped
+template <typename Better>
+void slideExtreme(deque<uint64_t>& extremes, const vector<double>& values,
+                  size_t window, uint64_t position, Better better) {
+  while (!extremes.empty() && extremes.front() + window <= position) {
+    extremes.pop_front();
+  }
+  double value = values[position % window];
+  while (!extremes.empty() &&
+         !better(values[extremes.back() % window], value)) {
+    extremes.pop_back();
+  }
+  extremes.push_back(position);
+}
+
+}  // namespace
+
+// Constructor to watch the references
+GEDStreamMonitor::GEDStreamMonitor(const vector<PolygonalCurve>& references,
+                                   const GEDMonitorOptions& options)
+    : options(options), count(0) {
+  size_t W = options.window;
+  if (W == 0) {
+    throw invalid_argument("The window must hold at least one point.");
+  }
+  this->options.maxActiveShifts = max<size_t>(1, options.maxActiveShifts);
+  xs.assign(2 * W, 0.0);
+  ys.assign(2 * W, 0.0);
+
+  for (const PolygonalCurve& curve : references) {
+    if (curve.numPoints() == 0) {
+      throw invalid_argument("A reference curve has no points.");
+    }
+    Reference reference;
+    reference.curve = curve;
+    reference.n = min(W, curve.numPoints());
+    reference.maxLevel = static_cast<int>(ceil(log2(reference.n)));
+    reference.trials =
+        options.trialsPerLevel > 0
+            ? options.trialsPerLevel
+            : static_cast<size_t>(ceil(9.0 * log(reference.n))) + 1;
+    reference.shifts.resize((reference.maxLevel + 1) * reference.trials);
+    reference.above = false;
+    this->references.push_back(move(reference));
+  }
+}
+
+// Getters
+uint64_t GEDStreamMonitor::numPoints() const { return count; }
+size_t GEDStreamMonitor::numReferences() const { return references.size(); }
+bool GEDStreamMonitor::isAbove(size_t reference) const {
+  return references.at(reference).above;
+}
+GEDEstimate GEDStreamMonitor::getEstimate(size_t reference) const {
+  return references.at(reference).estimate;
+}
+const GEDMonitorStats& GEDStreamMonitor::getStats() const { return stats; }
+
+// Start of the current window in the doubled buffers
+size_t GEDStreamMonitor::windowStart() const { return count % options.window; }
+
+// Quantizes a point on the grid of a shift, as GED::transformCurvesToStrings
+CurveAlphabet GEDStreamMonitor::quantize(const Shift& shift, double x,
+                                         double y) {
+  return {static_cast<int>(floor((x - shift.originX) / shift.delta)),
+          static_cast<int>(floor((y - shift.originY) / shift.delta))};
+}
+
+// Adds the point at position to a shift
+void GEDStreamMonitor::advance(Shift& shift, uint64_t position) {
+  size_t W = options.window;
+  size_t slot = position % W;
+  CurveAlphabet code = quantize(shift, xs[slot], ys[slot]);
+  shift.codes[slot] = shift.codes[slot + W] = code;
+
+  // Step 1: Comb the column of the point through the rows of the reference.
+  // Two seaweeds meeting in a cell cross unless the symbols match or they
+  // have crossed before (then the left one has the larger id).
+  int64_t m = static_cast<int64_t>(shift.reference.size());
+  int64_t seaweed = m + static_cast<int64_t>(position);  // From the top
+  for (int64_t i = 0; i < m; ++i) {
+    int64_t left = shift.strands[i];
+    if (shift.reference[i] == code || left > seaweed) {
+      shift.strands[i] = seaweed;
+      seaweed = left;
+    }
+  }
+  stats.combedCells += m;
+
+  // Step 2: The oldest column left the window; seaweeds that started there
+  // no longer start inside it
+  size_t oldest = slot;  // (position - W) % W
+  shift.inWindow -= shift.counts[oldest];
+  shift.counts[oldest] = 0;
+
+  // Step 3: Count the seaweed leaving at the bottom if it started at the
+  // top of a column of the window. LCS(reference, window) is W minus the
+  // seaweeds that start and end inside the window.
+  if (seaweed >= m) {
+    int64_t start = seaweed - m;
+    if (start + static_cast<int64_t>(W) > static_cast<int64_t>(position)) {
+      ++shift.inWindow;
+      ++shift.counts[start % W];
+    }
+  }
+}
+
+// Returns the shift of (level, trial), built from the window if inactive
+GEDStreamMonitor::Shift& GEDStreamMonitor::activate(size_t index, int level,
+                                                    size_t trial) {
+  Reference& reference = references[index];
+  unique_ptr<Shift>& slot = reference.shifts[level * reference.trials + trial];
+
+  // Task 1: Draw the grid of the shift once, as transformCurvesToStrings
+  if (!slot) {
+    slot.reset(new Shift());
+    Shift& shift = *slot;
+    shift.delta = pow(2, level) / sqrt(reference.n);
+    seed_seq seed{options.seed, static_cast<uint32_t>(index),
+                  static_cast<uint32_t>(level), static_cast<uint32_t>(trial)};
+    mt19937 generator(seed);
+    uniform_real_distribution<> dis(0.0, shift.delta);
+    shift.originX = dis(generator);
+    shift.originY = dis(generator);
+    const PolygonalCurve& curve = reference.curve;
+    for (size_t i = 0; i < curve.numPoints(); ++i) {
+      shift.reference.push_back(
+          quantize(shift, curve.xData()[i], curve.yData()[i]));
+    }
+    shift.isActive = false;
+  }
+  Shift& shift = *slot;
+  shift.lastUsed = count;
+  if (shift.isActive) return shift;
+
+  // Task 2: Make room by dropping the least recently used shift
+  auto& active = reference.active;
+  if (active.size() >= options.maxActiveShifts) {
+    auto oldest = min_element(active.begin(), active.end(),
+                              [](const Shift* a, const Shift* b) {
+                                return a->lastUsed < b->lastUsed;
+                              });
+    (*oldest)->isActive = false;
+    (*oldest)->codes = CurveString();
+    (*oldest)->strands = vector<int64_t>();
+    (*oldest)->counts = vector<int>();
+    active.erase(oldest);
+  }
+
+  // Task 3: Comb the window from fresh seaweeds
+  size_t W = options.window;
+  size_t m = shift.reference.size();
+  shift.codes.assign(2 * W, {0, 0});
+  shift.strands.resize(m);
+  for (size_t i = 0; i < m; ++i) shift.strands[i] = static_cast<int64_t>(i);
+  shift.counts.assign(W, 0);
+  shift.inWindow = 0;
+  for (uint64_t position = count - W; position < count; ++position) {
+    advance(shift, position);
+  }
+  shift.isActive = true;
+  active.push_back(&shift);
+  ++stats.activations;
+  return shift;
+}
+
+// Adds the next point of the stream
+void GEDStreamMonitor::addPoint(double x, double y, vector<GEDAlert>& alerts) {
+  size_t W = options.window;
+  uint64_t position = count;
+  size_t slot = position % W;
+  xs[slot] = xs[slot + W] = x;
+  ys[slot] = ys[slot + W] = y;
+  slideExtreme(minX, xs, W, position, less<double>());
+  slideExtreme(maxX, xs, W, position, greater<double>());
+  slideExtreme(minY, ys, W, position, less<double>());
+  slideExtreme(maxY, ys, W, position, greater<double>());
+  ++count;
+  ++stats.points;
+
+  // Step 1: Every active shift takes the point
+  for (Reference& reference : references) {
+    for (Shift* shift : reference.active) advance(*shift, position);
+  }
+  if (count < W) return;
+
+  // Step 2: Evaluate the window and raise the crossings
+  double threshold = options.threshold;
+  for (size_t r = 0; r < references.size(); ++r) {
+    GEDEstimate estimate = evaluate(r);
+    bool above = estimate.lower > threshold;
+    Reference& reference = references[r];
+    reference.estimate = estimate;
+    if (above != reference.above) {
+      alerts.push_back({r, position, above, estimate});
+      reference.above = above;
+    }
+  }
+}
+
+// Evaluates the current window against a reference
+GEDEstimate GEDStreamMonitor::evaluate(size_t index) {
+  Reference& reference = references[index];
+  double W = static_cast<double>(options.window);
+  double m = static_cast<double>(reference.curve.numPoints());
+  double n = static_cast<double>(reference.n);
+  double threshold = options.threshold;
+  ++stats.windows;
+
+  // Step 1: The length and box bound of GED::computeGEDBounds with the
+  // sliding box of the window
+  const CurveSummary& box = reference.curve.summary();
+  double windowMinX = xs[minX.front() % options.window];
+  double windowMaxX = xs[maxX.front() % options.window];
+  double windowMinY = ys[minY.front() % options.window];
+  double windowMaxY = ys[maxY.front() % options.window];
+  double gapX = max(0.0, max(windowMinX - box.maxX, box.minX - windowMaxX));
+  double gapY = max(0.0, max(windowMinY - box.maxY, box.minY - windowMaxY));
+  double lowerBound =
+      fabs(W - m) + n * min(sqrt(gapX * gapX + gapY * gapY), 2.0);
+  if (lowerBound > threshold) {
+    ++stats.boundSkips;
+    return {lowerBound, numeric_limits<double>::infinity()};
+  }
+
+  // Step 2: Binary search for the lowest level with a successful trial. The
+  // SED of an active shift is available without work.
+  int found = -1;
+  Shift* best = nullptr;
+  double bestSED = 0.0, bestLCS = 0.0;
+  int left = min(reference.maxLevel, levelAtMost(lowerBound));
+  int right = reference.maxLevel;
+  while (left <= right) {
+    int mid = left + (right - left) / 2;
+    double limit = floor(12 * sqrt(n) + 2 * pow(2, mid));
+    Shift* success = nullptr;
+    double sed = 0.0, lcs = 0.0;
+    if (fabs(W - m) <= limit) {
+      for (size_t trial = 0; trial < reference.trials; ++trial) {
+        Shift& shift = activate(index, mid, trial);
+        lcs = W - static_cast<double>(shift.inWindow);
+        sed = W + m - 2 * lcs;
+        if (sed <= limit) {
+          success = &shift;
+          break;
+        }
+      }
+    }
+    if (success) {
+      found = mid;
+      best = success;
+      bestSED = sed;
+      bestLCS = lcs;
+      right = mid - 1;
+    } else {
+      left = mid + 1;
+    }
+  }
+
+  // Without a successful level the matching is empty
+  if (found < 0) {
+    ++stats.bracketed;
+    return {W + m, W + m};
+  }
+
+  // Step 3: Matched points share a cell, so each costs less than its
+  // diagonal. The bracket decides the window unless it holds the threshold.
+  GEDEstimate estimate;
+  estimate.lower = max(bestSED, lowerBound);
+  estimate.upper = bestSED + bestLCS * best->delta * sqrt(2.0);
+  if (estimate.lower > threshold || estimate.upper <= threshold) {
+    ++stats.bracketed;
+    return estimate;
+  }
+
+  // Step 4: The cost of the matching of the window
+  size_t start = windowStart();
+  CurveString window(best->codes.begin() + start,
+                     best->codes.begin() + start + options.window);
+  double limit = floor(12 * sqrt(n) + 2 * pow(2, found));
+  Matching matching = GED::SED(window, best->reference, limit);
+  PolygonalCurve curve = PolygonalCurve::borrow(
+      CurveView(xs.data() + start, ys.data() + start, options.window));
+  double cost = GED::computeCost(curve, reference.curve, matching);
+  ++stats.matchings;
+  return {cost, cost};
+}
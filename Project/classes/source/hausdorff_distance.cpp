@@ -0,0 +1,325 @@
+#include "hausdorff_distance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+// Squared distance from (x, y) to the segment from a to b
+double segmentDistance2(double x, double y, const Point_2& a,
+                        const Point_2& b) {
+  double dx = b.x() - a.x(), dy = b.y() - a.y();
+  double ex = x - a.x(), ey = y - a.y();
+  double len2 = dx * dx + dy * dy;
+  double t = len2 > 0 ? (ex * dx + ey * dy) / len2 : 0.0;
+  t = min(max(t, 0.0), 1.0);
+  ex -= t * dx;
+  ey -= t * dy;
+  return ex * ex + ey * ey;
+}
+
+// Search radius for a distance bound. The bounding box filters must not
+// drop a segment at exactly the bound because of rounding.
+double searchRadius(double bound) { return bound + 1e-9 * max(bound, 1.0); }
+
+// Sign of the turn a -> b -> c
+int orientation(const Point_2& a, const Point_2& b, const Point_2& c) {
+  double cross = (b.x() - a.x()) * (c.y() - a.y()) -
+                 (b.y() - a.y()) * (c.x() - a.x());
+  return (cross > 0) - (cross < 0);
+}
+
+// Distance between the segments ab and cd
+double segmentSegmentDistance(const Point_2& a, const Point_2& b,
+                              const Point_2& c, const Point_2& d) {
+  if (orientation(a, b, c) * orientation(a, b, d) < 0 &&
+      orientation(c, d, a) * orientation(c, d, b) < 0) {
+    return 0.0;  // Proper crossing
+  }
+  double d2 = min(min(segmentDistance2(a.x(), a.y(), c, d),
+                      segmentDistance2(b.x(), b.y(), c, d)),
+                  min(segmentDistance2(c.x(), c.y(), a, b),
+                      segmentDistance2(d.x(), d.y(), a, b)));
+  return sqrt(d2);
+}
+
+// Real roots of a t^2 + b t + c = 0 (a double root is reported once)
+int solveQuadratic(double a, double b, double c, double roots[2]) {
+  double scale = max(max(fabs(a), fabs(b)), fabs(c));
+  if (scale == 0.0) return 0;  // Identical functions
+  if (fabs(a) <= 1e-12 * scale) {
+    if (fabs(b) <= 1e-12 * scale) return 0;
+    roots[0] = -c / b;
+    return 1;
+  }
+  double disc = b * b - 4 * a * c;
+  if (disc < 0) {
+    // Tangent functions whose contact is lost to rounding
+    if (disc < -1e-9 * (b * b + fabs(4 * a * c))) return 0;
+    disc = 0;
+  }
+  double q = -0.5 * (b + copysign(sqrt(disc), b));
+  if (q == 0.0) {
+    roots[0] = 0.0;
+    return 1;
+  }
+  roots[0] = q / a;
+  roots[1] = c / q;
+  return disc == 0 ? 1 : 2;
+}
+
+// Appends the squared distance along A + t D to a vertex of the other curve
+// as the quadratic c2 t^2 + c1 t + c0
+void addVertexFeature(const Point_2& A, double dx, double dy,
+                      const Point_2& v, vector<double>& features) {
+  double ex = A.x() - v.x(), ey = A.y() - v.y();
+  features.push_back(dx * dx + dy * dy);
+  features.push_back(2 * (dx * ex + dy * ey));
+  features.push_back(ex * ex + ey * ey);
+}
+
+// Appends the squared distance along A + t D to the line through a and b
+void addLineFeature(const Point_2& A, double dx, double dy, const Point_2& a,
+                    const Point_2& b, vector<double>& features) {
+  double lx = b.x() - a.x(), ly = b.y() - a.y();
+  double length = sqrt(lx * lx + ly * ly);
+  if (length == 0) return;
+  double nx = -ly / length, ny = lx / length;
+  double s0 = nx * (A.x() - a.x()) + ny * (A.y() - a.y());
+  double s1 = nx * dx + ny * dy;
+  features.push_back(s1 * s1);
+  features.push_back(2 * s0 * s1);
+  features.push_back(s0 * s0);
+}
+
+// Largest distance from a point of from to to, given the grid of to. Values
+// not above best are not resolved, so the result is max(best, h(from, to)).
+// The sweep returns as soon as the result exceeds stop.
+double directedSweep(const PolygonalCurve& from, const PolygonalCurve& to,
+                     const SegmentGrid& grid, double best, double stop,
+                     Workspace& workspace, HausdorffStats* stats) {
+  int n = from.numPoints();
+  int m = to.numPoints();
+  if (n == 0 || m == 0) {
+    throw invalid_argument("Hausdorff distance of an empty curve.");
+  }
+
+  // A single point: the distance along a segment is convex, so the maximum
+  // is at a vertex
+  if (m == 1) {
+    for (int v = 0; v < n; ++v) {
+      double dx = from.getPoint(v).x() - to.getPoint(0).x();
+      double dy = from.getPoint(v).y() - to.getPoint(0).y();
+      best = max(best, sqrt(dx * dx + dy * dy));
+    }
+    return best;
+  }
+
+  vector<double>& bounds = workspace.hausdorffBounds;
+  vector<int>& segments = workspace.gridCandidates;
+  vector<double>& features = workspace.hausdorffFeatures;
+  bounds.resize(n);
+
+  // Step 1: Vertices. bounds[v] is the distance of vertex v, or an upper
+  // bound of it if the scan stopped early. On similar curves the nearest
+  // segment is usually next to the one of the previous vertex, so those are
+  // tried before the grid.
+  int hint = 0;  // Nearest segment of the previous vertex
+  for (int v = 0; v < n; ++v) {
+    const Point_2& point = from.getPoint(v);
+    double best2 = best * best;
+    double nearest2 = numeric_limits<double>::infinity();
+    for (int s = max(hint - 1, 0); s <= min(hint + 1, m - 2); ++s) {
+      double d2 = segmentDistance2(point.x(), point.y(), to.getPoint(s),
+                                   to.getPoint(s + 1));
+      if (d2 < nearest2) {
+        nearest2 = d2;
+        hint = s;
+      }
+    }
+
+    if (nearest2 > best2) {
+      // The distance is 1-Lipschitz along the curve
+      double radius = sqrt(nearest2);
+      if (v > 0) {
+        double dx = point.x() - from.getPoint(v - 1).x();
+        double dy = point.y() - from.getPoint(v - 1).y();
+        radius = min(radius, bounds[v - 1] + sqrt(dx * dx + dy * dy));
+      }
+      grid.query(point, searchRadius(radius), segments);
+      STATS_ADD_PTR(stats, vertexQueries, 1);
+      STATS_ADD_PTR(stats, candidateSegments, segments.size());
+      for (int s : segments) {
+        double d2 = segmentDistance2(point.x(), point.y(), to.getPoint(s),
+                                     to.getPoint(s + 1));
+        if (d2 < nearest2) {
+          nearest2 = d2;
+          hint = s;
+          if (nearest2 <= best2) {
+            STATS_ADD_PTR(stats, earlyBreaks, 1);
+            break;
+          }
+        }
+      }
+    }
+    bounds[v] = sqrt(nearest2);
+    if (bounds[v] > best) {
+      best = bounds[v];
+      if (best > stop) return best;
+    }
+  }
+
+  // Step 2: Edge interiors
+  for (int e = 0; e + 1 < n; ++e) {
+    const Point_2& A = from.getPoint(e);
+    const Point_2& B = from.getPoint(e + 1);
+    double dx = B.x() - A.x(), dy = B.y() - A.y();
+    double length = sqrt(dx * dx + dy * dy);
+
+    // The distance is 1-Lipschitz along the edge
+    double bound = (bounds[e] + bounds[e + 1] + length) / 2;
+    if (bound <= best) {
+      STATS_ADD_PTR(stats, prunedEdges, 1);
+      continue;
+    }
+
+    // The distance to one segment is convex along the edge, so its larger
+    // end value bounds the maximum as well
+    double radius = searchRadius(bound);
+    grid.queryBox(min(A.x(), B.x()) - radius, min(A.y(), B.y()) - radius,
+                  max(A.x(), B.x()) + radius, max(A.y(), B.y()) + radius,
+                  segments);
+    STATS_ADD_PTR(stats, candidateSegments, segments.size());
+    for (int s : segments) {
+      const Point_2& a = to.getPoint(s);
+      const Point_2& b = to.getPoint(s + 1);
+      bound = min(bound, sqrt(max(segmentDistance2(A.x(), A.y(), a, b),
+                                  segmentDistance2(B.x(), B.y(), a, b))));
+    }
+    if (bound <= best) {
+      STATS_ADD_PTR(stats, prunedEdges, 1);
+      continue;
+    }
+    STATS_ADD_PTR(stats, examinedEdges, 1);
+
+    // Only segments within the bound can be nearest to a point of the edge
+    radius = searchRadius(bound);
+    auto isFar = [&](int s) {
+      return segmentSegmentDistance(A, B, to.getPoint(s), to.getPoint(s + 1)) >
+             radius;
+    };
+    segments.erase(remove_if(segments.begin(), segments.end(), isFar),
+                   segments.end());
+
+    // Features of the remaining segments: their vertices (shared ones once)
+    // and their supporting lines
+    features.clear();
+    int lastVertex = -1;
+    for (int s : segments) {
+      if (s != lastVertex) {
+        addVertexFeature(A, dx, dy, to.getPoint(s), features);
+      }
+      addVertexFeature(A, dx, dy, to.getPoint(s + 1), features);
+      addLineFeature(A, dx, dy, to.getPoint(s), to.getPoint(s + 1), features);
+      lastVertex = s + 1;
+    }
+
+    // The maximum inside the edge lies where two features are equally far;
+    // evaluate the distance at every such crossing
+    int numFeatures = features.size() / 3;
+    for (int f = 0; f < numFeatures; ++f) {
+      for (int g = f + 1; g < numFeatures; ++g) {
+        double roots[2];
+        int numRoots = solveQuadratic(features[3 * f] - features[3 * g],
+                                      features[3 * f + 1] - features[3 * g + 1],
+                                      features[3 * f + 2] - features[3 * g + 2],
+                                      roots);
+        for (int r = 0; r < numRoots; ++r) {
+          double t = roots[r];
+          if (!(t > 0 && t < 1)) continue;
+          STATS_ADD_PTR(stats, crossings, 1);
+
+          double x = A.x() + t * dx, y = A.y() + t * dy;
+          double best2 = best * best;
+          double nearest2 = numeric_limits<double>::infinity();
+          for (int s : segments) {
+            nearest2 = min(nearest2, segmentDistance2(x, y, to.getPoint(s),
+                                                      to.getPoint(s + 1)));
+            if (nearest2 <= best2) break;
+          }
+          if (nearest2 > best2) {
+            best = sqrt(nearest2);
+            if (best > stop) return best;
+          }
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+}  // namespace
+
+// Constructor to compute the distance of two curves
+HausdorffDistance::HausdorffDistance(const PolygonalCurve& P,
+                                     const PolygonalCurve& Q,
+                                     Workspace* workspace)
+    : distance(0.0) {
+  STATS_TIMER(stats, seconds);
+  Workspace local;
+  Workspace& buffers = workspace ? *workspace : local;
+  double infinity = numeric_limits<double>::infinity();
+
+  // The second direction only needs to resolve values above the first
+  buffers.gridQ.build(Q);
+  distance = directedSweep(P, Q, buffers.gridQ, 0.0, infinity, buffers,
+                           &stats);
+  buffers.gridP.build(P);
+  distance = directedSweep(Q, P, buffers.gridP, distance, infinity, buffers,
+                           &stats);
+}
+
+// Getter for the distance
+double HausdorffDistance::getHausdorffDistance() const { return distance; }
+
+// Getter for the counters
+const HausdorffStats& HausdorffDistance::getStats() const { return stats; }
+
+// Directed Hausdorff distance from from to to
+double HausdorffDistance::directedDistance(const PolygonalCurve& from,
+                                           const PolygonalCurve& to,
+                                           Workspace* workspace,
+                                           HausdorffStats* stats) {
+  STATS_TIMER_PTR(stats, seconds);
+  Workspace local;
+  Workspace& buffers = workspace ? *workspace : local;
+  buffers.gridQ.build(to);
+  return directedSweep(from, to, buffers.gridQ, 0.0,
+                       numeric_limits<double>::infinity(), buffers, stats);
+}
+
+// Checks if the Hausdorff distance is at most epsilon
+bool HausdorffDistance::isWithin(const PolygonalCurve& P,
+                                 const PolygonalCurve& Q, double epsilon,
+                                 Workspace* workspace, HausdorffStats* stats) {
+  STATS_TIMER_PTR(stats, seconds);
+  Workspace local;
+  Workspace& buffers = workspace ? *workspace : local;
+
+  // Points within epsilon are never resolved exactly
+  buffers.gridQ.build(Q);
+  if (directedSweep(P, Q, buffers.gridQ, epsilon, epsilon, buffers, stats) >
+      epsilon) {
+    return false;
+  }
+  buffers.gridP.build(P);
+  return directedSweep(Q, P, buffers.gridP, epsilon, epsilon, buffers,
+                       stats) <= epsilon;
+}
@@ -0,0 +1,186 @@
+#include "incremental_decision.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const PointPair kEmptyInterval(Point_2(-1, -1), Point_2(-1, -1));
+
+// Returns true if the interval is empty
+bool isEmpty(const PointPair& interval) {
+  return interval.first == kEmptyInterval.first;
+}
+
+// Returns true if the point is within epsilon of the target
+bool isWithin(const Point_2& point, const Point_2& target, double epsilon) {
+  double dx = point.x() - target.x();
+  double dy = point.y() - target.y();
+  return dx * dx + dy * dy <= epsilon * epsilon;
+}
+
+}  // namespace
+
+// Constructor to start with an empty P
+IncrementalDecision::IncrementalDecision(const PolygonalCurve& Q,
+                                         double epsilon)
+    : Q(Q),
+      epsilon(epsilon),
+      leftReachable(false),
+      monotoneCurveExists(false),
+      prefixMatches(false) {
+  if (Q.numPoints() == 0) {
+    throw invalid_argument("Curve Q must have at least one point.");
+  }
+}
+
+// Constructor to start with the points of P
+IncrementalDecision::IncrementalDecision(const PolygonalCurve& P,
+                                         const PolygonalCurve& Q,
+                                         double epsilon)
+    : IncrementalDecision(Q, epsilon) {
+  for (size_t i = 0; i < P.numPoints(); ++i) {
+    addPoint(P.getPoint(i));
+  }
+}
+
+// Appends a point to P and updates the answer
+bool IncrementalDecision::addPoint(const Point_2& point) {
+  STATS_ADD(stats, decisionCalls, 1);
+  P.addPoint(point);
+
+  // A single point of Q is matched to every point of P
+  if (Q.numPoints() < 2) {
+    bool within = isWithin(point, Q.getPoint(0), epsilon);
+    monotoneCurveExists = (P.numPoints() == 1 || monotoneCurveExists) && within;
+    prefixMatches = monotoneCurveExists;
+    return monotoneCurveExists;
+  }
+
+  if (P.numPoints() == 1) {
+    startCurve(point);
+  } else if (prefixMatches) {
+    extendCurve(point);
+  }
+  // Otherwise nothing is reachable and nothing can become reachable
+
+  return monotoneCurveExists;
+}
+
+// Restarts with an empty P and a new epsilon
+void IncrementalDecision::reset(double newEpsilon) {
+  P.assign(CurveView());  // Keeps the capacity of the columns
+  epsilon = newEpsilon;
+  leftReachable = false;
+  monotoneCurveExists = false;
+  prefixMatches = false;
+}
+
+// Computes the reachable bottom boundary (y = 0) for the first point of P
+void IncrementalDecision::startCurve(const Point_2& point) {
+  int q = Q.numPoints();
+  frontier.assign(q - 1, kEmptyInterval);
+  nextFrontier.assign(q - 1, kEmptyInterval);
+  freeL.assign(q, kEmptyInterval);
+
+  // Step 1: The bottom boundary is reachable while the free intervals are
+  // connected from (0, 0) to the right
+  leftReachable = isWithin(point, Q.getPoint(0), epsilon);
+  double portions[2];
+  for (int j = 0; leftReachable && j < q - 1; ++j) {
+    int result = FreeSpace::checkPointsOnEdge(Q.getPoint(j), Q.getPoint(j + 1),
+                                              point, epsilon, portions);
+    if (result == 0 || portions[0] != 0.0) break;
+    frontier[j] = {Point_2(j + portions[0], 0),
+                   Point_2(j + (result == 2 ? portions[1] : portions[0]), 0)};
+    if (frontier[j].second.x() != j + 1) break;
+  }
+
+  // Step 2: A single point of P is matched to every point of Q
+  monotoneCurveExists = true;
+  for (int j = 0; j < q; ++j) {
+    monotoneCurveExists =
+        monotoneCurveExists && isWithin(Q.getPoint(j), point, epsilon);
+  }
+  prefixMatches = leftReachable;
+}
+
+// Adds the row of cells of the new edge of P
+void IncrementalDecision::extendCurve(const Point_2& point) {
+  int q = Q.numPoints();
+  int i = P.numPoints() - 2;  // Index of the new edge of P
+  const Point_2& start = P.getPoint(i);
+  STATS_ADD(stats, freeSpaceCells, 2 * q - 1);
+  STATS_ADD(stats, reachabilityCells, q - 1);
+
+  // Step 1: Compute the free L of the new row
+  double portions[2];
+  for (int j = 0; j < q; ++j) {
+    int result = FreeSpace::checkPointsOnEdge(start, point, Q.getPoint(j),
+                                              epsilon, portions);
+    if (result == 0) {
+      freeL[j] = kEmptyInterval;
+    } else {
+      freeL[j] = {Point_2(j, i + portions[0]),
+                  Point_2(j, i + (result == 2 ? portions[1] : portions[0]))};
+    }
+  }
+
+  // Step 2: The left boundary is reachable if it continues the reachable
+  // part of the previous row
+  PointPair left = kEmptyInterval;
+  if (leftReachable && !isEmpty(freeL[0]) && freeL[0].first.y() == i) {
+    left = freeL[0];
+  }
+  leftReachable = !isEmpty(left) && left.second.y() == i + 1;
+
+  // Step 3: Propagate through the cells of the row from left to right
+  bool topReachable = false;
+  PointPair right = kEmptyInterval;
+  for (int j = 0; j < q - 1; ++j) {
+    PointPair freeTop = kEmptyInterval;
+    int result = FreeSpace::checkPointsOnEdge(Q.getPoint(j), Q.getPoint(j + 1),
+                                              point, epsilon, portions);
+    if (result != 0) {
+      freeTop = {Point_2(j + portions[0], i + 1),
+                 Point_2(j + (result == 2 ? portions[1] : portions[0]), i + 1)};
+    }
+
+    DecisionProblem::propagateCell(i, j, left, frontier[j], freeL[j + 1],
+                                   freeTop, right, nextFrontier[j]);
+    topReachable = topReachable || !isEmpty(nextFrontier[j]);
+    left = right;
+  }
+  frontier.swap(nextFrontier);
+
+  // Step 4: Check if (q-1, p-1) is reachable on the boundary of the last cell
+  Point_2 end(q - 1, i + 1);
+  monotoneCurveExists = right.second == end || frontier.back().second == end;
+  prefixMatches = leftReachable || topReachable;
+}
+
+// Getter for the result
+bool IncrementalDecision::doesMonotoneCurveExist() const {
+  return monotoneCurveExists;
+}
+
+// Getter for the prefix result
+bool IncrementalDecision::doesPrefixMatch() const { return prefixMatches; }
+
+// Getter for polygonal curve P
+const PolygonalCurve& IncrementalDecision::getCurveP() const { return P; }
+
+// Getter for polygonal curve Q
+const PolygonalCurve& IncrementalDecision::getCurveQ() const { return Q; }
+
+// Getter for epsilon
+double IncrementalDecision::getEpsilon() const { return epsilon; }
+
+// Getter for the reachable intervals at the last point of P
+const PointPairVector& IncrementalDecision::getFrontier() const {
+  return frontier;
+}
+
+// Getter for the counters
+const DecisionStats& IncrementalDecision::getStats() const { return stats; }
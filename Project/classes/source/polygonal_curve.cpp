@@ -2,60 +2,151 @@
 
 #include <cmath>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
 using namespace std;
 
+// Constructor: creates an empty polygonal curve
+PolygonalCurve::PolygonalCurve()
+    : m_xs(nullptr), m_ys(nullptr), m_size(0), m_borrowed(false) {}
+
 // Constructor: initializes the polygonal curve with the given points
 PolygonalCurve::PolygonalCurve(const vector<Point_2>& points)
-    : m_points(points) {}
+    : PolygonalCurve() {
+  m_x.reserve(points.size());
+  m_y.reserve(points.size());
+  for (const auto& point : points) {
+    m_x.push_back(point.x());
+    m_y.push_back(point.y());
+    m_summary.addPoint(point.x(), point.y());
+  }
+  syncColumns();
+}
 
-// Copy constructor: performs a deep copy
-PolygonalCurve::PolygonalCurve(const PolygonalCurve& P_)
-    : m_points(P_.m_points) {}
+// Constructor: copies the points of a curve view
+PolygonalCurve::PolygonalCurve(const CurveView& view) : PolygonalCurve() {
+  assign(view);
+}
 
-// Adds a point to the polygonal curve
-void PolygonalCurve::addPoint(const Point_2& point) {
-  m_points.push_back(point);
+// Copy constructor: performs a deep copy of owned columns and shares
+// borrowed ones
+PolygonalCurve::PolygonalCurve(const PolygonalCurve& P_)
+    : m_x(P_.m_x),
+      m_y(P_.m_y),
+      m_xs(P_.m_xs),
+      m_ys(P_.m_ys),
+      m_size(P_.m_size),
+      m_borrowed(P_.m_borrowed),
+      m_summary(P_.m_summary) {
+  if (!m_borrowed) syncColumns();
 }
 
-// Returns the number of points in the polygonal curve
-size_t PolygonalCurve::numPoints() const { return m_points.size(); }
+// Move constructor
+PolygonalCurve::PolygonalCurve(PolygonalCurve&& P_) noexcept
+    : m_x(move(P_.m_x)),
+      m_y(move(P_.m_y)),
+      m_xs(P_.m_xs),
+      m_ys(P_.m_ys),
+      m_size(P_.m_size),
+      m_borrowed(P_.m_borrowed),
+      m_summary(P_.m_summary) {
+  if (!m_borrowed) syncColumns();
+  P_.m_x.clear();
+  P_.m_y.clear();
+  P_.m_borrowed = false;
+  P_.m_summary = CurveSummary();
+  P_.syncColumns();
+}
 
-// Returns the point at a given index
-const Point_2& PolygonalCurve::getPoint(size_t index) const {
-  if (index >= m_points.size()) {
-    throw out_of_range("Index out of range.");
+// Copy assignment
+PolygonalCurve& PolygonalCurve::operator=(const PolygonalCurve& P_) {
+  if (this != &P_) {
+    PolygonalCurve copy(P_);
+    *this = move(copy);
   }
-  return m_points[index];
+  return *this;
 }
 
-// Computes the length of the polygonal curve (sum of Euclidean distances
-// between consecutive points)
-double PolygonalCurve::curveLength() const {
-  double length = 0.0;
-  for (size_t i = 1; i < m_points.size(); ++i) {
-    double dx = m_points[i].x() - m_points[i - 1].x();
-    double dy = m_points[i].y() - m_points[i - 1].y();
-    length += sqrt(dx * dx + dy * dy);  // Euclidean distance
+// Move assignment
+PolygonalCurve& PolygonalCurve::operator=(PolygonalCurve&& P_) noexcept {
+  if (this != &P_) {
+    m_x = move(P_.m_x);
+    m_y = move(P_.m_y);
+    m_xs = P_.m_xs;
+    m_ys = P_.m_ys;
+    m_size = P_.m_size;
+    m_borrowed = P_.m_borrowed;
+    m_summary = P_.m_summary;
+    if (!m_borrowed) syncColumns();
+    P_.m_x.clear();
+    P_.m_y.clear();
+    P_.m_borrowed = false;
+    P_.m_summary = CurveSummary();
+    P_.syncColumns();
   }
-  return length;
+  return *this;
+}
+
+// Returns a curve that borrows the columns of a view
+PolygonalCurve PolygonalCurve::borrow(const CurveView& view) {
+  return borrow(view, CurveSummary(view));
+}
+
+// Returns a curve that borrows the columns of a view with a known summary
+PolygonalCurve PolygonalCurve::borrow(const CurveView& view,
+                                      const CurveSummary& summary) {
+  PolygonalCurve curve;
+  curve.m_xs = view.x;
+  curve.m_ys = view.y;
+  curve.m_size = view.n;
+  curve.m_borrowed = true;
+  curve.m_summary = summary;
+  return curve;
+}
+
+// Replaces the points with those of a curve view. The owned columns keep
+// their capacity, so reusing a curve for many views stops allocating.
+void PolygonalCurve::assign(const CurveView& view) {
+  m_x.assign(view.x, view.x + view.n);
+  m_y.assign(view.y, view.y + view.n);
+  m_borrowed = false;
+  m_summary = CurveSummary(view);
+  syncColumns();
 }
 
+// Adds a point to the polygonal curve
+void PolygonalCurve::addPoint(const Point_2& point) {
+  ensureOwned();
+  m_x.push_back(point.x());
+  m_y.push_back(point.y());
+  m_summary.addPoint(point.x(), point.y());
+  syncColumns();
+}
+
+// Checks if the columns are borrowed
+bool PolygonalCurve::isBorrowed() const { return m_borrowed; }
+
+// Returns the length of the polygonal curve (sum of Euclidean distances
+// between consecutive points), kept up to date by the summary
+double PolygonalCurve::curveLength() const { return m_summary.length; }
+
 // Prints the points of the polygonal curve
 void PolygonalCurve::printCurve() const {
-  for (const auto& point : m_points) {
-    cout << "(" << point.x() << ", " << point.y() << ")" << endl;
+  for (size_t i = 0; i < m_size; ++i) {
+    cout << "(" << m_xs[i] << ", " << m_ys[i] << ")" << endl;
   }
 }
 
 // Shifts the origin of the grid by subtracting the coordinates of newOrigin
 // from each point of the polygonal curve
 void PolygonalCurve::shiftOrigin(const Point_2& newOrigin) {
-  for (auto& point : m_points) {
-    double newX = point.x() - newOrigin.x();
-    double newY = point.y() - newOrigin.y();
-    point = Point_2(newX, newY);  // Update the point
+  ensureOwned();
+  for (size_t i = 0; i < m_size; ++i) {
+    m_x[i] -= newOrigin.x();
+    m_y[i] -= newOrigin.y();
   }
+  resummarize();
 }
 
 // Scales the grid on which the points of the curve lie
@@ -64,18 +155,44 @@ void PolygonalCurve::scaleGrid(double scalingFactor) {
     throw invalid_argument("Scaling factor cannot be zero.");
   }
 
-  for (auto& point : m_points) {
-    double scaledX = point.x() / scalingFactor;
-    double scaledY = point.y() / scalingFactor;
-    point = Point_2(scaledX, scaledY);  // Update the point
+  ensureOwned();
+  for (size_t i = 0; i < m_size; ++i) {
+    m_x[i] /= scalingFactor;
+    m_y[i] /= scalingFactor;
   }
+  resummarize();
 }
 
 // Converts the coordinates of points to floor integer values
 void PolygonalCurve::floorCoordinates() {
-  for (auto& point : m_points) {
-    double flooredX = floor(point.x());
-    double flooredY = floor(point.y());
-    point = Point_2(flooredX, flooredY);  // Update the point
+  ensureOwned();
+  for (size_t i = 0; i < m_size; ++i) {
+    m_x[i] = floor(m_x[i]);
+    m_y[i] = floor(m_y[i]);
   }
+  resummarize();
+}
+
+// Points the columns in use at the owned columns
+void PolygonalCurve::syncColumns() {
+  m_xs = m_x.data();
+  m_ys = m_y.data();
+  m_size = m_x.size();
+}
+
+// Recomputes the summary from the columns
+void PolygonalCurve::resummarize() { m_summary = CurveSummary(view()); }
+
+// Copies borrowed columns into owned ones
+void PolygonalCurve::ensureOwned() {
+  if (!m_borrowed) return;
+  m_x.assign(m_xs, m_xs + m_size);
+  m_y.assign(m_ys, m_ys + m_size);
+  m_borrowed = false;
+  syncColumns();
+}
+
+// Throws the out-of-range error of getPoint()
+void PolygonalCurve::throwOutOfRange() {
+  throw out_of_range("Index out of range.");
 }
@@ -0,0 +1,154 @@
+#include "segment_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Constructor to create an empty grid
+SegmentGrid::SegmentGrid()
+    : originX(0.0), originY(0.0), cellSize(1.0), columns(0), rows(0) {}
+
+// Constructor to index the segments of a curve
+SegmentGrid::SegmentGrid(const PolygonalCurve& curve) : SegmentGrid() {
+  build(curve);
+}
+
+// Indexes the segments of a curve
+void SegmentGrid::build(const PolygonalCurve& curve) {
+  int n = max(static_cast<int>(curve.numPoints()) - 1, 0);
+  boxes.resize(4 * n);
+  columns = rows = 0;
+  cellStart.assign(1, 0);
+  cellSegments.clear();
+  if (n == 0) return;
+
+  // Step 1: Bounding boxes of the segments and of the curve
+  double minX = curve.getPoint(0).x(), maxX = minX;
+  double minY = curve.getPoint(0).y(), maxY = minY;
+  double totalExtent = 0.0;
+  for (int s = 0; s < n; ++s) {
+    const Point_2& a = curve.getPoint(s);
+    const Point_2& b = curve.getPoint(s + 1);
+    double* box = &boxes[4 * s];
+    box[0] = min(a.x(), b.x());
+    box[1] = min(a.y(), b.y());
+    box[2] = max(a.x(), b.x());
+    box[3] = max(a.y(), b.y());
+    minX = min(minX, box[0]);
+    minY = min(minY, box[1]);
+    maxX = max(maxX, box[2]);
+    maxY = max(maxY, box[3]);
+    totalExtent += max(box[2] - box[0], box[3] - box[1]);
+  }
+
+  // Step 2: Choose the cell size. Cells of the mean segment extent keep the
+  // number of cells per segment small; the total number of cells is capped
+  // at O(n) for curves with a few long segments.
+  double width = maxX - minX, height = maxY - minY;
+  cellSize = totalExtent / n;
+  if (!(cellSize > 0.0)) cellSize = max(width, height) / sqrt(n);
+  if (!(cellSize > 0.0)) cellSize = 1.0;
+  double maxCells = 4.0 * n + 64.0;
+  while ((floor(width / cellSize) + 1) * (floor(height / cellSize) + 1) >
+         maxCells) {
+    cellSize *= 2;
+  }
+  originX = minX;
+  originY = minY;
+  columns = static_cast<int>(floor(width / cellSize)) + 1;
+  rows = static_cast<int>(floor(height / cellSize)) + 1;
+
+  // Step 3: Count the segments per cell, then fill the cells (CSR)
+  int numCells = columns * rows;
+  cellStart.assign(numCells + 1, 0);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int s = 0; s < n; ++s) {
+      const double* box = &boxes[4 * s];
+      int x0, x1, y0, y1;
+      cellRange(box[0], box[2], originX, columns, x0, x1);
+      cellRange(box[1], box[3], originY, rows, y0, y1);
+      for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+          int cell = y * columns + x;
+          if (pass == 0) {
+            ++cellStart[cell + 1];
+          } else {
+            cellSegments[cellStart[cell]++] = s;
+          }
+        }
+      }
+    }
+    if (pass == 0) {
+      for (int c = 0; c < numCells; ++c) cellStart[c + 1] += cellStart[c];
+      cellSegments.resize(cellStart[numCells]);
+    }
+  }
+  // Filling advanced every start to the next one
+  for (int c = numCells; c > 0; --c) cellStart[c] = cellStart[c - 1];
+  cellStart[0] = 0;
+}
+
+// Getter for the number of segments
+size_t SegmentGrid::numSegments() const { return boxes.size() / 4; }
+
+// Segments whose bounding box is within radius of the point
+void SegmentGrid::query(const Point_2& point, double radius,
+                        vector<int>& segments) const {
+  queryBox(point.x() - radius, point.y() - radius, point.x() + radius,
+           point.y() + radius, segments);
+}
+
+// Segments whose bounding box meets the box
+void SegmentGrid::queryBox(double minX, double minY, double maxX, double maxY,
+                           vector<int>& segments) const {
+  segments.clear();
+  if (columns == 0) return;
+
+  int x0, x1, y0, y1;
+  cellRange(minX, maxX, originX, columns, x0, x1);
+  cellRange(minY, maxY, originY, rows, y0, y1);
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      int cell = y * columns + x;
+      for (int e = cellStart[cell]; e < cellStart[cell + 1]; ++e) {
+        int s = cellSegments[e];
+        const double* box = &boxes[4 * s];
+        if (box[0] <= maxX && box[2] >= minX && box[1] <= maxY &&
+            box[3] >= minY) {
+          segments.push_back(s);
+        }
+      }
+    }
+  }
+
+  // A segment is found once per cell it covers
+  if (x0 != x1 || y0 != y1) {
+    sort(segments.begin(), segments.end());
+    segments.erase(unique(segments.begin(), segments.end()), segments.end());
+  }
+}
+
+// Bytes currently reserved by the buffers
+size_t SegmentGrid::capacityBytes() const {
+  return boxes.capacity() * sizeof(double) +
+         (cellStart.capacity() + cellSegments.capacity()) * sizeof(int);
+}
+
+// Releases the memory of the buffers
+void SegmentGrid::release() { *this = SegmentGrid(); }
+
+// Clamped cell range [first, last] of the interval [low, high] on one axis
+// (empty if first > last)
+void SegmentGrid::cellRange(double low, double high, double origin, int cells,
+                            int& first, int& last) const {
+  double a = floor((low - origin) / cellSize);
+  double b = floor((high - origin) / cellSize);
+  if (!(b >= 0 && a <= cells - 1.0)) {
+    first = 1;
+    last = 0;
+    return;
+  }
+  first = static_cast<int>(max(a, 0.0));
+  last = static_cast<int>(min(b, cells - 1.0));
+}
@@ -0,0 +1,340 @@
+#include "similarity_join.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "batch_driver.h"
+#include "curve_file.h"
+#include "decision_problem.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+// Cells beyond this index are merged, so far-out coordinates cannot
+// overflow the cell index
+const double kMaxCell = 1e15;
+
+// Start and end point of a curve
+struct Endpoints {
+  double startX, startY, endX, endY;
+};
+
+// Cell of a curve in the grid over (start, end)
+struct CellKey {
+  int64_t startX, startY, endX, endY;
+
+  bool operator==(const CellKey& other) const {
+    return startX == other.startX && startY == other.startY &&
+           endX == other.endX && endY == other.endY;
+  }
+  bool operator<(const CellKey& other) const {
+    if (startX != other.startX) return startX < other.startX;
+    if (startY != other.startY) return startY < other.startY;
+    if (endX != other.endX) return endX < other.endX;
+    return endY < other.endY;
+  }
+};
+
+struct CellKeyHash {
+  size_t operator()(const CellKey& key) const {
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    for (int64_t part : {key.startX, key.startY, key.endX, key.endY}) {
+      h ^= static_cast<uint64_t>(part) + 0x9e3779b97f4a7c15ULL + (h << 6) +
+           (h >> 2);
+    }
+    return static_cast<size_t>(h);
+  }
+};
+
+// Cell index of a coordinate
+int64_t cellOf(double value, double cellSize) {
+  double cell = max(-kMaxCell, min(kMaxCell, floor(value / cellSize)));
+  return static_cast<int64_t>(cell);
+}
+
+// Curves of a file by cell, with their end points next to them
+struct GridIndex {
+  double cellSize = 1.0;
+  vector<uint64_t> ids;       // Curves sorted by cell
+  vector<Endpoints> points;   // End points of ids
+  unordered_map<CellKey, pair<size_t, size_t>, CellKeyHash> cells;  // Ranges
+};
+
+Endpoints endpointsOf(const CurveSummary& summary) {
+  return {summary.startX, summary.startY, summary.endX, summary.endY};
+}
+
+CellKey keyOf(const Endpoints& e, double cellSize) {
+  return {cellOf(e.startX, cellSize), cellOf(e.startY, cellSize),
+          cellOf(e.endX, cellSize), cellOf(e.endY, cellSize)};
+}
+
+// Curves of a file with at least one point, sorted by cell and id
+void sortByCell(const MappedCurveFile& store, double cellSize,
+                vector<uint64_t>& ids, vector<Endpoints>& points,
+                vector<CellKey>& keys) {
+  vector<pair<CellKey, uint64_t>> order;
+  order.reserve(store.numCurves());
+  for (size_t id = 0; id < store.numCurves(); ++id) {
+    if (store.curveSize(id) == 0) continue;
+    order.push_back({keyOf(endpointsOf(store.getSummary(id)), cellSize), id});
+  }
+  typedef pair<CellKey, uint64_t> Entry;
+  sort(order.begin(), order.end(), [](const Entry& a, const Entry& b) {
+    return a.first < b.first || (a.first == b.first && a.second < b.second);
+  });
+  ids.resize(order.size());
+  points.resize(order.size());
+  keys.resize(order.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    keys[k] = order[k].first;
+    ids[k] = order[k].second;
+    points[k] = endpointsOf(store.getSummary(ids[k]));
+  }
+}
+
+GridIndex buildIndex(const MappedCurveFile& store, double cellSize) {
+  GridIndex index;
+  index.cellSize = cellSize;
+  vector<CellKey> keys;
+  sortByCell(store, cellSize, index.ids, index.points, keys);
+  for (size_t begin = 0, end; begin < keys.size(); begin = end) {
+    end = begin + 1;
+    while (end < keys.size() && keys[end] == keys[begin]) ++end;
+    index.cells[keys[begin]] = {begin, end};
+  }
+  return index;
+}
+
+}  // namespace
+
+// Finds all pairs within epsilon
+JoinStats similarityJoin(const MappedCurveFile& A, const MappedCurveFile& B,
+                         const JoinOptions& options,
+                         const JoinCallback& callback) {
+  double epsilon = options.epsilon;
+  if (!(epsilon >= 0.0)) {
+    throw invalid_argument("The join epsilon must not be negative.");
+  }
+  bool selfJoin = &A == &B;
+
+  // Step 1: Index B by cell. Any cell size is correct because the probes
+  // cover [c - epsilon, c + epsilon] per coordinate; epsilon makes it at
+  // most 3 cells per coordinate.
+  double cellSize = epsilon > 0.0 ? epsilon : 1.0;
+  GridIndex index = buildIndex(B, cellSize);
+
+  // Step 2: Partitions of A in cell order, so the probes of a partition
+  // touch nearby cells
+  vector<uint64_t> probes;
+  vector<Endpoints> probePoints;
+  vector<CellKey> probeKeys;
+  sortByCell(A, cellSize, probes, probePoints, probeKeys);
+  probeKeys.clear();
+  probeKeys.shrink_to_fit();
+
+  ThreadPool pool(options.numThreads);
+  size_t partitionSize = options.partitionSize;
+  if (partitionSize == 0) {
+    partitionSize = probes.size() / (pool.numThreads() * 16);
+    partitionSize = max<size_t>(64, min<size_t>(4096, partitionSize));
+  }
+  size_t numPartitions = (probes.size() + partitionSize - 1) / partitionSize;
+
+  // Step 3: Workers probe the partitions
+  JoinStats stats;
+  stats.partitions = numPartitions;
+  atomic<size_t> nextPartition(0);
+  atomic<bool> failed(false);
+  mutex outputMutex;
+  string error;
+  double epsilon2 = epsilon * epsilon;
+
+  for (size_t t = 0; t < pool.numThreads(); ++t) {
+    pool.submit([&]() {
+      Workspace workspace;  // Reused for every decision of this worker
+      JoinStats local;
+      vector<JoinMatch> matches;
+      try {
+        for (size_t part = nextPartition++; part < numPartitions && !failed;
+             part = nextPartition++) {
+          matches.clear();
+          size_t first = part * partitionSize;
+          size_t last = min(probes.size(), first + partitionSize);
+          for (size_t k = first; k < last; ++k) {
+            uint64_t idA = probes[k];
+            const Endpoints& e = probePoints[k];
+            CurveSummary summaryA = A.getSummary(idA);
+            unique_ptr<PolygonalCurve> P;  // Borrowed on the first decision
+
+            // Task 1: Filter the candidates of a cell
+            auto probeCell = [&](const CellKey& cell) {
+              auto found = index.cells.find(cell);
+              if (found == index.cells.end()) return;
+              for (size_t c = found->second.first; c < found->second.second;
+                   ++c) {
+                uint64_t idB = index.ids[c];
+                if (selfJoin && idB <= idA) continue;
+                ++local.gridCandidates;
+                const Endpoints& f = index.points[c];
+                double sx = e.startX - f.startX, sy = e.startY - f.startY;
+                double ex = e.endX - f.endX, ey = e.endY - f.endY;
+                if (sx * sx + sy * sy > epsilon2 ||
+                    ex * ex + ey * ey > epsilon2) {
+                  ++local.endpointRejected;
+                  continue;
+                }
+                CurveSummary summaryB = B.getSummary(idB);
+                if (frechetLowerBound(summaryA, summaryB) > epsilon) {
+                  ++local.boxRejected;
+                  continue;
+                }
+                if (frechetUpperBound(summaryA, summaryB) <= epsilon) {
+                  ++local.boxAccepted;
+                  matches.push_back({idA, idB});
+                  continue;
+                }
+
+                // Only the survivors go to the decision
+                ++local.decisions;
+                if (!P) P.reset(new PolygonalCurve(A.borrowCurve(idA)));
+                PolygonalCurve Q = B.borrowCurve(idB);
+                DecisionProblem decision(*P, Q, epsilon, &workspace,
+                                         options.freeSpaceMode);
+                if (decision.doesMonotoneCurveExist()) {
+                  matches.push_back({idA, idB});
+                }
+              }
+            };
+
+            // Task 2: The neighbouring cells of (start, end)
+            CellKey low = keyOf({e.startX - epsilon, e.startY - epsilon,
+                                 e.endX - epsilon, e.endY - epsilon},
+                                cellSize);
+            CellKey high = keyOf({e.startX + epsilon, e.startY + epsilon,
+                                  e.endX + epsilon, e.endY + epsilon},
+                                 cellSize);
+            CellKey cell;
+            for (cell.startX = low.startX; cell.startX <= high.startX;
+                 ++cell.startX) {
+              for (cell.startY = low.startY; cell.startY <= high.startY;
+                   ++cell.startY) {
+                for (cell.endX = low.endX; cell.endX <= high.endX;
+                     ++cell.endX) {
+                  for (cell.endY = low.endY; cell.endY <= high.endY;
+                       ++cell.endY) {
+                    probeCell(cell);
+                  }
+                }
+              }
+            }
+          }
+
+          // Task 3: Stream out the partition
+          local.matches += matches.size();
+          lock_guard<mutex> lock(outputMutex);
+          if (!matches.empty()) callback(matches.data(), matches.size());
+        }
+      } catch (const exception& e) {
+        lock_guard<mutex> lock(outputMutex);
+        if (error.empty()) error = e.what();
+        failed = true;
+      }
+
+      lock_guard<mutex> lock(outputMutex);
+      stats.gridCandidates += local.gridCandidates;
+      stats.endpointRejected += local.endpointRejected;
+      stats.boxRejected += local.boxRejected;
+      stats.boxAccepted += local.boxAccepted;
+      stats.decisions += local.decisions;
+      stats.matches += local.matches;
+    });
+  }
+  pool.wait();
+
+  if (!error.empty()) {
+    throw runtime_error(error);
+  }
+  return stats;
+}
+
+// Joins the curve files and writes the pair list
+JoinStats runJoin(const JoinOptions& options) {
+  MappedCurveFile A(options.pathA);
+  unique_ptr<MappedCurveFile> B;
+  if (!options.pathB.empty()) B.reset(new MappedCurveFile(options.pathB));
+
+  bool binary = options.outputPath.size() >= 4 &&
+                options.outputPath.compare(options.outputPath.size() - 4, 4,
+                                           ".bin") == 0;
+  ofstream out(options.outputPath, binary ? ios::binary : ios::out);
+  if (!out) {
+    throw runtime_error("Cannot open output " + options.outputPath + ".");
+  }
+  vector<char> buffer(1 << 20);
+  out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+
+  JoinStats stats = similarityJoin(
+      A, B ? *B : A, options,
+      [&](const JoinMatch* matches, size_t count) {
+        for (size_t m = 0; m < count; ++m) {
+          if (binary) {
+            uint64_t ids[2] = {matches[m].idA, matches[m].idB};
+            out.write(reinterpret_cast<const char*>(ids), sizeof(ids));
+          } else {
+            out << matches[m].idA << ' ' << matches[m].idB << '\n';
+          }
+        }
+        if (!out) throw runtime_error("Failed to write the output.");
+      });
+  out.flush();
+  if (!out) throw runtime_error("Failed to write the output.");
+  return stats;
+}
+
+// Parses "join" command line arguments into options
+JoinOptions parseJoinArguments(int argc, char** argv) {
+  JoinOptions options;
+  bool hasEpsilon = false;
+  for (int i = 0; i < argc; ++i) {
+    string flag = argv[i];
+    if (i + 1 >= argc) {
+      throw invalid_argument("Missing value for " + flag + ".");
+    }
+    string value = argv[++i];
+    if (flag == "--a") {
+      options.pathA = value;
+    } else if (flag == "--b") {
+      options.pathB = value;
+    } else if (flag == "--out") {
+      options.outputPath = value;
+    } else if (flag == "--epsilon") {
+      options.epsilon = stod(value);
+      hasEpsilon = true;
+    } else if (flag == "--free-space") {
+      options.freeSpaceMode = parseFreeSpaceMode(value);
+    } else if (flag == "--threads") {
+      options.numThreads = stoul(value);
+    } else if (flag == "--partition") {
+      options.partitionSize = stoul(value);
+    } else {
+      throw invalid_argument("Unknown option " + flag + ".");
+    }
+  }
+
+  if (options.pathA.empty() || options.outputPath.empty() || !hasEpsilon) {
+    throw invalid_argument("--a, --out and --epsilon are required.");
+  }
+  return options;
+}
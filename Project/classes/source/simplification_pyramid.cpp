@@ -0,0 +1,176 @@
+#include "simplification_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std;
+
+namespace {
+
+// Parameter of the projection of point i onto the segment from a to b,
+// clamped to [0, 1]
+double projectionParameter(const CurveView& curve, size_t i, size_t a,
+                           size_t b) {
+  double dx = curve.x[b] - curve.x[a];
+  double dy = curve.y[b] - curve.y[a];
+  double lengthSquared = dx * dx + dy * dy;
+  if (lengthSquared == 0.0) return 0.0;
+  double t = ((curve.x[i] - curve.x[a]) * dx + (curve.y[i] - curve.y[a]) * dy) /
+             lengthSquared;
+  return min(max(t, 0.0), 1.0);
+}
+
+// Distance from point i to the point at parameter t of the segment from a
+// to b
+double distanceAt(const CurveView& curve, size_t i, size_t a, size_t b,
+                  double t) {
+  double x = curve.x[a] + t * (curve.x[b] - curve.x[a]);
+  double y = curve.y[a] + t * (curve.y[b] - curve.y[a]);
+  double dx = curve.x[i] - x, dy = curve.y[i] - y;
+  return sqrt(dx * dx + dy * dy);
+}
+
+// Upper bound of the Frechet distance between the vertices a, ..., b and the
+// segment from a to b. The vertices are matched to their projections made
+// monotone by a running maximum; between two vertices both points move
+// linearly, so the distance is convex there and peaks at a vertex.
+double shortcutError(const CurveView& curve, size_t a, size_t b) {
+  double error = 0.0;
+  double t = 0.0;
+  for (size_t i = a + 1; i < b; ++i) {
+    t = max(t, projectionParameter(curve, i, a, b));
+    error = max(error, distanceAt(curve, i, a, b, t));
+  }
+  return error;
+}
+
+// Vertices scanned by refinementOrder() per n log2 n. Balanced splits scan
+// about n log2 n; only degenerate curves (spirals, one-sided zigzags) that
+// peel off one vertex per split reach the budget.
+const size_t kRefinementBudget = 8;
+
+// Douglas-Peucker order of the vertices: the two end points, then repeatedly
+// the vertex farthest from the segment of the simplification it lies under.
+// Stops after maxVertices vertices, or when the scans would exceed the
+// budget, so the cost is O(n log n) instead of O(n^2).
+void refinementOrder(const CurveView& curve, size_t maxVertices,
+                     vector<uint32_t>& order) {
+  size_t n = curve.n;
+  order.clear();
+  order.push_back(0);
+  if (n == 1) return;
+  order.push_back(static_cast<uint32_t>(n - 1));
+
+  size_t budget = kRefinementBudget * n * static_cast<size_t>(log2(n) + 1);
+  size_t scanned = n;  // The first split scans the whole curve
+
+  // Segments (a, b) by the distance of their farthest inner vertex k
+  typedef tuple<double, size_t, size_t, size_t> Split;
+  priority_queue<Split> splits;
+  auto pushSplit = [&](size_t a, size_t b) {
+    if (b <= a + 1) return;
+    double farthest = -1.0;
+    size_t k = a + 1;
+    for (size_t i = a + 1; i < b; ++i) {
+      double t = projectionParameter(curve, i, a, b);
+      double d = distanceAt(curve, i, a, b, t);
+      if (d > farthest) {
+        farthest = d;
+        k = i;
+      }
+    }
+    splits.emplace(farthest, a, b, k);
+  };
+
+  pushSplit(0, n - 1);
+  while (!splits.empty() && order.size() < maxVertices) {
+    size_t a, b, k;
+    tie(ignore, a, b, k) = splits.top();
+    splits.pop();
+    order.push_back(static_cast<uint32_t>(k));
+    scanned += b - a;
+    if (scanned > budget) break;
+    pushSplit(a, k);
+    pushSplit(k, b);
+  }
+}
+
+}  // namespace
+
+// Constructor: creates an empty pyramid
+SimplificationPyramid::SimplificationPyramid() : levelOffsets(1, 0) {}
+
+// Constructor: builds the pyramid of a curve
+SimplificationPyramid::SimplificationPyramid(const CurveView& curve)
+    : levelOffsets(1, 0) {
+  // Step 1: Order in which the vertices refine the simplification, up to the
+  // largest level
+  size_t maxVertices = 2;
+  while (maxVertices * 2 < curve.n) maxVertices *= 2;
+  vector<uint32_t> order;
+  if (curve.n > 0) refinementOrder(curve, maxVertices, order);
+
+  // Step 2: Level l is the first 2^(l + 1) vertices of the order, sorted
+  for (size_t size = 2; size < curve.n && size <= order.size(); size *= 2) {
+    size_t start = indices.size();
+    indices.insert(indices.end(), order.begin(), order.begin() + size);
+    sort(indices.begin() + start, indices.end());
+    levelOffsets.push_back(indices.size());
+
+    // Step 3: The error of a level is the largest error of its shortcuts
+    double error = 0.0;
+    for (size_t i = start; i + 1 < indices.size(); ++i) {
+      error = max(error, shortcutError(curve, indices[i], indices[i + 1]));
+    }
+    errors.push_back(error);
+  }
+}
+
+// Getter for the number of levels
+size_t SimplificationPyramid::numLevels() const { return errors.size(); }
+
+// Getter for the number of vertices of a level
+size_t SimplificationPyramid::levelSize(size_t level) const {
+  if (level >= numLevels()) {
+    throw out_of_range("Level out of range.");
+  }
+  return levelOffsets[level + 1] - levelOffsets[level];
+}
+
+// Getter for the sorted vertex indices of a level
+const uint32_t* SimplificationPyramid::levelIndices(size_t level) const {
+  if (level >= numLevels()) {
+    throw out_of_range("Level out of range.");
+  }
+  return indices.data() + levelOffsets[level];
+}
+
+// Getter for the error bound of a level
+double SimplificationPyramid::levelError(size_t level) const {
+  if (level >= numLevels()) {
+    throw out_of_range("Level out of range.");
+  }
+  return errors[level];
+}
+
+// Finds the coarsest level whose error is at most maxError
+size_t SimplificationPyramid::findLevel(double maxError) const {
+  for (size_t level = 0; level < numLevels(); ++level) {
+    if (errors[level] <= maxError) return level;
+  }
+  return numLevels();
+}
+
+// Copies the vertices of a level of the curve into a PolygonalCurve
+PolygonalCurve SimplificationPyramid::levelCurve(size_t level,
+                                                 const CurveView& curve) const {
+  const uint32_t* levelVertices = levelIndices(level);
+  PolygonalCurve simplified;
+  for (size_t i = 0; i < levelSize(level); ++i) {
+    simplified.addPoint(curve.getPoint(levelVertices[i]));
+  }
+  return simplified;
+}
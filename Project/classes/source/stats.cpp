@@ -0,0 +1,101 @@
+#include "stats.h"
+
+#include <sstream>
+
+using namespace std;
+
+// Returns true if the library was compiled with ENABLE_STATS
+bool statsEnabled() {
+#ifdef ENABLE_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Constructor to start the timer
+ScopedTimer::ScopedTimer(double* target)
+    : target(target), start(chrono::steady_clock::now()) {}
+
+// Destructor to add the elapsed time to the target
+ScopedTimer::~ScopedTimer() {
+  if (target) {
+    *target +=
+        chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+}
+
+// JSON for CriticalValueStats
+string toJSON(const CriticalValueStats& stats) {
+  ostringstream out;
+  out << "{\"typeA\":" << stats.typeA << ",\"typeB\":" << stats.typeB
+      << ",\"typeC\":" << stats.typeC << ",\"unique\":" << stats.unique
+      << ",\"seconds\":" << stats.seconds << "}";
+  return out.str();
+}
+
+// JSON for DecisionStats
+string toJSON(const DecisionStats& stats) {
+  ostringstream out;
+  out << "{\"decisionCalls\":" << stats.decisionCalls
+      << ",\"freeSpaceCells\":" << stats.freeSpaceCells
+      << ",\"reachabilityCells\":" << stats.reachabilityCells
+      << ",\"freeSpaceSeconds\":" << stats.freeSpaceSeconds
+      << ",\"reachabilitySeconds\":" << stats.reachabilitySeconds << "}";
+  return out.str();
+}
+
+// JSON for FDistanceStats
+string toJSON(const FDistanceStats& stats) {
+  ostringstream out;
+  out << "{\"enabled\":" << (statsEnabled() ? "true" : "false")
+      << ",\"criticalValues\":" << toJSON(stats.criticalValues)
+      << ",\"decisions\":" << toJSON(stats.decisions)
+      << ",\"binarySearchSteps\":" << stats.binarySearchSteps
+      << ",\"weakSkippedValues\":" << stats.weakSkippedValues
+      << ",\"searchSeconds\":" << stats.searchSeconds << "}";
+  return out.str();
+}
+
+// JSON for GEDStats
+string toJSON(const GEDStats& stats) {
+  ostringstream out;
+  out << "{\"enabled\":" << (statsEnabled() ? "true" : "false")
+      << ",\"levels\":" << stats.levels
+      << ",\"skippedLevels\":" << stats.skippedLevels
+      << ",\"trials\":" << stats.trials << ",\"sedCalls\":" << stats.sedCalls
+      << ",\"sedDiagonals\":" << stats.sedDiagonals
+      << ",\"slideLength\":" << stats.slideLength
+      << ",\"bitParallelColumns\":" << stats.bitParallelColumns
+      << ",\"transformSeconds\":" << stats.transformSeconds
+      << ",\"sedSeconds\":" << stats.sedSeconds
+      << ",\"seconds\":" << stats.seconds << "}";
+  return out.str();
+}
+
+// JSON for HausdorffStats
+string toJSON(const HausdorffStats& stats) {
+  ostringstream out;
+  out << "{\"enabled\":" << (statsEnabled() ? "true" : "false")
+      << ",\"vertexQueries\":" << stats.vertexQueries
+      << ",\"candidateSegments\":" << stats.candidateSegments
+      << ",\"earlyBreaks\":" << stats.earlyBreaks
+      << ",\"prunedEdges\":" << stats.prunedEdges
+      << ",\"examinedEdges\":" << stats.examinedEdges
+      << ",\"crossings\":" << stats.crossings
+      << ",\"seconds\":" << stats.seconds << "}";
+  return out.str();
+}
+
+// JSON for DTWStats
+string toJSON(const DTWStats& stats) {
+  ostringstream out;
+  out << "{\"enabled\":" << (statsEnabled() ? "true" : "false")
+      << ",\"candidates\":" << stats.candidates
+      << ",\"prunedByKim\":" << stats.prunedByKim
+      << ",\"prunedByKeogh\":" << stats.prunedByKeogh
+      << ",\"dtwCalls\":" << stats.dtwCalls
+      << ",\"abandoned\":" << stats.abandoned << ",\"cells\":" << stats.cells
+      << ",\"seconds\":" << stats.seconds << "}";
+  return out.str();
+}
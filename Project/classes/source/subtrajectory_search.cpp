@@ -0,0 +1,293 @@
+#include "subtrajectory_search.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const PointPair kEmptyInterval(Point_2(-1, -1), Point_2(-1, -1));
+const double kNoLabel = numeric_limits<double>::infinity();
+const double kTouchTolerance = 1e-9;
+
+// Returns true if the interval is empty
+bool isEmpty(const PointPair& interval) {
+  return interval.first == kEmptyInterval.first;
+}
+
+// Returns true if the point is within epsilon of the target
+bool isWithin(const Point_2& point, const Point_2& target, double epsilon) {
+  double dx = point.x() - target.x();
+  double dy = point.y() - target.y();
+  return dx * dx + dy * dy <= epsilon * epsilon;
+}
+
+// Computes the free interval of the edge from start to end for the point, as
+// the portions [lo, hi] of the edge
+bool freePortions(const Point_2& start, const Point_2& end,
+                  const Point_2& point, double epsilon, double& lo,
+                  double& hi) {
+  double portions[2];
+  int result =
+      FreeSpace::checkPointsOnEdge(start, end, point, epsilon, portions);
+  if (result == 0) return false;
+  lo = portions[0];
+  hi = result == 2 ? portions[1] : portions[0];
+  return true;
+}
+
+}  // namespace
+
+// Constructor to initialize with the query curve and epsilon
+SubtrajectorySearch::SubtrajectorySearch(const PolygonalCurve& P,
+                                         double epsilon,
+                                         MatchCallback callback)
+    : P(P),
+      epsilon(epsilon),
+      callback(callback),
+      numQ(0),
+      lastQ(0, 0),
+      bottomConnected(false),
+      bottomRunStart(0.0),
+      runActive(false),
+      runStart(0.0),
+      runEnd(0.0) {
+  if (P.numPoints() == 0) {
+    throw invalid_argument("Curve P must have at least one point.");
+  }
+  size_t rows = P.numPoints() > 1 ? P.numPoints() - 1 : 0;
+  column.resize(rows);
+  nextColumn.resize(rows);
+}
+
+// Appends the next point of Q and sweeps the new column of cells
+void SubtrajectorySearch::addPoint(const Point_2& point) {
+  if (numQ == 0) {
+    startColumn(point);
+    return;
+  }
+
+  int p = P.numPoints();
+  int j = numQ - 1;  // Index of the new edge of Q
+  double threshold = j + 1;
+
+  // Step 1: Free bottom boundary (y = 0). A free point is a start, and its
+  // leftmost start is the beginning of its free run.
+  below.interval = kEmptyInterval;
+  below.steps.clear();
+  double lo, hi;
+  if (freePortions(lastQ, point, P.getPoint(0), epsilon, lo, hi)) {
+    if (!bottomConnected || lo != 0.0) bottomRunStart = j + lo;
+    below.interval = {Point_2(j + lo, 0), Point_2(j + hi, 0)};
+    below.steps.emplace_back(j + lo, bottomRunStart);
+    bottomConnected = hi == 1.0;
+  } else {
+    bottomConnected = false;
+  }
+  if (bottomConnected) threshold = min(threshold, bottomRunStart);
+
+  // Step 2: Propagate through the cells of the column from bottom to top
+  for (int i = 0; i < p - 1; ++i) {
+    PointPair freeRight = kEmptyInterval;
+    if (freePortions(P.getPoint(i), P.getPoint(i + 1), point, epsilon, lo,
+                     hi)) {
+      freeRight = {Point_2(j + 1, i + lo), Point_2(j + 1, i + hi)};
+    }
+    PointPair freeTop = kEmptyInterval;
+    if (freePortions(lastQ, point, P.getPoint(i + 1), epsilon, lo, hi)) {
+      freeTop = {Point_2(j + lo, i + 1), Point_2(j + hi, i + 1)};
+    }
+
+    const LabeledInterval& left = column[i];
+    DecisionProblem::propagateCell(i, j, left.interval, below.interval,
+                                   freeRight, freeTop, nextColumn[i].interval,
+                                   above.interval);
+
+    // The perpendicular boundary reaches every point with its leftmost
+    // start, the parallel one the points at or after its own
+    bool hasLeft = !isEmpty(left.interval);
+    bool hasBottom = !isEmpty(below.interval);
+    labelInterval(nextColumn[i].interval, true, hasLeft ? &left : nullptr,
+                  hasBottom ? below.steps.back().second : kNoLabel,
+                  nextColumn[i].steps);
+    labelInterval(above.interval, false, hasBottom ? &below : nullptr,
+                  hasLeft ? left.steps.back().second : kNoLabel, above.steps);
+
+    if (!isEmpty(nextColumn[i].interval)) {
+      threshold = min(threshold, nextColumn[i].steps.back().second);
+    }
+    swap(below, above);
+  }
+  column.swap(nextColumn);
+
+  // Step 3: The top boundary (y = p - 1) is the bottom boundary if P is a
+  // single point
+  extendTopRun(below);
+  if (runActive) threshold = min(threshold, runStart);
+
+  lastQ = point;
+  ++numQ;
+
+  // Step 4: Later matches start at or after threshold
+  flushPending(threshold);
+}
+
+// Reports the remaining matches
+void SubtrajectorySearch::finish() {
+  closeTopRun();
+  flushPending(kNoLabel);
+}
+
+// Computes the first column (x = 0), reachable only from (0, 0)
+void SubtrajectorySearch::startColumn(const Point_2& point) {
+  int p = P.numPoints();
+  lastQ = point;
+  ++numQ;
+
+  bottomConnected = isWithin(P.getPoint(0), point, epsilon);
+  bottomRunStart = 0.0;
+
+  // The left boundary is reachable while the free intervals are connected
+  // from (0, 0) upwards
+  bool connected = bottomConnected;
+  for (int i = 0; i < p - 1; ++i) {
+    LabeledInterval& left = column[i];
+    left.interval = kEmptyInterval;
+    left.steps.clear();
+    double lo, hi;
+    if (!connected || !freePortions(P.getPoint(i), P.getPoint(i + 1), point,
+                                    epsilon, lo, hi) ||
+        lo != 0.0) {
+      connected = false;
+      continue;
+    }
+    left.interval = {Point_2(0, i + lo), Point_2(0, i + hi)};
+    left.steps.emplace_back(i + lo, 0.0);
+    connected = hi == 1.0;
+  }
+
+  // (0, p - 1) is a match of the single point Q[0]
+  if (connected) {
+    runActive = true;
+    runStart = 0.0;
+    runEnd = 0.0;
+  }
+}
+
+// Extends the reachable run of the top boundary with the reachable part of
+// the top of the last cell, or closes it
+void SubtrajectorySearch::extendTopRun(const LabeledInterval& top) {
+  if (isEmpty(top.interval)) {
+    closeTopRun();
+    return;
+  }
+
+  double lo = top.interval.first.x();
+  double hi = top.interval.second.x();
+  double start = top.steps.back().second;
+  if (runActive && lo <= runEnd + kTouchTolerance) {
+    runStart = min(runStart, start);
+    runEnd = hi;
+    return;
+  }
+
+  closeTopRun();
+  runActive = true;
+  runStart = start;
+  runEnd = hi;
+}
+
+// Turns the reachable run of the top boundary into a match. Every point of
+// the run is reachable from its leftmost start, since the path can continue
+// along the top boundary to the end of the run.
+void SubtrajectorySearch::closeTopRun() {
+  if (!runActive) return;
+  runActive = false;
+
+  // Earlier matches starting at or after this one are contained in it
+  while (!pending.empty() && pending.back().start >= runStart) {
+    pending.pop_back();
+  }
+  pending.push_back({runStart, runEnd});
+}
+
+// Reports the pending matches that start before threshold, since no later
+// match can contain them
+void SubtrajectorySearch::flushPending(double threshold) {
+  while (!pending.empty() && pending.front().start < threshold) {
+    callback(pending.front());
+    pending.pop_front();
+  }
+}
+
+// Computes the labels of a reachable interval from the parallel boundary of
+// the cell (its points reach the points at or after them) and the leftmost
+// start of the perpendicular boundary (its points reach every point)
+void SubtrajectorySearch::labelInterval(const PointPair& interval,
+                                        bool vertical,
+                                        const LabeledInterval* parallel,
+                                        double crossLabel,
+                                        LabelSteps& steps) const {
+  steps.clear();
+  if (isEmpty(interval)) return;
+
+  double lo = vertical ? interval.first.y() : interval.first.x();
+  double hi = vertical ? interval.second.y() : interval.second.x();
+
+  // Step 1: Points before the parallel boundary are reached across the cell
+  double from = kNoLabel;
+  if (parallel) {
+    from = vertical ? parallel->interval.first.y()
+                    : parallel->interval.first.x();
+    from = max(from, lo);
+  }
+  if (crossLabel != kNoLabel && from > lo) steps.emplace_back(lo, crossLabel);
+  if (!parallel || from > hi + kTouchTolerance) return;
+  from = min(from, hi);
+
+  // Step 2: A point at position t gets the label of the parallel boundary at
+  // t, if it is smaller
+  const LabelSteps& source = parallel->steps;
+  double label = source.front().second;
+  for (const auto& step : source) {
+    if (step.first > from) break;
+    label = step.second;
+  }
+  label = min(label, crossLabel);
+  if (steps.empty() || label < steps.back().second) {
+    steps.emplace_back(from, label);
+  }
+  for (const auto& step : source) {
+    if (step.first <= from) continue;
+    if (step.first > hi) break;
+    label = min(step.second, crossLabel);
+    if (label < steps.back().second) steps.emplace_back(step.first, label);
+  }
+}
+
+// Getter for the query curve
+const PolygonalCurve& SubtrajectorySearch::getCurveP() const { return P; }
+
+// Getter for epsilon
+double SubtrajectorySearch::getEpsilon() const { return epsilon; }
+
+// Getter for the number of points of Q so far
+size_t SubtrajectorySearch::numPointsQ() const { return numQ; }
+
+// Finds all maximal portions of Q within Frechet distance epsilon of P
+vector<SubtrajectoryMatch> findSubtrajectories(const PolygonalCurve& P,
+                                               const PolygonalCurve& Q,
+                                               double epsilon) {
+  vector<SubtrajectoryMatch> matches;
+  SubtrajectorySearch search(P, epsilon,
+                             [&matches](const SubtrajectoryMatch& match) {
+                               matches.push_back(match);
+                             });
+  for (size_t i = 0; i < Q.numPoints(); ++i) {
+    search.addPoint(Q.getPoint(i));
+  }
+  search.finish();
+  return matches;
+}
@@ -0,0 +1,66 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Constructor to start the workers
+ThreadPool::ThreadPool(size_t numThreads) : running(0), stopping(false) {
+  if (numThreads == 0) {
+    numThreads = max<size_t>(1, thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < numThreads; ++i) {
+    workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+// Destructor
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  taskAvailable.notify_all();
+  for (auto& worker : workers) worker.join();
+}
+
+// Getter for the number of workers
+size_t ThreadPool::numThreads() const { return workers.size(); }
+
+// Queues a task
+void ThreadPool::submit(function<void()> task) {
+  {
+    lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(move(task));
+  }
+  taskAvailable.notify_one();
+}
+
+// Blocks until every submitted task has finished
+void ThreadPool::wait() {
+  unique_lock<std::mutex> lock(mutex);
+  allDone.wait(lock, [this]() { return tasks.empty() && running == 0; });
+}
+
+// Runs tasks until the pool is destroyed
+void ThreadPool::workerLoop() {
+  while (true) {
+    function<void()> task;
+    {
+      unique_lock<std::mutex> lock(mutex);
+      taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) return;  // Stopping and nothing left to do
+      task = move(tasks.front());
+      tasks.pop_front();
+      ++running;
+    }
+
+    task();
+
+    {
+      lock_guard<std::mutex> lock(mutex);
+      --running;
+      if (tasks.empty() && running == 0) allDone.notify_all();
+    }
+  }
+}
@@ -0,0 +1,240 @@
+#include "warm_decision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "decision_problem.h"
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+const PointPair kEmptyInterval(Point_2(-1, -1), Point_2(-1, -1));
+
+// Sides of a visited cell that are reachable
+const unsigned char kRightReachable = 1;
+const unsigned char kTopReachable = 2;
+
+// Returns true if the interval is empty
+bool isEmpty(const PointPair& interval) {
+  return interval.first == kEmptyInterval.first;
+}
+
+}  // namespace
+
+// Constructor to initialize with two curves
+WarmDecision::WarmDecision(const PolygonalCurve& P, const PolygonalCurve& Q,
+                           Workspace* workspace)
+    : P(P),
+      Q(Q),
+      feasibleEpsilon(numeric_limits<double>::infinity()),
+      infeasibleEpsilon(-1.0),
+      cells(workspace ? workspace->warmCells : ownCells),
+      flags(workspace ? workspace->warmFlags : ownFlags),
+      rows(workspace ? workspace->warmRows : ownRows),
+      corridor(workspace ? workspace->warmCorridor : ownCorridor),
+      marks(workspace ? workspace->warmMarks : ownMarks),
+      reachableBottom(workspace ? workspace->reachableBottom : ownBottom),
+      reachableTop(workspace ? workspace->reachableTop : ownTop) {
+  corridor.clear();
+}
+
+// Getter for the smallest feasible epsilon
+double WarmDecision::getFeasibleEpsilon() const { return feasibleEpsilon; }
+
+// Getter for the largest infeasible epsilon
+double WarmDecision::getInfeasibleEpsilon() const { return infeasibleEpsilon; }
+
+// Getter for the counters
+const DecisionStats& WarmDecision::getStats() const { return stats; }
+
+// Forgets the bracket and the corridor
+void WarmDecision::reset() {
+  feasibleEpsilon = numeric_limits<double>::infinity();
+  infeasibleEpsilon = -1.0;
+  corridor.clear();
+}
+
+// Decides if a monotone path exists at epsilon
+bool WarmDecision::decide(double epsilon) {
+  STATS_ADD(stats, decisionCalls, 1);
+
+  // The bracket answers without work
+  if (epsilon >= feasibleEpsilon) return true;
+  if (epsilon <= infeasibleEpsilon) return false;
+
+  bool feasible;
+  if (P.numPoints() < 2 || Q.numPoints() < 2) {
+    feasible = checkDegenerateCurve(epsilon);
+  } else {
+    STATS_TIMER(stats, reachabilitySeconds);
+    feasible = propagate(epsilon);
+    if (feasible) narrowCorridor();
+  }
+
+  if (feasible) {
+    feasibleEpsilon = epsilon;
+  } else {
+    infeasibleEpsilon = epsilon;
+  }
+  return feasible;
+}
+
+// Free interval of L on P edge i at Q vertex j
+PointPair WarmDecision::freeL(int i, int j, double epsilon) const {
+  double portions[2];
+  int result = FreeSpace::checkPointsOnEdge(P.getPoint(i), P.getPoint(i + 1),
+                                            Q.getPoint(j), epsilon, portions);
+  if (result == 0) return kEmptyInterval;
+  return {Point_2(j, i + portions[0]), Point_2(j, i + portions[result - 1])};
+}
+
+// Free interval of B at P vertex i on Q edge j
+PointPair WarmDecision::freeB(int i, int j, double epsilon) const {
+  double portions[2];
+  int result = FreeSpace::checkPointsOnEdge(Q.getPoint(j), Q.getPoint(j + 1),
+                                            P.getPoint(i), epsilon, portions);
+  if (result == 0) return kEmptyInterval;
+  return {Point_2(j + portions[0], i), Point_2(j + portions[result - 1], i)};
+}
+
+// Forward propagation, row by row as in the sparse DecisionProblem, but only
+// through the cells of the corridor that are reachable from the left or
+// from below
+bool WarmDecision::propagate(double epsilon) {
+  int p = P.numPoints();
+  int q = Q.numPoints();
+  bool restricted = !corridor.empty();
+  cells.clear();
+  flags.clear();
+  rows.assign(p, 0);
+
+  // Step 1: The bottom row is reachable while the free intervals are
+  // connected from (0, 0) to the right
+  reachableBottom.clear();
+  int last = restricted ? corridor[0].second : q - 2;
+  if (!restricted || corridor[0].first == 0) {
+    for (int j = 0; j <= last; ++j) {
+      PointPair b = freeB(0, j, epsilon);
+      STATS_ADD(stats, freeSpaceCells, 1);
+      if (isEmpty(b) || b.first.x() != j) break;
+      reachableBottom.push_back({j, b});
+      if (b.second.x() != j + 1) break;
+    }
+  }
+
+  // Step 2: Propagate row by row
+  bool leftColumn = true;  // Left boundary reachable up to the current row
+  bool endReached = false;
+  Point_2 end(q - 1, p - 1);
+  for (int i = 0; i < p - 1; ++i) {
+    rows[i] = cells.size();
+    int lo = restricted ? corridor[i].first : 0;
+    int hi = restricted ? corridor[i].second : q - 2;
+    reachableTop.clear();
+
+    // The left boundary of the row is reachable from the one below. Outside
+    // the corridor it cannot lie on a path, so it is dropped.
+    PointPair left = kEmptyInterval;
+    if (leftColumn && lo == 0) {
+      PointPair l = freeL(i, 0, epsilon);
+      STATS_ADD(stats, freeSpaceCells, 1);
+      if (!isEmpty(l) && l.first.y() == i) left = l;
+    }
+    leftColumn = !isEmpty(left) && left.second.y() == i + 1;
+
+    size_t b = 0;
+    while (b < reachableBottom.size() && reachableBottom[b].index < lo) ++b;
+    int j = lo;
+    if (isEmpty(left)) {
+      j = b < reachableBottom.size() ? reachableBottom[b].index : q;
+    }
+    while (j <= hi) {
+      const PointPair& bottom =
+          b < reachableBottom.size() && reachableBottom[b].index == j
+              ? reachableBottom[b++].interval
+              : kEmptyInterval;
+      PointPair freeRight = freeL(i, j + 1, epsilon);
+      PointPair freeTop = freeB(i + 1, j, epsilon);
+      STATS_ADD(stats, freeSpaceCells, 2);
+
+      PointPair right, top;
+      DecisionProblem::propagateCell(i, j, left, bottom, freeRight, freeTop,
+                                     right, top);
+      STATS_ADD(stats, reachabilityCells, 1);
+      unsigned char sides = 0;
+      if (!isEmpty(right)) sides |= kRightReachable;
+      if (!isEmpty(top)) {
+        sides |= kTopReachable;
+        reachableTop.push_back({j, top});
+      }
+      cells.push_back(j);
+      flags.push_back(sides);
+      if (i == p - 2 && j == q - 2) {
+        endReached = right.second == end || top.second == end;
+      }
+      left = right;
+      ++j;
+
+      // Skip to the next cell with a reachable bottom boundary
+      if (isEmpty(left)) {
+        j = b < reachableBottom.size() ? reachableBottom[b].index : q;
+      }
+    }
+    swap(reachableBottom, reachableTop);
+
+    // Nothing reaches the next row
+    if (reachableBottom.empty() && !leftColumn && i < p - 2) {
+      rows[p - 1] = cells.size();
+      return false;
+    }
+  }
+  rows[p - 1] = cells.size();
+  return endReached;
+}
+
+// Keeps, per row, the column range of the visited cells from which the last
+// cell is reachable through reachable sides. Every cell of a monotone path
+// at this or a smaller epsilon is one of them.
+void WarmDecision::narrowCorridor() {
+  int p = P.numPoints();
+  int q = Q.numPoints();
+  corridor.assign(p - 1, {q, -1});
+  marks.assign(2 * (q - 1), 0);
+  for (int i = p - 2; i >= 0; --i) {
+    char* current = marks.data() + (i % 2) * (q - 1);
+    char* above = marks.data() + ((i + 1) % 2) * (q - 1);
+    for (int k = rows[i + 1] - 1; k >= rows[i]; --k) {
+      int j = cells[k];
+      bool onPath = (i == p - 2 && j == q - 2) ||
+                    ((flags[k] & kRightReachable) && j < q - 2 &&
+                     current[j + 1]) ||
+                    ((flags[k] & kTopReachable) && i < p - 2 && above[j]);
+      if (!onPath) continue;
+      current[j] = 1;
+      corridor[i].first = j;
+      corridor[i].second = max(corridor[i].second, j);
+    }
+
+    // The marks of row i + 1 are no longer needed
+    if (i < p - 2) {
+      for (int k = rows[i + 1]; k < rows[i + 2]; ++k) above[cells[k]] = 0;
+    }
+  }
+}
+
+// Decides the case where one of the curves is a single point (as
+// DecisionProblem::checkDegenerateCurve)
+bool WarmDecision::checkDegenerateCurve(double epsilon) const {
+  if (P.numPoints() == 0 || Q.numPoints() == 0) return false;
+  const PolygonalCurve& point = P.numPoints() < 2 ? P : Q;
+  const PolygonalCurve& curve = P.numPoints() < 2 ? Q : P;
+  for (size_t i = 0; i < curve.numPoints(); ++i) {
+    double dx = curve.getPoint(i).x() - point.getPoint(0).x();
+    double dy = curve.getPoint(i).y() - point.getPoint(0).y();
+    if (sqrt(dx * dx + dy * dy) > epsilon) return false;
+  }
+  return true;
+}
@@ -0,0 +1,81 @@
+#include "weak_decision_problem.h"
+
+#include "union_find.h"
+#include "workspace.h"
+
+using namespace std;
+
+// Constructor to initialize with two curves and epsilon
+WeakDecisionProblem::WeakDecisionProblem(const PolygonalCurve& P,
+                                         const PolygonalCurve& Q,
+                                         double epsilon, Workspace* workspace)
+    : P(P),
+      Q(Q),
+      epsilon(epsilon),
+      freeSpace(P, Q, epsilon, workspace),
+      pathExists(false) {
+  vector<int>& parent = workspace ? workspace->weakParent : ownParent;
+
+  // A single point is matched to every vertex of the other curve
+  if (P.numPoints() < 2 || Q.numPoints() < 2) {
+    if (P.numPoints() == 0 || Q.numPoints() == 0) return;
+    const PolygonalCurve& point = P.numPoints() < 2 ? P : Q;
+    const PolygonalCurve& curve = P.numPoints() < 2 ? Q : P;
+    pathExists = true;
+    for (size_t i = 0; i < curve.numPoints(); ++i) {
+      double dx = curve.getPoint(i).x() - point.getPoint(0).x();
+      double dy = curve.getPoint(i).y() - point.getPoint(0).y();
+      pathExists = pathExists && dx * dx + dy * dy <= epsilon * epsilon;
+    }
+    return;
+  }
+
+  pathExists = isConnected(freeSpace, parent);
+}
+
+// Getter for the result
+bool WeakDecisionProblem::doesPathExist() const { return pathExists; }
+
+// Getter for epsilon
+double WeakDecisionProblem::getEpsilon() const { return epsilon; }
+
+// Checks if (0, 0) and (q-1, p-1) are connected in the free space. The free
+// space of a cell is convex, so two cells are connected iff their common
+// boundary has a free point.
+bool WeakDecisionProblem::isConnected(const FreeSpace& freeSpace,
+                                      vector<int>& parent) {
+  const PointPairVector& L = freeSpace.getL();
+  const PointPairVector& B = freeSpace.getB();
+  int p = freeSpace.getCurveP().numPoints();
+  int q = freeSpace.getCurveQ().numPoints();
+  Point_2 empty(-1, -1);
+
+  // Step 1: Check if (0, 0) and (q-1, p-1) are free
+  Point_2 start(0, 0);
+  Point_2 end(q - 1, p - 1);
+  if ((L.front().first != start && B.front().first != start) ||
+      (L.back().second != end && B.back().second != end)) {
+    return false;
+  }
+
+  // Step 2: Merge the cells (i, j) = i * (q - 1) + j across free inner
+  // boundaries
+  UnionFind cells(parent, (p - 1) * (q - 1));
+  for (int i = 0; i < p - 1; ++i) {
+    for (int j = 1; j < q - 1; ++j) {
+      if (L[i * q + j].first != empty) {
+        cells.unite(i * (q - 1) + j - 1, i * (q - 1) + j);
+      }
+    }
+  }
+  for (int j = 0; j < q - 1; ++j) {
+    for (int i = 1; i < p - 1; ++i) {
+      if (B[j * p + i].first != empty) {
+        cells.unite((i - 1) * (q - 1) + j, i * (q - 1) + j);
+      }
+    }
+  }
+
+  // Step 3: Check if the first and the last cell are connected
+  return cells.find(0) == cells.find((p - 1) * (q - 1) - 1);
+}
@@ -0,0 +1,93 @@
+#include "weak_fdistance.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "union_find.h"
+#include "workspace.h"
+
+using namespace std;
+
+// Constructor to compute the Type A and B critical values of P and Q
+WeakFDistance::WeakFDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                             Workspace* workspace)
+    : weakFDistance(-1.0) {
+  CriticalValue criticalVal(P, Q, workspace, false);
+  computeWeakFDistance(P, Q, criticalVal, workspace);
+}
+
+// Constructor to reuse computed critical values
+WeakFDistance::WeakFDistance(const PolygonalCurve& P, const PolygonalCurve& Q,
+                             const CriticalValue& criticalVal,
+                             Workspace* workspace)
+    : weakFDistance(-1.0) {
+  computeWeakFDistance(P, Q, criticalVal, workspace);
+}
+
+// Getter
+double WeakFDistance::getWeakFDistance() const { return weakFDistance; }
+
+// Adds the cell boundaries in increasing order of their Type B values until
+// the first and the last cell are connected
+void WeakFDistance::computeWeakFDistance(const PolygonalCurve& P,
+                                         const PolygonalCurve& Q,
+                                         const CriticalValue& criticalVal,
+                                         Workspace* workspace) {
+  int p = P.numPoints();
+  int q = Q.numPoints();
+  const vector<double>& typeA = criticalVal.getTypeAValues();
+  const vector<double>& typeB = criticalVal.getTypeBValues();
+
+  // Step 1: Both end points must be free
+  weakFDistance = max(typeA[0], typeA[1]);
+
+  // A single point is matched to every vertex of the other curve
+  if (p < 2 || q < 2) {
+    const PolygonalCurve& point = p < 2 ? P : Q;
+    const PolygonalCurve& curve = p < 2 ? Q : P;
+    for (size_t i = 0; i < curve.numPoints(); ++i) {
+      double dx = curve.getPoint(i).x() - point.getPoint(0).x();
+      double dy = curve.getPoint(i).y() - point.getPoint(0).y();
+      weakFDistance = max(weakFDistance, sqrt(dx * dx + dy * dy));
+    }
+    return;
+  }
+
+  // Step 2: Sort the boundaries by their Type B values. The first p * (q-1)
+  // values belong to B[j*p+i] (horizontal, at index i * (q-1) + j), the
+  // others to L[j*q+i] (vertical, at index p * (q-1) + i * (p-1) + j).
+  vector<int>& order = workspace ? workspace->weakOrder : ownOrder;
+  vector<int>& parent = workspace ? workspace->weakParent : ownParent;
+  order.resize(typeB.size());
+  for (size_t k = 0; k < order.size(); ++k) order[k] = static_cast<int>(k);
+  sort(order.begin(), order.end(),
+       [&typeB](int a, int b) { return typeB[a] < typeB[b]; });
+
+  // Step 3: Merge the cells (i, j) = i * (q - 1) + j across the inner
+  // boundaries until the first and the last cell are connected
+  UnionFind cells(parent, (p - 1) * (q - 1));
+  int first = 0;
+  int last = (p - 1) * (q - 1) - 1;
+  int horizontal = p * (q - 1);
+  double bottleneck = 0.0;
+  for (size_t k = 0; k < order.size() && cells.find(first) != cells.find(last);
+       ++k) {
+    int index = order[k];
+    if (index < horizontal) {
+      // P vertex i against Q edge j, between cells (i - 1, j) and (i, j)
+      int i = index / (q - 1);
+      int j = index % (q - 1);
+      if (i == 0 || i == p - 1) continue;
+      cells.unite((i - 1) * (q - 1) + j, i * (q - 1) + j);
+    } else {
+      // Q vertex i against P edge j, between cells (j, i - 1) and (j, i)
+      int i = (index - horizontal) / (p - 1);
+      int j = (index - horizontal) % (p - 1);
+      if (i == 0 || i == q - 1) continue;
+      cells.unite(j * (q - 1) + i - 1, j * (q - 1) + i);
+    }
+    bottleneck = typeB[index];
+  }
+
+  weakFDistance = max(weakFDistance, bottleneck);
+}
@@ -0,0 +1,96 @@
+#include "workspace.h"
+
+using namespace std;
+
+namespace {
+
+// Bytes reserved by a vector
+template <typename T>
+size_t vectorBytes(const vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+
+// Frees the memory of a vector
+template <typename T>
+void releaseVector(vector<T>& v) {
+  vector<T>().swap(v);
+}
+
+}  // namespace
+
+// Constructor: seeds the generator of the grid shifts
+Workspace::Workspace() : generator(random_device()()) {}
+
+// Constructor: seeds the generator of the grid shifts with a fixed seed
+Workspace::Workspace(uint32_t seed) : generator(seed) {}
+
+// Bytes currently reserved by all buffers (the curves and the bit-parallel
+// query are not counted)
+size_t Workspace::capacityBytes() const {
+  return vectorBytes(typeAValues) + vectorBytes(typeBValues) +
+         vectorBytes(typeCValues) + vectorBytes(criticalValues) +
+         vectorBytes(freeSpaceL) + vectorBytes(freeSpaceB) +
+         vectorBytes(reachableL) + vectorBytes(reachableB) +
+         gridP.capacityBytes() + gridQ.capacityBytes() +
+         vectorBytes(sparseL) + vectorBytes(sparseB) +
+         vectorBytes(sparseRowsL) + vectorBytes(sparseRowsB) +
+         vectorBytes(sparseScratch) + vectorBytes(gridCandidates) +
+         vectorBytes(reachableBottom) + vectorBytes(reachableTop) +
+         vectorBytes(warmCells) + vectorBytes(warmFlags) +
+         vectorBytes(warmRows) + vectorBytes(warmCorridor) +
+         vectorBytes(warmMarks) +
+         vectorBytes(hausdorffBounds) + vectorBytes(hausdorffFeatures) +
+         vectorBytes(dtwCosts) + vectorBytes(dtwRows) +
+         vectorBytes(dtwEnvelope) + vectorBytes(dtwBounds) +
+         vectorBytes(dtwDeque) + vectorBytes(weakOrder) +
+         vectorBytes(weakParent) + vectorBytes(stringP) +
+         vectorBytes(stringQ) + vectorBytes(matching) +
+         vectorBytes(bestMatching) + vectorBytes(sedTable) +
+         vectorBytes(sedDiagonals) + vectorBytes(sedColumns) +
+         vectorBytes(gedRows);
+}
+
+// Releases the memory of all buffers
+void Workspace::release() {
+  releaseVector(typeAValues);
+  releaseVector(typeBValues);
+  releaseVector(typeCValues);
+  releaseVector(criticalValues);
+  releaseVector(freeSpaceL);
+  releaseVector(freeSpaceB);
+  releaseVector(reachableL);
+  releaseVector(reachableB);
+  gridP.release();
+  gridQ.release();
+  releaseVector(sparseL);
+  releaseVector(sparseB);
+  releaseVector(sparseRowsL);
+  releaseVector(sparseRowsB);
+  releaseVector(sparseScratch);
+  releaseVector(gridCandidates);
+  releaseVector(reachableBottom);
+  releaseVector(reachableTop);
+  releaseVector(warmCells);
+  releaseVector(warmFlags);
+  releaseVector(warmRows);
+  releaseVector(warmCorridor);
+  releaseVector(warmMarks);
+  releaseVector(hausdorffBounds);
+  releaseVector(hausdorffFeatures);
+  releaseVector(dtwCosts);
+  releaseVector(dtwRows);
+  releaseVector(dtwEnvelope);
+  releaseVector(dtwBounds);
+  releaseVector(dtwDeque);
+  releaseVector(weakOrder);
+  releaseVector(weakParent);
+  releaseVector(stringP);
+  releaseVector(stringQ);
+  releaseVector(matching);
+  releaseVector(bestMatching);
+  releaseVector(sedTable);
+  releaseVector(gedRows);
+  releaseVector(sedDiagonals);
+  releaseVector(sedColumns);
+  bitParallel = BitParallelSED();
+}
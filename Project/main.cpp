@@ -5,12 +5,16 @@
 #include <limits>
 #include <random>
 
+#include "batch_driver.h"
 #include "critical_value.h"
 #include "decision_problem.h"
+#include "distance_cache.h"
+#include "distance_matrix.h"
 #include "fdistance.h"
 #include "free_space.h"
 #include "ged.h"
 #include "polygonal_curve.h"
+#include "similarity_join.h"
 
 using namespace std;
 
@@ -63,7 +67,96 @@ vector<Point_2> generateRandomPoints(size_t numPoints, double minCoord,
   return points;
 }
 
-int main(int, char**) {
+// Runs "Project3 batch --store <curves> --pairs <pairs> --out <output>
+// [--metric fd|weak-fd|hausdorff|dtw|ged|threshold] [--epsilon e]
+// [--window w] [--format csv|bin] [--free-space dense|sparse] [--threads n]
+// [--chunk n] [--cache path]"
+int runBatchCommand(int argc, char** argv) {
+  try {
+    BatchOptions options = parseBatchArguments(argc, argv);
+    DistanceCacheStats cache;
+    size_t numPairs = runBatch(options, &cache);
+    cerr << "Processed " << numPairs << " pairs." << '\n';
+    if (!options.cachePath.empty()) {
+      cerr << "Cache: " << cache.memoryHits << " memory hits, "
+           << cache.diskHits << " disk hits, " << cache.misses
+           << " misses." << '\n';
+    }
+  } catch (const exception& e) {
+    cerr << "batch: " << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+// Runs "Project3 matrix --store <curves> --out <output>
+// [--metric fd|weak-fd|hausdorff|dtw|ged|threshold] [--output
+// dense|top-k|threshold] [--k k] [--epsilon e] [--window w] [--tile n]
+// [--threads n] [--journal path] [--free-space dense|sparse] [--symmetric]
+// [--seed s] [--restart] [--shards n [--shard s | --launch | --merge]]"
+int runMatrixCommand(int argc, char** argv) {
+  try {
+    // --launch runs all shards here, --merge joins finished shards
+    bool launch = false, merge = false;
+    vector<string> arguments = {"matrix"};
+    vector<char*> rest;
+    for (int i = 0; i < argc; ++i) {
+      string flag = argv[i];
+      if (flag == "--launch" || flag == "--merge") {
+        (flag == "--launch" ? launch : merge) = true;
+        continue;
+      }
+      arguments.push_back(flag);
+      rest.push_back(argv[i]);
+    }
+
+    MatrixOptions options = parseMatrixArguments(rest.size(), rest.data());
+    MatrixProgress progress =
+        launch  ? runLocalShards(options, "/proc/self/exe", arguments)
+        : merge ? mergeMatrixShards(options)
+                : runMatrix(options);
+    cerr << "Computed " << progress.computedTiles << " of "
+         << progress.numTiles << " tiles of " << progress.tileSize
+         << " curves (" << progress.resumedTiles << " resumed)." << '\n';
+  } catch (const exception& e) {
+    cerr << "matrix: " << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+// Runs "Project3 join --a <curves> [--b <curves>] --epsilon e --out <pairs>
+// [--free-space dense|sparse] [--threads n] [--partition n]"
+int runJoinCommand(int argc, char** argv) {
+  try {
+    JoinOptions options = parseJoinArguments(argc, argv);
+    JoinStats stats = runJoin(options);
+    cerr << "Found " << stats.matches << " pairs from "
+         << stats.gridCandidates << " grid candidates (" << stats.decisions
+         << " decisions)." << '\n';
+  } catch (const exception& e) {
+    cerr << "join: " << e.what() << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  // Batch mode over a curve file and a pair list
+  if (argc > 1 && string(argv[1]) == "batch") {
+    return runBatchCommand(argc - 2, argv + 2);
+  }
+
+  // All-pairs matrix of a curve file
+  if (argc > 1 && string(argv[1]) == "matrix") {
+    return runMatrixCommand(argc - 2, argv + 2);
+  }
+
+  // Pairs of two curve files within epsilon
+  if (argc > 1 && string(argv[1]) == "join") {
+    return runJoinCommand(argc - 2, argv + 2);
+  }
+
   // Define multiple sets of points for testing
 
   // Test Case 1: Simple linear curves
@@ -0,0 +1,602 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "batch_driver.h"
+#include "critical_value.h"
+#include "curve_file.h"
+#include "curve_store.h"
+#include "decision_problem.h"
+#include "distance_matrix.h"
+#include "fdistance.h"
+#include "frechet_clustering.h"
+#include "polygonal_curve.h"
+#include "small_frechet.h"
+#include "subtrajectory_search.h"
+#include "workspace.h"
+
+using namespace std;
+
+// Regression tests. Every case compares an optimized engine with a reference
+// on seeded random curves and prints the first mismatches it finds.
+// `Regression <case>` runs one case (CTest registers each one as a test);
+// without arguments all cases run.
+
+// Seed of all generators
+const unsigned kSeed = 20240601;
+
+// Random walk with unit normal steps
+vector<Point_2> generateRandomWalk(size_t numPoints, mt19937& gen) {
+  normal_distribution<> step(0.0, 1.0);
+  vector<Point_2> points;
+  double x = 0.0, y = 0.0;
+  for (size_t i = 0; i < numPoints; ++i) {
+    points.emplace_back(x, y);
+    x += step(gen);
+    y += step(gen);
+  }
+  return points;
+}
+
+// Zigzag between offset and offset + amplitude
+vector<Point_2> generateZigzag(size_t numPoints, double offset,
+                               double amplitude) {
+  vector<Point_2> points;
+  for (size_t i = 0; i < numPoints; ++i) {
+    double y = (i % 2 == 0) ? offset : offset + amplitude;
+    points.emplace_back(static_cast<double>(i), y);
+  }
+  return points;
+}
+
+// Pairs of curves of all test families: random walks of mixed sizes
+// (including single points), zigzags and a pair of equal curves
+vector<pair<PolygonalCurve, PolygonalCurve>> generatePairs(size_t count,
+                                                           size_t maxSize,
+                                                           mt19937& gen) {
+  uniform_int_distribution<size_t> size(1, maxSize);
+  vector<pair<PolygonalCurve, PolygonalCurve>> pairs;
+  for (size_t r = 0; r < count; ++r) {
+    pairs.emplace_back(PolygonalCurve(generateRandomWalk(size(gen), gen)),
+                       PolygonalCurve(generateRandomWalk(size(gen), gen)));
+  }
+  pairs.emplace_back(PolygonalCurve(generateZigzag(maxSize, 0.0, 2.0)),
+                     PolygonalCurve(generateZigzag(maxSize, 1.0, -2.0)));
+  vector<Point_2> walk = generateRandomWalk(maxSize, gen);
+  pairs.emplace_back(PolygonalCurve(walk), PolygonalCurve(walk));
+  return pairs;
+}
+
+// Counts and reports the mismatches of a case
+class Mismatches {
+ public:
+  explicit Mismatches(const string& name) : name(name), count(0) {}
+
+  // Records a mismatch; only the first few are printed
+  void report(const string& what) {
+    if (count++ < 5) cerr << name << ": " << what << endl;
+  }
+
+  // Prints the summary; returns the exit code of the case
+  int result(size_t checks) const {
+    cout << name << ": " << checks << " checks, " << count << " mismatches"
+         << endl;
+    return count == 0 ? 0 : 1;
+  }
+
+ private:
+  string name;
+  size_t count;
+};
+
+// [Sparse decision] The sparse free space decides like the dense one, at
+// the Frechet distance itself and around it
+int testSparseDecision() {
+  Mismatches mismatches("sparse_decision");
+  mt19937 gen(kSeed);
+  Workspace workspace(kSeed);
+  size_t checks = 0;
+  for (const auto& curves : generatePairs(200, 40, gen)) {
+    const PolygonalCurve& P = curves.first;
+    const PolygonalCurve& Q = curves.second;
+    double distance = FDistance(P, Q).getFDistance();
+    for (double factor : {0.0, 0.5, 0.999, 1.0, 1.001, 2.0}) {
+      double epsilon = distance * factor;
+      bool dense = DecisionProblem(P, Q, epsilon).doesMonotoneCurveExist();
+      bool sparse = DecisionProblem(P, Q, epsilon, nullptr,
+                                    FreeSpaceMode::Sparse)
+                        .doesMonotoneCurveExist();
+      bool reused = DecisionProblem(P, Q, epsilon, &workspace,
+                                    FreeSpaceMode::Sparse)
+                        .doesMonotoneCurveExist();
+      checks += 2;
+      if (sparse != dense || reused != dense) {
+        mismatches.report("sizes " + to_string(P.numPoints()) + "x" +
+                          to_string(Q.numPoints()) + ", epsilon " +
+                          to_string(epsilon) + ": dense " +
+                          to_string(dense) + ", sparse " + to_string(sparse) +
+                          ", sparse with workspace " + to_string(reused));
+      }
+    }
+  }
+  return mismatches.result(checks);
+}
+
+// Point of Q at a position (vertex index plus edge fraction)
+Point_2 pointAt(const PolygonalCurve& Q, double position) {
+  size_t i = static_cast<size_t>(position);
+  if (i + 1 >= Q.numPoints()) return Q.getPoint(Q.numPoints() - 1);
+  double t = position - i;
+  Point_2 a = Q.getPoint(i), b = Q.getPoint(i + 1);
+  return Point_2(a.x() + t * (b.x() - a.x()), a.y() + t * (b.y() - a.y()));
+}
+
+// Portion Q[start, end] as a curve of its own
+PolygonalCurve subcurve(const PolygonalCurve& Q, double start, double end) {
+  vector<Point_2> points = {pointAt(Q, start)};
+  for (size_t k = static_cast<size_t>(start) + 1; k < end; ++k) {
+    points.push_back(Q.getPoint(k));
+  }
+  points.push_back(pointAt(Q, end));
+  return PolygonalCurve(points);
+}
+
+// [Subtrajectory search] Every match is within epsilon of P, no match
+// contains another, and every portion between two vertices of Q that is
+// within epsilon (brute force over all of them) lies inside a match
+int testSubtrajectorySearch() {
+  Mismatches mismatches("subtrajectory_search");
+  mt19937 gen(kSeed);
+  uniform_int_distribution<size_t> sizeP(1, 5), sizeQ(2, 30);
+  normal_distribution<> noise(0.0, 0.3);
+  const double tolerance = 1e-9;
+  size_t checks = 0;
+  for (int r = 0; r < 150; ++r) {
+    PolygonalCurve Q(generateRandomWalk(sizeQ(gen), gen));
+    // P follows a piece of Q with noise, so most queries have matches
+    vector<Point_2> pointsP;
+    uniform_int_distribution<size_t> vertexQ(0, Q.numPoints() - 1);
+    size_t first = vertexQ(gen);
+    for (size_t i = 0, n = sizeP(gen); i < n; ++i) {
+      Point_2 q = Q.getPoint(min(first + i, Q.numPoints() - 1));
+      pointsP.emplace_back(q.x() + noise(gen), q.y() + noise(gen));
+    }
+    PolygonalCurve P(pointsP);
+    double epsilon = (r % 3 + 1) * 0.5;
+    string label = "query " + to_string(r) + ", ";
+
+    vector<SubtrajectoryMatch> matches = findSubtrajectories(P, Q, epsilon);
+    for (size_t m = 0; m < matches.size(); ++m) {
+      const SubtrajectoryMatch& match = matches[m];
+      PolygonalCurve portion = subcurve(Q, match.start, match.end);
+      double distance = FDistance(P, portion).getFDistance();
+      ++checks;
+      if (match.start > match.end || distance > epsilon + tolerance) {
+        mismatches.report(label + "match [" + to_string(match.start) + ", " +
+                          to_string(match.end) + "] is at distance " +
+                          to_string(distance));
+      }
+      for (size_t other = 0; other < matches.size(); ++other) {
+        ++checks;
+        if (other != m && matches[other].start <= match.start &&
+            match.end <= matches[other].end) {
+          mismatches.report(label + "match " + to_string(m) +
+                            " is contained in match " + to_string(other));
+        }
+      }
+    }
+
+    for (size_t i = 0; i < Q.numPoints(); ++i) {
+      for (size_t j = i; j < Q.numPoints(); ++j) {
+        PolygonalCurve portion = subcurve(Q, i, j);
+        if (!DecisionProblem(P, portion, epsilon).doesMonotoneCurveExist()) {
+          continue;
+        }
+        bool covered = false;
+        for (const SubtrajectoryMatch& match : matches) {
+          covered |= match.start <= i + tolerance && j <= match.end + tolerance;
+        }
+        ++checks;
+        if (!covered) {
+          mismatches.report(label + "portion [" + to_string(i) + ", " +
+                            to_string(j) + "] is in no match");
+        }
+      }
+    }
+  }
+  return mismatches.result(checks);
+}
+
+// Frechet distance without warm starts: binary search for the smallest
+// critical value that a fresh DecisionProblem accepts
+double coldFrechetDistance(const PolygonalCurve& P, const PolygonalCurve& Q) {
+  vector<double> values = CriticalValue(P, Q).getCriticalValues();
+  size_t left = 0, right = values.size();
+  while (left < right) {
+    size_t mid = left + (right - left) / 2;
+    if (DecisionProblem(P, Q, values[mid]).doesMonotoneCurveExist()) {
+      right = mid;
+    } else {
+      left = mid + 1;
+    }
+  }
+  return left < values.size() ? values[left] : -1.0;
+}
+
+// [Warm start] FDistance with its warm-started decisions returns the
+// distance of a cold search, also when one workspace carries the corridor
+// buffers from pair to pair
+int testWarmStart() {
+  Mismatches mismatches("warm_start");
+  mt19937 gen(kSeed);
+  Workspace workspace(kSeed);
+  size_t checks = 0;
+  for (const auto& curves : generatePairs(300, 40, gen)) {
+    const PolygonalCurve& P = curves.first;
+    const PolygonalCurve& Q = curves.second;
+    if (P.numPoints() < 2 || Q.numPoints() < 2) continue;
+    double cold = coldFrechetDistance(P, Q);
+    double warm = FDistance(P, Q).getFDistance();
+    double reused = FDistance(P, Q, &workspace).getFDistance();
+    checks += 2;
+    if (warm != cold || reused != cold) {
+      mismatches.report("sizes " + to_string(P.numPoints()) + "x" +
+                        to_string(Q.numPoints()) + ": cold " +
+                        to_string(cold) + ", warm " + to_string(warm) +
+                        ", warm with workspace " + to_string(reused));
+    }
+  }
+  return mismatches.result(checks);
+}
+
+// Eager Gonzalez: FDistance from every curve to every new center; ties go
+// to the largest id like in gonzalezKCenter
+ClusteringResult eagerGonzalez(const vector<PolygonalCurve>& curves,
+                               size_t k, size_t firstCenter) {
+  ClusteringResult result;
+  vector<double> nearest(curves.size(), 0.0);
+  vector<char> isCenter(curves.size(), 0);
+  size_t next = firstCenter;
+  while (true) {
+    result.centers.push_back(next);
+    isCenter[next] = 1;
+    for (size_t i = 0; i < curves.size(); ++i) {
+      double distance = FDistance(curves[i], curves[next]).getFDistance();
+      if (result.centers.size() == 1 || distance < nearest[i]) {
+        nearest[i] = distance;
+      }
+    }
+    next = curves.size();
+    for (size_t i = 0; i < curves.size(); ++i) {
+      if (isCenter[i]) continue;
+      if (next == curves.size() || nearest[i] >= nearest[next]) next = i;
+    }
+    if (next == curves.size()) break;
+    if (result.centers.size() == k) {
+      result.radius = nearest[next];
+      break;
+    }
+  }
+  return result;
+}
+
+// [Lazy clustering] gonzalezKCenter picks the centers of the eager
+// algorithm and its radius, and every curve is within its upper bound of
+// its center
+int testLazyGonzalez() {
+  Mismatches mismatches("lazy_gonzalez");
+  mt19937 gen(kSeed);
+  uniform_int_distribution<size_t> size(1, 20);
+  CurveStore store;
+  vector<PolygonalCurve> curves;
+  for (size_t i = 0; i < 60; ++i) {
+    curves.emplace_back(generateRandomWalk(size(gen), gen));
+    store.addCurve(curves.back());
+  }
+  // Equal curves make equal distances
+  for (size_t i = 0; i < 4; ++i) {
+    curves.push_back(curves[i]);
+    store.addCurve(curves.back());
+  }
+
+  const double tolerance = 1e-9;
+  size_t checks = 0;
+  for (size_t k : {1, 2, 5, 12, 64, 100}) {
+    for (size_t firstCenter : {0, 17}) {
+      ClusteringOptions options;
+      options.k = k;
+      options.firstCenter = firstCenter;
+      options.numThreads = 2;
+      ClusteringResult lazy = gonzalezKCenter(store, options);
+      ClusteringResult eager = eagerGonzalez(curves, k, firstCenter);
+      string label = "k " + to_string(k) + ", first " +
+                     to_string(firstCenter) + ": ";
+
+      checks += 2;
+      if (lazy.centers != eager.centers) {
+        mismatches.report(label + to_string(lazy.centers.size()) +
+                          " lazy centers differ from " +
+                          to_string(eager.centers.size()) + " eager ones");
+      }
+      if (lazy.radius != eager.radius) {
+        mismatches.report(label + "lazy radius " + to_string(lazy.radius) +
+                          ", eager radius " + to_string(eager.radius));
+      }
+      for (size_t i = 0; i < curves.size(); ++i) {
+        size_t center = lazy.centers[lazy.assignment[i]];
+        double distance =
+            FDistance(curves[i], curves[center]).getFDistance();
+        ++checks;
+        if (distance > lazy.upperBounds[i] + tolerance ||
+            lazy.upperBounds[i] > lazy.radius + tolerance) {
+          mismatches.report(label + "curve " + to_string(i) +
+                            " is at distance " + to_string(distance) +
+                            " of its center, bound " +
+                            to_string(lazy.upperBounds[i]));
+        }
+      }
+    }
+  }
+  return mismatches.result(checks);
+}
+
+// Runs SmallFrechet<N> on random pairs of at most N points, in one call so
+// that the groups mix sizes and the last group is partial
+template <int N>
+void checkSmallFrechet(mt19937& gen, Mismatches& mismatches, size_t& checks) {
+  uniform_int_distribution<size_t> size(1, N);
+  vector<PolygonalCurve> curvesP, curvesQ;
+  for (size_t r = 0; r < 201; ++r) {
+    curvesP.emplace_back(generateRandomWalk(size(gen), gen));
+    curvesQ.emplace_back(generateRandomWalk(size(gen), gen));
+  }
+  curvesP.emplace_back(generateZigzag(N, 0.0, 2.0));
+  curvesQ.emplace_back(generateZigzag(N, 1.0, -2.0));
+  curvesP.push_back(curvesQ.front());
+  curvesQ.push_back(curvesQ.front());
+
+  size_t count = curvesP.size();
+  vector<CurveView> viewsP, viewsQ;
+  for (size_t r = 0; r < count; ++r) {
+    viewsP.push_back(curvesP[r].view());
+    viewsQ.push_back(curvesQ[r].view());
+  }
+  unique_ptr<SmallFrechet<N>> engine(new SmallFrechet<N>());
+  vector<double> distances(count);
+  engine->distance(viewsP.data(), viewsQ.data(), distances.data(), count);
+
+  vector<double> expected(count);
+  for (size_t r = 0; r < count; ++r) {
+    expected[r] = FDistance(curvesP[r], curvesQ[r]).getFDistance();
+    ++checks;
+    if (distances[r] != expected[r]) {
+      mismatches.report("N " + to_string(N) + ", pair " + to_string(r) +
+                        ": SmallFrechet " + to_string(distances[r]) +
+                        ", FDistance " + to_string(expected[r]));
+    }
+  }
+
+  for (double factor : {0.5, 0.999, 1.0, 1.001}) {
+    vector<double> epsilons(count);
+    for (size_t r = 0; r < count; ++r) epsilons[r] = expected[r] * factor;
+    unique_ptr<bool[]> decisions(new bool[count]);
+    engine->decide(viewsP.data(), viewsQ.data(), epsilons.data(),
+                   decisions.get(), count);
+    for (size_t r = 0; r < count; ++r) {
+      bool reference = DecisionProblem(curvesP[r], curvesQ[r], epsilons[r])
+                           .doesMonotoneCurveExist();
+      ++checks;
+      if (decisions[r] != reference) {
+        mismatches.report("N " + to_string(N) + ", pair " + to_string(r) +
+                          ", epsilon " + to_string(epsilons[r]) +
+                          ": SmallFrechet " + to_string(decisions[r]) +
+                          ", DecisionProblem " + to_string(reference));
+      }
+    }
+  }
+}
+
+// [Small curves] SmallFrechet returns the distances of FDistance and the
+// decisions of DecisionProblem
+int testSmallFrechet() {
+  Mismatches mismatches("small_frechet");
+  mt19937 gen(kSeed);
+  size_t checks = 0;
+  checkSmallFrechet<2>(gen, mismatches, checks);
+  checkSmallFrechet<5>(gen, mismatches, checks);
+  checkSmallFrechet<kSmallCurveMaxPoints>(gen, mismatches, checks);
+  return mismatches.result(checks);
+}
+
+// Entries of a dense matrix file
+vector<double> readDenseMatrix(const string& path) {
+  ifstream in(path, ios::binary);
+  MatrixFileHeader header;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  vector<double> entries(header.numRows * header.numColumns);
+  in.seekg(header.dataOffset);
+  in.read(reinterpret_cast<char*>(entries.data()),
+          entries.size() * sizeof(double));
+  return entries;
+}
+
+// Records of a sparse matrix file, sorted by idP and idQ
+vector<BatchRecord> readSparseMatrix(const string& path) {
+  ifstream in(path, ios::binary);
+  vector<BatchRecord> records;
+  BatchRecord record;
+  while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+    records.push_back(record);
+  }
+  sort(records.begin(), records.end(),
+       [](const BatchRecord& a, const BatchRecord& b) {
+         return a.idP != b.idP ? a.idP < b.idP : a.idQ < b.idQ;
+       });
+  return records;
+}
+
+// Simulates an interruption after the first kept units of a journal: later
+// lines are dropped and a torn line is appended. Returns the tile ids kept.
+vector<size_t> interruptJournal(const string& path, size_t kept) {
+  ifstream in(path);
+  string header, line;
+  getline(in, header);
+  vector<string> lines;
+  vector<size_t> tiles;
+  while (lines.size() < kept && getline(in, line)) {
+    lines.push_back(line);
+    tiles.push_back(stoull(line));
+  }
+  in.close();
+  ofstream out(path, ios::trunc);
+  out << header << "\n";
+  for (const string& entry : lines) out << entry << "\n";
+  out << "63 1";  // No newline: the unit was not complete
+  return tiles;
+}
+
+// Overwrites the entries of a dense matrix file with NaN, except those of
+// the kept tiles (and their mirrors in symmetric runs)
+void poisonDenseMatrix(const string& path, const vector<size_t>& tiles,
+                       size_t tileSize, bool symmetric) {
+  vector<double> entries = readDenseMatrix(path);
+  size_t n = static_cast<size_t>(sqrt(static_cast<double>(entries.size())));
+  size_t numBands = (n + tileSize - 1) / tileSize;
+  vector<char> keep(entries.size(), 0);
+  for (size_t tile : tiles) {
+    size_t band = tile / numBands, c = tile % numBands;
+    for (size_t i = band * tileSize; i < min(n, (band + 1) * tileSize); ++i) {
+      for (size_t j = c * tileSize; j < min(n, (c + 1) * tileSize); ++j) {
+        keep[i * n + j] = 1;
+        if (symmetric) keep[j * n + i] = 1;
+      }
+    }
+  }
+  fstream file(path, ios::in | ios::out | ios::binary);
+  MatrixFileHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  double poison = numeric_limits<double>::quiet_NaN();
+  for (size_t k = 0; k < entries.size(); ++k) {
+    if (keep[k]) continue;
+    file.seekp(header.dataOffset + k * sizeof(double));
+    file.write(reinterpret_cast<const char*>(&poison), sizeof(poison));
+  }
+}
+
+// [Matrix resume] A run interrupted after some tiles resumes from its
+// journal, computes only the other tiles and writes the matrix of a fresh
+// run (the files go to the working directory)
+int testMatrixResume() {
+  Mismatches mismatches("matrix_resume");
+  const string storePath = "regression_matrix.curves";
+  const string freshPath = "regression_matrix.fresh";
+  const string resumedPath = "regression_matrix.resumed";
+  mt19937 gen(kSeed);
+  uniform_int_distribution<size_t> size(1, 12);
+  {
+    CurveFileWriter writer(storePath);
+    for (size_t i = 0; i < 37; ++i) {
+      writer.addCurve(generateRandomWalk(size(gen), gen));
+    }
+    writer.close();
+  }
+
+  const size_t kept = 7;
+  size_t checks = 0;
+  for (MatrixOutput output : {MatrixOutput::Dense, MatrixOutput::Threshold}) {
+    for (bool symmetric : {false, true}) {
+      MatrixOptions options;
+      options.storePath = storePath;
+      options.output = output;
+      options.epsilon = 3.0;
+      options.symmetric = symmetric;
+      options.tileSize = 5;
+      options.numThreads = 2;
+      options.outputPath = freshPath;
+      options.resume = false;
+      runMatrix(options);
+
+      // The resumed run continues a complete run whose journal lost all
+      // but its first units and whose other tiles were lost
+      options.outputPath = resumedPath;
+      MatrixProgress full = runMatrix(options);
+      string journalPath = resumedPath + ".journal";
+      vector<size_t> tiles = interruptJournal(journalPath, kept);
+      if (output == MatrixOutput::Dense) {
+        poisonDenseMatrix(resumedPath, tiles, full.tileSize, symmetric);
+      } else {
+        // A record of an unfinished tile past the journaled prefix
+        BatchRecord stray{0, 0, -1.0};
+        ofstream(resumedPath, ios::app | ios::binary)
+            .write(reinterpret_cast<const char*>(&stray), sizeof(stray));
+      }
+      options.resume = true;
+      MatrixProgress resumed = runMatrix(options);
+
+      string label = output == MatrixOutput::Dense ? "dense" : "sparse";
+      label += symmetric ? " symmetric: " : ": ";
+      checks += 2;
+      if (resumed.resumedTiles != kept ||
+          resumed.computedTiles != full.numTiles - kept) {
+        mismatches.report(label + to_string(resumed.resumedTiles) +
+                          " tiles resumed and " +
+                          to_string(resumed.computedTiles) + " computed");
+      }
+      bool equal;
+      if (output == MatrixOutput::Dense) {
+        equal = readDenseMatrix(freshPath) == readDenseMatrix(resumedPath);
+      } else {
+        vector<BatchRecord> a = readSparseMatrix(freshPath);
+        vector<BatchRecord> b = readSparseMatrix(resumedPath);
+        equal = a.size() == b.size() && !a.empty();
+        for (size_t r = 0; equal && r < a.size(); ++r) {
+          equal = a[r].idP == b[r].idP && a[r].idQ == b[r].idQ &&
+                  a[r].value == b[r].value;
+        }
+      }
+      if (!equal) mismatches.report(label + "resumed output differs");
+    }
+  }
+
+  for (const string& path : {storePath, freshPath, freshPath + ".journal",
+                             resumedPath, resumedPath + ".journal"}) {
+    remove(path.c_str());
+  }
+  return mismatches.result(checks);
+}
+
+// Runs the named case, or all of them
+int main(int argc, char** argv) {
+  vector<pair<string, function<int()>>> cases = {
+      {"sparse_decision", testSparseDecision},
+      {"subtrajectory_search", testSubtrajectorySearch},
+      {"warm_start", testWarmStart},
+      {"lazy_gonzalez", testLazyGonzalez},
+      {"small_frechet", testSmallFrechet},
+      {"matrix_resume", testMatrixResume},
+  };
+
+  string selected = argc > 1 ? argv[1] : "";
+  bool found = false;
+  int failures = 0;
+  for (const auto& testCase : cases) {
+    if (!selected.empty() && testCase.first != selected) continue;
+    found = true;
+    failures += testCase.second();
+  }
+  if (!found) {
+    cerr << "Unknown test case " << selected << "." << endl;
+    return 1;
+  }
+  return failures == 0 ? 0 : 1;
+}